@@ -33,6 +33,7 @@
 
 #include "frameresource.h"
 #include "input.h"
+#include "jobsystem.h"
 
 /************************************************************************************
  *
@@ -96,6 +97,12 @@ bool frameInitialise()
 		return false;
 	}
 
+	// Start the worker threads
+	if (!jobSystemInitialise())
+	{
+		return false;
+	}
+
 	return true;
 }
 
@@ -126,6 +133,8 @@ void frameShutDown()
 	// Shutdown the resource stuff
 	debug(LOG_NEVER, "No more resources!");
 	resShutDown();
+
+	jobSystemShutdown();
 }
 
 void setMouseWarp(bool value)
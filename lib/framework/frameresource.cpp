@@ -29,6 +29,15 @@
 
 #include "file.h"
 #include "resly.h"
+#include "wzapp.h"
+#include "jobsystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#define MAX_PRELOAD_AHEAD	16	///< Preload jobs submitted ahead of the file being loaded, which bounds how much preloaded data waits around.
 
 // Local prototypes
 static RES_TYPE *psResTypes = nullptr;
@@ -42,10 +51,25 @@ static SDWORD resBlockID;
 
 // prototypes
 static void ResetResourceFile();
+static bool resLoadQueue();
 
 // callback to resload screen.
 static RESLOAD_CALLBACK resLoadCallback = nullptr;
 
+/* A file listed in the res file, loaded once the whole res file has been parsed */
+struct RES_QUEUED
+{
+	RES_TYPE       *psT;
+	std::string     type;
+	std::string     file;                   ///< The name in the res file
+	std::string     fileName;               ///< The full path, in the directory current at that point of the res file
+	JobHandle       preloaded;              ///< Runs the preload function, invalid if the type has none
+};
+
+static bool resQueueLoads = false;             ///< Whether resLoadFile queues files instead of loading them
+static std::vector<RES_QUEUED> resQueue;
+static std::atomic<bool> resPreloadCancel(false);  ///< Tells the remaining preload jobs to do nothing, as loading failed
+
 
 /* next four used in HashPJW */
 #define	BITS_IN_int		32
@@ -201,17 +225,25 @@ bool resLoad(const char *pResFile, SDWORD blockID)
 		return false;
 	}
 
-	// and parse it
+	// and parse it, queueing the files so that they can be preloaded while the earlier ones are being loaded
+	resQueueLoads = true;
 	res_set_extra(&input);
 	if (res_parse() != 0)
 	{
 		debug(LOG_FATAL, "Failed to parse %s", pResFile);
 		retval = false;
 	}
+	resQueueLoads = false;
 
 	res_lex_destroy();
 	PHYSFS_close(input.input.physfsfile);
 
+	if (retval)
+	{
+		retval = resLoadQueue();
+	}
+	resQueue.clear();
+
 	return retval;
 }
 
@@ -234,6 +266,8 @@ static RES_TYPE *resAlloc(const char *pType)
 	sstrcpy(psT->aType, pType);
 	psT->HashedType = HashString(psT->aType); // store a hased version for super speed !
 	psT->psRes = nullptr;
+	psT->preload = nullptr;
+	psT->discard = nullptr;
 
 	return psT;
 }
@@ -270,6 +304,24 @@ bool resAddFileLoad(const char *pType, RES_FILELOAD fileLoad, RES_FREE release)
 	return true;
 }
 
+/* Add a preload function for a file type */
+bool resAddPreload(const char *pType, RES_PRELOAD preload, RES_DISCARD discard)
+{
+	const UDWORD HashedType = HashString(pType);
+	for (RES_TYPE *psT = psResTypes; psT != nullptr; psT = psT->psNext)
+	{
+		if (psT->HashedType == HashedType)
+		{
+			psT->preload = preload;
+			psT->discard = discard;
+			return true;
+		}
+	}
+
+	ASSERT(false, "Unknown type: %s", pType);
+	return false;
+}
+
 // Make a string lower case
 void resToLower(char *pStr)
 {
@@ -349,7 +401,7 @@ static SDWORD FindEmptyResourceFile()
 
 
 // Get a resource data file ... either loads it or just returns a pointer
-static bool RetreiveResourceFile(char *ResourceName, RESOURCEFILE **NewResource)
+static bool RetreiveResourceFile(const char *ResourceName, RESOURCEFILE **NewResource)
 {
 	SDWORD ResID;
 	RESOURCEFILE *ResData;
@@ -463,29 +515,11 @@ static void makeLocaleFile(char *fileName, size_t maxlen)  // given string must
  * Call the load function (registered in data.c)
  * for this filetype
  */
-bool resLoadFile(const char *pType, const char *pFile)
+static bool resLoadFileData(RES_TYPE *psT, const char *pType, const char *pFile, const char *aFileName)
 {
-	RES_TYPE	*psT = nullptr;
 	void		*pData = nullptr;
 	RES_DATA	*psRes = nullptr;
-	char		aFileName[PATH_MAX];
-	UDWORD HashedName, HashedType = HashString(pType);
-
-	// Find the resource-type
-	for (psT = psResTypes; psT != nullptr; psT = psT->psNext)
-	{
-		if (psT->HashedType == HashedType)
-		{
-			ASSERT(strcmp(psT->aType, pType) == 0, "Hash collision \"%s\" vs \"%s\"", psT->aType, pType);
-			break;
-		}
-	}
-
-	if (psT == nullptr)
-	{
-		debug(LOG_WZ, "resLoadFile: Unknown type: %s", pType);
-		return false;
-	}
+	UDWORD HashedName;
 
 	// Check for duplicates
 	HashedName = HashStringIgnoreCase(pFile);
@@ -502,17 +536,6 @@ bool resLoadFile(const char *pType, const char *pFile)
 		}
 	}
 
-	// Create the file name
-	if (strlen(aCurrResDir) + strlen(pFile) + 1 >= PATH_MAX)
-	{
-		debug(LOG_ERROR, "resLoadFile: Filename too long!! %s%s", aCurrResDir, pFile);
-		return false;
-	}
-	sstrcpy(aFileName, aCurrResDir);
-	sstrcat(aFileName, pFile);
-
-	makeLocaleFile(aFileName, sizeof(aFileName));  // check for translated file
-
 	SetLastResourceFilename(pFile); // Save the filename in case any routines need it
 
 	// load the resource
@@ -578,6 +601,116 @@ bool resLoadFile(const char *pType, const char *pFile)
 	return true;
 }
 
+bool resLoadFile(const char *pType, const char *pFile)
+{
+	RES_TYPE	*psT = nullptr;
+	char		aFileName[PATH_MAX];
+	UDWORD HashedType = HashString(pType);
+
+	// Find the resource-type
+	for (psT = psResTypes; psT != nullptr; psT = psT->psNext)
+	{
+		if (psT->HashedType == HashedType)
+		{
+			ASSERT(strcmp(psT->aType, pType) == 0, "Hash collision \"%s\" vs \"%s\"", psT->aType, pType);
+			break;
+		}
+	}
+
+	if (psT == nullptr)
+	{
+		debug(LOG_WZ, "resLoadFile: Unknown type: %s", pType);
+		return false;
+	}
+
+	// Create the file name
+	if (strlen(aCurrResDir) + strlen(pFile) + 1 >= PATH_MAX)
+	{
+		debug(LOG_ERROR, "resLoadFile: Filename too long!! %s%s", aCurrResDir, pFile);
+		return false;
+	}
+	sstrcpy(aFileName, aCurrResDir);
+	sstrcat(aFileName, pFile);
+
+	makeLocaleFile(aFileName, sizeof(aFileName));  // check for translated file
+
+	if (resQueueLoads)
+	{
+		RES_QUEUED entry;
+		entry.psT = psT;
+		entry.type = pType;
+		entry.file = pFile;
+		entry.fileName = aFileName;
+		resQueue.push_back(entry);
+		return true;
+	}
+
+	return resLoadFileData(psT, pType, pFile, aFileName);
+}
+
+/*!
+ * Load the files queued while parsing a res file.
+ * Files of types with a preload function are prepared by jobs, up to MAX_PRELOAD_AHEAD of them ahead of the main thread,
+ * which still calls every load function in res file order, as later files may depend on earlier ones.
+ */
+static bool resLoadQueue()
+{
+	std::vector<RES_TYPE *> preloadedTypes;
+	resPreloadCancel = false;
+	size_t nextPreload = 0;   // First entry not yet considered for preloading.
+	unsigned numAhead = 0;    // Preload jobs submitted for the entry being loaded and later ones.
+
+	bool retval = true;
+	for (size_t i = 0; i < resQueue.size(); ++i)
+	{
+		for (; nextPreload < resQueue.size() && (numAhead < MAX_PRELOAD_AHEAD || nextPreload <= i); ++nextPreload)
+		{
+			RES_QUEUED &entry = resQueue[nextPreload];
+			RES_TYPE *psT = entry.psT;
+			if (psT->preload == nullptr)
+			{
+				continue;
+			}
+			if (std::find(preloadedTypes.begin(), preloadedTypes.end(), psT) == preloadedTypes.end())
+			{
+				preloadedTypes.push_back(psT);
+			}
+			std::string fileName = entry.fileName;
+			entry.preloaded = jobSubmit([psT, fileName]() {
+				if (!resPreloadCancel)
+				{
+					psT->preload(fileName.c_str());
+				}
+			});
+			++numAhead;
+		}
+
+		const RES_QUEUED &entry = resQueue[i];
+		if (entry.preloaded.valid())
+		{
+			entry.preloaded.wait();
+			--numAhead;
+		}
+		if (!resLoadFileData(entry.psT, entry.type.c_str(), entry.file.c_str(), entry.fileName.c_str()))
+		{
+			retval = false;
+			break;
+		}
+	}
+
+	resPreloadCancel = true;
+	for (const RES_QUEUED &entry : resQueue)
+	{
+		entry.preloaded.wait();
+	}
+	for (RES_TYPE *psT : preloadedTypes)
+	{
+		psT->discard();
+	}
+
+	return retval;
+}
+
 /* Return the resource for a type and hashedname */
 void *resGetDataFromHash(const char *pType, UDWORD HashedID)
 {
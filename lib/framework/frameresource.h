@@ -39,6 +39,15 @@ typedef bool (*RES_FILELOAD)(const char *pFile, void **pData);
 /** Function pointer for releasing a resource loaded by the above functions. */
 typedef void (*RES_FREE)(void *pData);
 
+/**
+ * Function pointer for a function that prepares a file on a worker thread, ahead of its load function.
+ * It may only do thread-safe work, such as decoding the file into a cache that the load function picks up.
+ */
+typedef void (*RES_PRELOAD)(const char *pFile);
+
+/** Function pointer for dropping whatever the preload functions prepared that was not used. */
+typedef void (*RES_DISCARD)();
+
 /** callback type for resload display callback. */
 typedef void (*RESLOAD_CALLBACK)();
 
@@ -71,6 +80,8 @@ struct RES_TYPE
 	UDWORD	HashedType;				// hashed version of the name of the id - // a null hashedtype indicates end of list
 
 	RES_FILELOAD	fileLoad;		// This isn't really used any more ?
+	RES_PRELOAD	preload;		// routine run on a worker thread before the load routine (NULL indicates none)
+	RES_DISCARD	discard;		// routine to drop unused preloaded data once a res file is loaded
 	RES_TYPE       *psNext;
 };
 
@@ -106,6 +117,9 @@ WZ_DECL_NONNULL(1) bool resAddBufferLoad(const char *pType, RES_BUFFERLOAD buffL
 /** Add a file name load and release function for a file type. */
 WZ_DECL_NONNULL(1) bool resAddFileLoad(const char *pType, RES_FILELOAD fileLoad, RES_FREE release);
 
+/** Add a preload function for an already added file type, run concurrently with the loading of the preceding files. */
+WZ_DECL_NONNULL(1, 2, 3) bool resAddPreload(const char *pType, RES_PRELOAD preload, RES_DISCARD discard);
+
 /** Call the load function for a file. */
 WZ_DECL_NONNULL(1, 2) bool resLoadFile(const char *pType, const char *pFile);
 
@@ -0,0 +1,586 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file jobsystem.cpp
+ *
+ * Worker thread pool with work-stealing job queues.
+ *
+ */
+
+#include <atomic>
+#include <thread>
+
+#include "frame.h"
+#include "wzapp.h"
+#include "jobsystem.h"
+
+#define MAX_JOB_WORKERS		15	///< Upper limit on worker threads.
+#define JOB_DEQUE_SIZE		1024	///< Jobs each worker can have queued, must be a power of 2.
+#define JOB_QUEUE_SIZE		4096	///< Jobs that can be queued from outside the workers, must be a power of 2.
+
+struct JobSuccessor;
+
+struct JobState
+{
+	std::function<void ()>         function;
+	std::atomic<unsigned>          unfinishedDependencies;  ///< The job is queued when this reaches 0.
+	std::atomic<JobSuccessor *>    successors;              ///< Jobs depending on this one, jobSuccessorsClosed once this one has finished.
+	std::atomic<bool>              started;                 ///< Set by whichever thread runs the job, which may be one waiting for it rather than the one popping it.
+	std::atomic<bool>              done;
+	std::shared_ptr<JobState>      self;                    ///< Keeps the job alive while it is queued.
+};
+
+struct JobSuccessor
+{
+	std::shared_ptr<JobState> job;
+	JobSuccessor             *next;
+};
+
+static JobSuccessor jobSuccessorsClosed;  ///< Marks the successor list of a finished job, so nothing more is added to it.
+
+/// Chase-Lev work-stealing deque. Only the owning worker may push and pop, any thread may steal.
+class JobDeque
+{
+public:
+	JobDeque() : top(0), bottom(0)
+	{
+		for (std::atomic<JobState *> &job : jobs)
+		{
+			job.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	bool push(JobState *job)
+	{
+		int64_t b = bottom.load(std::memory_order_relaxed);
+		int64_t t = top.load(std::memory_order_acquire);
+		if (b - t >= JOB_DEQUE_SIZE)
+		{
+			return false;
+		}
+		jobs[b & (JOB_DEQUE_SIZE - 1)].store(job, std::memory_order_relaxed);
+		bottom.store(b + 1, std::memory_order_release);
+		return true;
+	}
+
+	JobState *pop()
+	{
+		int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = top.load(std::memory_order_relaxed);
+		if (t > b)
+		{
+			bottom.store(b + 1, std::memory_order_relaxed);  // Was empty.
+			return nullptr;
+		}
+		JobState *job = jobs[b & (JOB_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+		if (t == b)
+		{
+			// Last job, so race any thieves for it.
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				job = nullptr;
+			}
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	JobState *steal()
+	{
+		int64_t t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t b = bottom.load(std::memory_order_acquire);
+		if (t >= b)
+		{
+			return nullptr;
+		}
+		JobState *job = jobs[t & (JOB_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return nullptr;  // Lost the race, the caller may try again elsewhere.
+		}
+		return job;
+	}
+
+	bool empty() const
+	{
+		return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<int64_t>    top;
+	std::atomic<int64_t>    bottom;
+	std::atomic<JobState *> jobs[JOB_DEQUE_SIZE];
+};
+
+/// Bounded multi-producer multi-consumer queue, for jobs submitted from outside the workers.
+class JobQueue
+{
+public:
+	JobQueue() : pushPos(0), popPos(0)
+	{
+		for (size_t i = 0; i < JOB_QUEUE_SIZE; ++i)
+		{
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+			cells[i].job = nullptr;
+		}
+	}
+
+	bool push(JobState *job)
+	{
+		size_t pos = pushPos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell &cell = cells[pos & (JOB_QUEUE_SIZE - 1)];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+			if (diff == 0)
+			{
+				if (pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					cell.job = job;
+					cell.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				return false;  // Full.
+			}
+			else
+			{
+				pos = pushPos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	JobState *pop()
+	{
+		size_t pos = popPos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell &cell = cells[pos & (JOB_QUEUE_SIZE - 1)];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+			if (diff == 0)
+			{
+				if (popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					JobState *job = cell.job;
+					cell.sequence.store(pos + JOB_QUEUE_SIZE, std::memory_order_release);
+					return job;
+				}
+			}
+			else if (diff < 0)
+			{
+				return nullptr;  // Empty.
+			}
+			else
+			{
+				pos = popPos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool empty() const
+	{
+		return popPos.load(std::memory_order_relaxed) >= pushPos.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		JobState           *job;
+	};
+
+	Cell                cells[JOB_QUEUE_SIZE];
+	std::atomic<size_t> pushPos;
+	std::atomic<size_t> popPos;
+};
+
+static bool                    jobInitialised = false;
+static std::atomic<bool>       jobQuit(false);
+static std::vector<WZ_THREAD *> jobThreads;
+static JobDeque               *jobDeques = nullptr;     ///< One per worker.
+static JobQueue               *jobQueue = nullptr;
+static WZ_SEMAPHORE           *jobWakeSemaphore = nullptr;
+static std::atomic<unsigned>   jobSleepers(0);          ///< Workers waiting for jobWakeSemaphore, or about to.
+static WZ_SEMAPHORE           *jobDoneSemaphore = nullptr;
+static std::atomic<unsigned>   jobWaiters(0);           ///< Threads outside the workers waiting for jobDoneSemaphore, or about to.
+static thread_local int        jobWorkerIndex = -1;     ///< Index of the worker running on this thread, -1 if not a worker.
+
+/// Removes one sleeping thread from the count, if there is one. The caller must then either post or wait for the matching semaphore.
+static bool jobTakeSleeper(std::atomic<unsigned> &sleepers)
+{
+	unsigned count = sleepers.load();
+	while (count != 0)
+	{
+		if (sleepers.compare_exchange_weak(count, count - 1))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void jobWakeOne()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);  // Pairs with the fence in jobWorkerThreadFunc, so either we see the sleeper, or it sees the job.
+	if (jobTakeSleeper(jobSleepers))
+	{
+		wzSemaphorePost(jobWakeSemaphore);
+	}
+}
+
+/// Wakes everything waiting in JobHandle::wait(), so each can check whether its own job is done.
+static void jobWakeWaiters()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);  // Pairs with the fence in JobHandle::wait().
+	while (jobTakeSleeper(jobWaiters))
+	{
+		wzSemaphorePost(jobDoneSemaphore);
+	}
+}
+
+static bool jobAnyQueued()
+{
+	if (!jobQueue->empty())
+	{
+		return true;
+	}
+	for (unsigned i = 0; i < jobThreads.size(); ++i)
+	{
+		if (!jobDeques[i].empty())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void jobSchedule(std::shared_ptr<JobState> const &state);
+
+/// Releases one of the things state is waiting for, and queues it if that was the last one.
+static void jobReleaseDependency(std::shared_ptr<JobState> const &state)
+{
+	if (state->unfinishedDependencies.fetch_sub(1) == 1)
+	{
+		jobSchedule(state);
+	}
+}
+
+/// Runs a job which the caller has already claimed, by setting started.
+static void jobExecute(JobState *job)
+{
+	job->function();
+	job->function = nullptr;  // Free anything the function holds on to now, rather than when the last handle goes.
+	job->done.store(true, std::memory_order_release);
+	if (jobInitialised)
+	{
+		jobWakeWaiters();
+	}
+
+	JobSuccessor *successor = job->successors.exchange(&jobSuccessorsClosed);
+	while (successor != nullptr)
+	{
+		JobSuccessor *next = successor->next;
+		jobReleaseDependency(successor->job);
+		delete successor;
+		successor = next;
+	}
+}
+
+/// Runs a job taken off a queue, unless a thread waiting for it got there first.
+static void jobRun(JobState *job)
+{
+	std::shared_ptr<JobState> keepAlive = std::move(job->self);
+
+	if (!job->started.exchange(true))
+	{
+		jobExecute(job);
+	}
+}
+
+static void jobSchedule(std::shared_ptr<JobState> const &state)
+{
+	JobState *job = state.get();
+	job->self = state;
+	bool queued = jobWorkerIndex >= 0 ? jobDeques[jobWorkerIndex].push(job) : jobQueue->push(job);
+	if (!queued)
+	{
+		jobRun(job);  // Queues are full, so may as well do it now.
+		return;
+	}
+	jobWakeOne();
+}
+
+/// Runs one queued job, preferring this worker's own jobs, then jobs from outside the workers, then other workers' jobs.
+static bool jobRunOne()
+{
+	JobState *job = nullptr;
+	if (jobWorkerIndex >= 0)
+	{
+		job = jobDeques[jobWorkerIndex].pop();
+	}
+	if (job == nullptr)
+	{
+		job = jobQueue->pop();
+	}
+	unsigned numWorkers = jobThreads.size();
+	for (unsigned i = 1; job == nullptr && i <= numWorkers; ++i)
+	{
+		unsigned victim = (jobWorkerIndex + i) % numWorkers;
+		job = jobDeques[victim].steal();
+	}
+	if (job == nullptr)
+	{
+		return false;
+	}
+	jobRun(job);
+	return true;
+}
+
+/** This runs in a separate thread */
+static int jobWorkerThreadFunc(void *data)
+{
+	jobWorkerIndex = (int)(intptr_t)data;
+	for (;;)
+	{
+		if (jobRunOne())
+		{
+			continue;
+		}
+		if (jobQuit.load())
+		{
+			break;
+		}
+
+		// Go to sleep, unless something was queued after we last looked.
+		jobSleepers.fetch_add(1);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if ((jobAnyQueued() || jobQuit.load()) && jobTakeSleeper(jobSleepers))
+		{
+			continue;
+		}
+		wzSemaphoreWait(jobWakeSemaphore);
+	}
+	return 0;
+}
+
+bool JobHandle::finished() const
+{
+	return state == nullptr || state->done.load(std::memory_order_acquire);
+}
+
+void JobHandle::wait() const
+{
+	while (!finished())
+	{
+		if (!jobInitialised)
+		{
+			wzYieldCurrentThread();
+			continue;
+		}
+
+		// If the job is queued but nobody has started it yet, just run it here.
+		JobState *job = state.get();
+		if (job->unfinishedDependencies.load() == 0 && !job->started.exchange(true))
+		{
+			jobExecute(job);
+			break;
+		}
+
+		if (jobWorkerIndex >= 0)
+		{
+			// A worker must not sleep here, since whatever it waits for might be stuck in its own deque.
+			if (!jobRunOne())
+			{
+				wzYieldCurrentThread();
+			}
+			continue;
+		}
+
+		// Sleep until some job finishes, unless ours already did.
+		jobWaiters.fetch_add(1);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (finished() && jobTakeSleeper(jobWaiters))
+		{
+			break;
+		}
+		wzSemaphoreWait(jobDoneSemaphore);
+	}
+}
+
+bool jobSystemInitialise()
+{
+	if (jobInitialised)
+	{
+		return true;
+	}
+
+	// At least one worker, even on a single core, so that jobs nobody waits for still run
+	unsigned cores = std::thread::hardware_concurrency();  // May be 0, if unknown.
+	unsigned numWorkers = std::min<unsigned>(cores > 1 ? cores - 1 : 1, MAX_JOB_WORKERS);
+
+	jobQuit = false;
+	jobDeques = new JobDeque[numWorkers];
+	jobQueue = new JobQueue;
+	jobWakeSemaphore = wzSemaphoreCreate(0);
+	jobDoneSemaphore = wzSemaphoreCreate(0);
+	jobThreads.resize(numWorkers);  // Set the size before starting any thread, since they all look at it.
+	for (unsigned i = 0; i < numWorkers; ++i)
+	{
+		jobThreads[i] = wzThreadCreate(jobWorkerThreadFunc, (void *)(intptr_t)i);
+	}
+	for (WZ_THREAD *thread : jobThreads)
+	{
+		wzThreadStart(thread);
+	}
+	jobInitialised = true;
+	debug(LOG_INFO, "Using %u worker threads for jobs", numWorkers);
+
+	return true;
+}
+
+void jobSystemShutdown()
+{
+	if (!jobInitialised)
+	{
+		return;
+	}
+
+	// Signal the worker threads to quit once everything queued has run
+	jobQuit = true;
+	while (jobTakeSleeper(jobSleepers))
+	{
+		wzSemaphorePost(jobWakeSemaphore);  // Wake up thread.
+	}
+	for (WZ_THREAD *thread : jobThreads)
+	{
+		wzThreadJoin(thread);
+	}
+	while (jobRunOne()) {}  // Anything queued by the last jobs.
+
+	jobInitialised = false;
+	jobThreads.clear();
+	delete[] jobDeques;
+	jobDeques = nullptr;
+	delete jobQueue;
+	jobQueue = nullptr;
+	wzSemaphoreDestroy(jobWakeSemaphore);
+	jobWakeSemaphore = nullptr;
+	wzSemaphoreDestroy(jobDoneSemaphore);
+	jobDoneSemaphore = nullptr;
+	jobSleepers = 0;
+	jobWaiters = 0;
+}
+
+unsigned jobSystemThreadCount()
+{
+	return jobThreads.size() + 1;
+}
+
+JobHandle jobSubmit(std::function<void ()> function)
+{
+	return jobSubmitAfter(std::vector<JobHandle>(), std::move(function));
+}
+
+JobHandle jobSubmitAfter(std::vector<JobHandle> const &dependencies, std::function<void ()> function)
+{
+	JobHandle handle;
+	handle.state = std::make_shared<JobState>();
+	std::shared_ptr<JobState> const &state = handle.state;
+	state->function = std::move(function);
+	state->unfinishedDependencies = dependencies.size() + 1;  // One extra, so it isn't queued while still adding dependencies.
+	state->successors = nullptr;
+	state->started = false;
+	state->done = false;
+
+	if (!jobInitialised)
+	{
+		for (JobHandle const &dependency : dependencies)
+		{
+			dependency.wait();
+		}
+		state->self = state;
+		jobRun(state.get());
+		return handle;
+	}
+
+	for (JobHandle const &dependency : dependencies)
+	{
+		if (!dependency.valid())
+		{
+			jobReleaseDependency(state);
+			continue;
+		}
+		JobSuccessor *successor = new JobSuccessor{state, nullptr};
+		JobSuccessor *head = dependency.state->successors.load();
+		do
+		{
+			if (head == &jobSuccessorsClosed)
+			{
+				break;
+			}
+			successor->next = head;
+		}
+		while (!dependency.state->successors.compare_exchange_weak(head, successor));
+		if (head == &jobSuccessorsClosed)
+		{
+			delete successor;  // Already finished.
+			jobReleaseDependency(state);
+		}
+	}
+	jobReleaseDependency(state);
+
+	return handle;
+}
+
+void jobParallelFor(unsigned count, std::function<void (unsigned)> const &function)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	std::atomic<unsigned> next(0);
+	auto runCalls = [&]() {
+		for (unsigned n = next++; n < count; n = next++)
+		{
+			function(n);
+		}
+	};
+
+	// Don't bother waking up more threads than there are calls, the calling thread does some of them too.
+	unsigned numHelpers = std::min<unsigned>(jobThreads.size(), count - 1);
+	std::vector<JobHandle> helpers;
+	helpers.reserve(numHelpers);
+	for (unsigned i = 0; i < numHelpers; ++i)
+	{
+		helpers.push_back(jobSubmit(runCalls));
+	}
+	runCalls();
+	for (JobHandle const &helper : helpers)
+	{
+		helper.wait();
+	}
+}
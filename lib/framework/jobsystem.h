@@ -0,0 +1,123 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  A fixed pool of worker threads, shared by everything that wants to run work in the background or in parallel.
+ *
+ *  Each worker has its own work-stealing deque, which jobs submitted from inside other jobs go to, and jobs
+ *  submitted from any other thread go to a shared queue. Idle workers steal from each other. Waiting for a job
+ *  that nobody has started yet runs it on the waiting thread, otherwise the waiting thread sleeps until it is
+ *  done, so a short wait is never stuck behind some unrelated long job. Workers waiting inside a job run other
+ *  queued jobs meanwhile instead, so jobs may wait for other jobs without tying up a worker.
+ *
+ *  Jobs should not block for long on anything but other jobs (such as sockets), as that takes a worker away
+ *  from everyone else. Such things should keep their own threads.
+ */
+
+#ifndef __INCLUDED_LIB_FRAMEWORK_JOBSYSTEM_H__
+#define __INCLUDED_LIB_FRAMEWORK_JOBSYSTEM_H__
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+struct JobState;
+
+/// Refers to a submitted job, which may or may not have run yet.
+class JobHandle
+{
+public:
+	bool valid() const
+	{
+		return state != nullptr;
+	}
+	/// True once the job has run. Everything the job did is then visible to the caller.
+	bool finished() const;
+	/// Returns once the job has run, running it here if nobody has started it yet.
+	void wait() const;
+
+private:
+	friend JobHandle jobSubmitAfter(std::vector<JobHandle> const &dependencies, std::function<void ()> function);
+
+	std::shared_ptr<JobState> state;
+};
+
+/// Refers to a job which returns a value, see jobAsync().
+template <typename R>
+class JobFuture
+{
+public:
+	bool valid() const
+	{
+		return job.valid();
+	}
+	bool finished() const
+	{
+		return job.finished();
+	}
+	void wait() const
+	{
+		job.wait();
+	}
+	/// Waits for the job, and returns its result. May only be called once.
+	R get()
+	{
+		job.wait();
+		return std::move(*result);
+	}
+
+	JobHandle job;
+	std::shared_ptr<R> result;
+};
+
+/// Start the worker threads. Until this is called, jobs run immediately on the submitting thread.
+bool jobSystemInitialise();
+
+/// Runs all remaining jobs, and stops the worker threads.
+void jobSystemShutdown();
+
+/// Number of threads, including the calling thread, that jobParallelFor() uses.
+unsigned jobSystemThreadCount();
+
+/// Queues function to run on some thread.
+JobHandle jobSubmit(std::function<void ()> function);
+
+/// Queues function to run on some thread, once all the dependencies have finished. Invalid handles are ignored.
+/// Jobs depending on each other form a task graph, so for example chaining each job after the previous one runs them in order.
+JobHandle jobSubmitAfter(std::vector<JobHandle> const &dependencies, std::function<void ()> function);
+
+/// Queues function to run on some thread, and returns a future for its result, which must be default constructible.
+template <typename F>
+JobFuture<typename std::result_of<F()>::type> jobAsync(F function)
+{
+	typedef typename std::result_of<F()>::type R;
+	JobFuture<R> future;
+	std::shared_ptr<R> result = std::make_shared<R>();
+	future.result = result;
+	future.job = jobSubmit([result, function]() mutable {
+		*result = function();
+	});
+	return future;
+}
+
+/// Calls function(0) ... function(count - 1), spread over all threads, and returns once all calls have finished.
+/// The order in which the calls run is unspecified, so each call must only write to its own results.
+void jobParallelFor(unsigned count, std::function<void (unsigned)> const &function);
+
+#endif // __INCLUDED_LIB_FRAMEWORK_JOBSYSTEM_H__
@@ -32,36 +32,137 @@
 
 #include "types.h"
 #include "debug.h"
-#include "treap.h"
 #include "strres.h"
 #include "strresly.h"
 #include "physfs_ext.h"
 
+#define STR_ARENA_BLOCK_SIZE	(64 * 1024)	///< Size of the blocks holding the identifiers and strings
+#define STR_INITIAL_SLOTS	1024		///< Initial size of the hash tables, must be a power of two
+
+/* A block of the arena holding the identifiers and strings */
+struct STR_BLOCK
+{
+	STR_BLOCK      *psNext;                 ///< The previously allocated block
+	size_t          used;                   ///< Bytes used after the header
+	size_t          size;                   ///< Bytes available after the header
+};
+
+/* A string identifier and its string */
+struct STR_ENTRY
+{
+	const char     *pID;
+	const char     *pString;
+	uint32_t        idHash;
+	uint32_t        stringHash;
+};
+
 /* A String Resource */
 struct STR_RES
 {
-	struct TREAP_NODE     **psIDTreap;              ///< The treap to store string identifiers
+	STR_ENTRY      *psEntries;              ///< The strings, in the order they were stored
+	uint32_t        numEntries, maxEntries;
+	uint32_t       *pIDSlots;               ///< Open addressing table keyed on the identifier; entry index + 1, or 0 if empty
+	uint32_t       *pStringSlots;           ///< Open addressing table keyed on the string, for reverse lookups
+	uint32_t        numSlots;               ///< Size of both tables, a power of two
+	STR_BLOCK      *psBlocks;               ///< The arena, most recently allocated block first
 };
 
-/* Initialise the string system */
-STR_RES *strresCreate()
+/* FNV-1a */
+static uint32_t strresHash(const char *pStr)
 {
-	STR_RES *const psRes = (STR_RES *)malloc(sizeof(*psRes));
-	if (!psRes)
+	uint32_t hash = 2166136261u;
+	for (; *pStr != '\0'; ++pStr)
 	{
-		debug(LOG_FATAL, "Out of memory");
-		abort();
-		return nullptr;
+		hash = (hash ^ (uint8_t)*pStr) * 16777619u;
 	}
+	return hash;
+}
 
-	psRes->psIDTreap = treapCreate();
-	if (!psRes->psIDTreap)
+static void *strresAlloc(size_t size)
+{
+	void *const pMem = malloc(size);
+	if (!pMem)
 	{
 		debug(LOG_FATAL, "Out of memory");
 		abort();
-		free(psRes);
-		return nullptr;
 	}
+	return pMem;
+}
+
+/* Copy a string into the arena */
+static const char *strresIntern(STR_RES *psRes, const char *pStr)
+{
+	const size_t len = strlen(pStr) + 1;
+	STR_BLOCK *psBlock = psRes->psBlocks;
+	if (psBlock == nullptr || psBlock->size - psBlock->used < len)
+	{
+		const size_t size = MAX(len, STR_ARENA_BLOCK_SIZE);
+		psBlock = (STR_BLOCK *)strresAlloc(sizeof(*psBlock) + size);
+		psBlock->psNext = psRes->psBlocks;
+		psBlock->used = 0;
+		psBlock->size = size;
+		psRes->psBlocks = psBlock;
+	}
+	char *const pCopy = (char *)(psBlock + 1) + psBlock->used;
+	memcpy(pCopy, pStr, len);
+	psBlock->used += len;
+	return pCopy;
+}
+
+/* Find the slot holding the entry with the given key, or the empty slot where it belongs */
+static uint32_t *strresFindSlot(const STR_RES *psRes, uint32_t *pSlots, uint32_t hash, const char *pKey, bool byString)
+{
+	const uint32_t mask = psRes->numSlots - 1;
+	for (uint32_t slot = hash & mask;; slot = (slot + 1) & mask)
+	{
+		if (pSlots[slot] == 0)
+		{
+			return &pSlots[slot];
+		}
+		const STR_ENTRY *psEntry = &psRes->psEntries[pSlots[slot] - 1];
+		if (byString ? psEntry->stringHash == hash && strcmp(psEntry->pString, pKey) == 0
+		    : psEntry->idHash == hash && strcmp(psEntry->pID, pKey) == 0)
+		{
+			return &pSlots[slot];
+		}
+	}
+}
+
+/* Allocate both hash tables with the given size and insert all entries into them */
+static void strresRehash(STR_RES *psRes, uint32_t numSlots)
+{
+	free(psRes->pIDSlots);
+	free(psRes->pStringSlots);
+	psRes->numSlots = numSlots;
+	psRes->pIDSlots = (uint32_t *)strresAlloc(numSlots * sizeof(*psRes->pIDSlots));
+	psRes->pStringSlots = (uint32_t *)strresAlloc(numSlots * sizeof(*psRes->pStringSlots));
+	memset(psRes->pIDSlots, 0, numSlots * sizeof(*psRes->pIDSlots));
+	memset(psRes->pStringSlots, 0, numSlots * sizeof(*psRes->pStringSlots));
+
+	for (uint32_t i = 0; i < psRes->numEntries; ++i)
+	{
+		const STR_ENTRY *psEntry = &psRes->psEntries[i];
+		*strresFindSlot(psRes, psRes->pIDSlots, psEntry->idHash, psEntry->pID, false) = i + 1;
+		// Keep the first identifier stored for each string
+		uint32_t *pStringSlot = strresFindSlot(psRes, psRes->pStringSlots, psEntry->stringHash, psEntry->pString, true);
+		if (*pStringSlot == 0)
+		{
+			*pStringSlot = i + 1;
+		}
+	}
+}
+
+/* Initialise the string system */
+STR_RES *strresCreate()
+{
+	STR_RES *const psRes = (STR_RES *)strresAlloc(sizeof(*psRes));
+	psRes->psEntries = nullptr;
+	psRes->numEntries = 0;
+	psRes->maxEntries = 0;
+	psRes->pIDSlots = nullptr;
+	psRes->pStringSlots = nullptr;
+	psRes->psBlocks = nullptr;
+	strresRehash(psRes, STR_INITIAL_SLOTS);
 
 	return psRes;
 }
@@ -69,8 +170,16 @@ STR_RES *strresCreate()
 /* Shutdown the string system */
 void strresDestroy(STR_RES *psRes)
 {
-	// Release the treap and free the final memory
-	treapDestroy(psRes->psIDTreap);
+	// Release the arena, the tables and free the final memory
+	while (psRes->psBlocks != nullptr)
+	{
+		STR_BLOCK *psNext = psRes->psBlocks->psNext;
+		free(psRes->psBlocks);
+		psRes->psBlocks = psNext;
+	}
+	free(psRes->psEntries);
+	free(psRes->pIDSlots);
+	free(psRes->pStringSlots);
 	free(psRes);
 }
 
@@ -78,20 +187,59 @@ void strresDestroy(STR_RES *psRes)
 /* Store a string */
 bool strresStoreString(STR_RES *psRes, const char *pID, const char *pString)
 {
+	const uint32_t idHash = strresHash(pID);
+
 	// Make sure that this ID string hasn't been used before
-	if (treapFind(psRes->psIDTreap, pID) != nullptr)
+	uint32_t *pIDSlot = strresFindSlot(psRes, psRes->pIDSlots, idHash, pID, false);
+	if (*pIDSlot != 0)
 	{
 		debug(LOG_FATAL, "Duplicate string for id: \"%s\"", pID);
 		abort();
 		return false;
 	}
 
-	return treapAdd(psRes->psIDTreap, pID, pString);
+	if (psRes->numEntries == psRes->maxEntries)
+	{
+		psRes->maxEntries = MAX(psRes->maxEntries * 2, STR_INITIAL_SLOTS / 2);
+		STR_ENTRY *const psEntries = (STR_ENTRY *)realloc(psRes->psEntries, psRes->maxEntries * sizeof(*psEntries));
+		if (!psEntries)
+		{
+			debug(LOG_FATAL, "Out of memory");
+			abort();
+			return false;
+		}
+		psRes->psEntries = psEntries;
+	}
+
+	// Strings that occur several times are only stored once
+	const uint32_t stringHash = strresHash(pString);
+	uint32_t *pStringSlot = strresFindSlot(psRes, psRes->pStringSlots, stringHash, pString, true);
+
+	STR_ENTRY *psEntry = &psRes->psEntries[psRes->numEntries++];
+	psEntry->pID = strresIntern(psRes, pID);
+	psEntry->pString = *pStringSlot != 0 ? psRes->psEntries[*pStringSlot - 1].pString : strresIntern(psRes, pString);
+	psEntry->idHash = idHash;
+	psEntry->stringHash = stringHash;
+
+	*pIDSlot = psRes->numEntries;
+	if (*pStringSlot == 0)
+	{
+		*pStringSlot = psRes->numEntries;
+	}
+
+	// Keep the tables at most half full, so that probe sequences stay short
+	if (psRes->numEntries * 2 > psRes->numSlots)
+	{
+		strresRehash(psRes, psRes->numSlots * 2);
+	}
+
+	return true;
 }
 
 const char *strresGetString(const STR_RES *psRes, const char *ID)
 {
-	return treapFind(psRes->psIDTreap, ID);
+	const uint32_t slot = *strresFindSlot(psRes, psRes->pIDSlots, strresHash(ID), ID, false);
+	return slot != 0 ? psRes->psEntries[slot - 1].pString : nullptr;
 }
 
 /* Load a string resource file */
@@ -121,5 +269,6 @@ bool strresLoad(STR_RES *psRes, const char *fileName)
 /* Get the ID number for a string*/
 const char *strresGetIDfromString(STR_RES *psRes, const char *pString)
 {
-	return treapFindKey(psRes->psIDTreap, pString);
+	const uint32_t slot = *strresFindSlot(psRes, psRes->pStringSlots, strresHash(pString), pString, true);
+	return slot != 0 ? psRes->psEntries[slot - 1].pID : nullptr;
 }
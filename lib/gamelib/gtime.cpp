@@ -34,6 +34,7 @@
 
 
 #include <time.h>
+#include <algorithm>
 
 
 /* See header file for documentation */
@@ -64,6 +65,66 @@ static uint16_t discreteChosenLatency = GAME_TICKS_PER_UPDATE;
 static uint16_t wantedLatency = GAME_TICKS_PER_UPDATE;
 static uint16_t wantedLatencies[MAX_PLAYERS];
 
+#define LATENCY_WINDOW 50              ///< Ticks of history the latency controller looks at, 5 seconds.
+#define LATENCY_PERCENTILE 90          ///< Percentage of the ticks in the window which should not have had to wait for other players.
+#define LATENCY_HISTOGRAM_BUCKETS 32
+#define LATENCY_HISTOGRAM_BUCKET_MS 20
+#define LATENCY_HISTOGRAM_SAMPLES 512  ///< Halve the histogram after this many samples, so that it follows changing conditions.
+
+/// A histogram of times in milliseconds, which gradually forgets old samples.
+struct LatencyHistogram
+{
+	void clear()
+	{
+		std::fill(buckets, buckets + LATENCY_HISTOGRAM_BUCKETS, 0);
+		count = 0;
+	}
+
+	void add(uint32_t ms)
+	{
+		if (count >= LATENCY_HISTOGRAM_SAMPLES)
+		{
+			count = 0;
+			for (uint32_t &bucket : buckets)
+			{
+				bucket /= 2;
+				count += bucket;
+			}
+		}
+		++buckets[std::min<uint32_t>(ms / LATENCY_HISTOGRAM_BUCKET_MS, LATENCY_HISTOGRAM_BUCKETS - 1)];
+		++count;
+	}
+
+	/// Returns the upper edge of the bucket containing the given percentile, or 0 if there are no samples.
+	uint32_t percentile(unsigned percent) const
+	{
+		uint32_t wanted = (count * percent + 99) / 100;
+		uint32_t seen = 0;
+		for (unsigned n = 0; n < LATENCY_HISTOGRAM_BUCKETS && count != 0; ++n)
+		{
+			seen += buckets[n];
+			if (seen >= wanted)
+			{
+				return (n + 1) * LATENCY_HISTOGRAM_BUCKET_MS;
+			}
+		}
+		return 0;
+	}
+
+	uint32_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+	uint32_t count;
+};
+
+static uint32_t requiredLatencies[LATENCY_WINDOW];  ///< The latency each recent tick would have needed to not wait for others.
+static uint32_t stallTimes[LATENCY_WINDOW];         ///< How long each recent tick waited for others.
+static unsigned latencySamples = 0;                 ///< Number of ticks sampled, the latest is at (latencySamples - 1) % LATENCY_WINDOW.
+static uint32_t totalStalls = 0;
+
+static LatencyHistogram roundTripHistograms[MAX_PLAYERS];
+static LatencyHistogram jitterHistograms[MAX_PLAYERS];
+static uint32_t jitterEstimates[MAX_PLAYERS];       ///< Interarrival jitter of GAME_GAME_TIME messages as in RFC 3550, in 1/16 ms.
+static uint32_t lastArrivalTimes[MAX_PLAYERS];
+
 static void updateLatency(void);
 
 static std::string listToString(char const *format, char const *separator, uint32_t const *begin, uint32_t const *end)
@@ -110,7 +171,13 @@ void gameTimeInit(void)
 	for (player = 0; player != MAX_PLAYERS; ++player)
 	{
 		wantedLatencies[player] = 0;
+		roundTripHistograms[player].clear();
+		jitterHistograms[player].clear();
+		jitterEstimates[player] = 0;
+		lastArrivalTimes[player] = 0;
 	}
+	latencySamples = 0;
+	totalStalls = 0;
 
 	// Don't let syncDebug from previous games cause a desynch dump at gameTime 102.
 	resetSyncDebug();
@@ -296,6 +363,7 @@ void gameTimeStart(void)
 
 	prevRealTime = wzGetTicks();
 	stopCount = std::max<int>(stopCount - 1, 0);
+	std::fill(lastArrivalTimes, lastArrivalTimes + MAX_PLAYERS, 0);  // The time between the last message before the pause and the next one isn't jitter.
 }
 
 /* Call this to reset the game timer */
@@ -325,6 +393,7 @@ void getTimeComponents(unsigned time, int *hours, int *minutes, int *seconds, in
 static void updateLatency()
 {
 	uint16_t maxWantedLatency = 0;
+	uint32_t maxJitter = 0;
 	unsigned player;
 	uint16_t prevDiscreteChosenLatency = discreteChosenLatency;
 
@@ -335,20 +404,45 @@ static void updateLatency()
 		{
 			//minWantedLatency = MIN(minWantedLatency, wantedLatencies[player]);  // Minimum, so the clients don't increase the latency to try to make one slow computer run faster.
 			maxWantedLatency = MAX(maxWantedLatency, wantedLatencies[player]);  // Maximum, since the host experiences lower latency than everyone else.
+			maxJitter = MAX(maxJitter, jitterEstimates[player] >> 4);
 		}
 	}
 	// Adjust the agreed latency. (Can maximum decrease by 5ms or increase by 30ms per update.
 	chosenLatency = chosenLatency + clip(maxWantedLatency - chosenLatency, -5, 60);
 	// Round the chosen latency to an integer number of updates, up to 10.
-	discreteChosenLatency = clip((chosenLatency + GAME_TICKS_PER_UPDATE / 2) / GAME_TICKS_PER_UPDATE * GAME_TICKS_PER_UPDATE, GAME_TICKS_PER_UPDATE, GAME_TICKS_PER_UPDATE * GAME_UPDATES_PER_SEC);
+	int newDiscreteChosenLatency = clip((chosenLatency + GAME_TICKS_PER_UPDATE / 2) / GAME_TICKS_PER_UPDATE * GAME_TICKS_PER_UPDATE, GAME_TICKS_PER_UPDATE, GAME_TICKS_PER_UPDATE * GAME_UPDATES_PER_SEC);
+	// Only step down once well below the current step, so the latency doesn't flip between two steps, stalling each time it goes back up.
+	if (newDiscreteChosenLatency >= discreteChosenLatency || chosenLatency <= discreteChosenLatency - GAME_TICKS_PER_UPDATE * 3 / 4)
+	{
+		discreteChosenLatency = newDiscreteChosenLatency;
+	}
 	if (prevDiscreteChosenLatency != discreteChosenLatency)
 	{
 		debug(LOG_SYNC, "Adjusting latency %d -> %d", prevDiscreteChosenLatency, discreteChosenLatency);
 	}
 
-	// We want the chosen latency to increase by how much our update was delayed waiting for others, or to decrease by how long after we got the messages from others that it was time to tick. Plus a tiny 10ms buffer.
+	// Our update was delayed by how long we waited for others, or was early by how long after we got the messages from others that it was time to tick.
+	// So this tick would have needed the previous latency plus that delay.
+	if (updateReadyTime != 0 && updateWantedTime != 0)
+	{
+		int waited = (int)(updateReadyTime - updateWantedTime);
+		requiredLatencies[latencySamples % LATENCY_WINDOW] = std::max(prevDiscreteChosenLatency + waited, 0);
+		stallTimes[latencySamples % LATENCY_WINDOW] = std::max(waited, 0);
+		totalStalls += waited > 0;
+		++latencySamples;
+	}
+
+	// We want enough latency that most recent ticks would not have waited for others, plus a margin for the jitter of the messages from others, plus a tiny 10ms buffer.
 	// We will send this number to others.
-	wantedLatency = clip((int)(discreteChosenLatency + updateReadyTime - updateWantedTime + 10), 0, UINT16_MAX);
+	if (latencySamples != 0)
+	{
+		unsigned numSamples = std::min<unsigned>(latencySamples, LATENCY_WINDOW);
+		uint32_t sorted[LATENCY_WINDOW];
+		std::copy(requiredLatencies, requiredLatencies + numSamples, sorted);
+		uint32_t *nth = sorted + (numSamples - 1) * LATENCY_PERCENTILE / 100;
+		std::nth_element(sorted, nth, sorted + numSamples);
+		wantedLatency = clip((int)(*nth + maxJitter + 10), 0, UINT16_MAX);
+	}
 
 	// Reset the times, ready to be set again.
 	updateReadyTime = 0;
@@ -446,3 +540,63 @@ void setPlayerGameTime(unsigned player, uint32_t time)
 		gameQueueTime[player] = time;
 	}
 }
+
+void recordPlayerRoundTrip(unsigned player, uint32_t roundTrip)
+{
+	ASSERT_OR_RETURN(, player < MAX_PLAYERS, "Bad player %u", player);
+	roundTripHistograms[player].add(roundTrip);
+}
+
+void recordPlayerGameTimeArrival(unsigned player)
+{
+	ASSERT_OR_RETURN(, player < MAX_PLAYERS, "Bad player %u", player);
+	uint32_t now = wzGetTicks();
+	uint32_t prevArrival = lastArrivalTimes[player];
+	lastArrivalTimes[player] = stopCount == 0 ? now : 0;  // Messages read while paused are no reference for the next one either.
+	if (prevArrival == 0 || modifier.n <= 0 || stopCount != 0)
+	{
+		return;
+	}
+
+	// Messages are sent once per update, so compare the time between them with the real time an update takes.
+	int expected = GAME_TICKS_PER_UPDATE * modifier.d / modifier.n;
+	uint32_t deviation = std::min<uint32_t>(abs((int)(now - prevArrival) - expected), GAME_TICKS_PER_SEC);
+	jitterEstimates[player] += deviation - ((jitterEstimates[player] + 8) >> 4);
+	jitterHistograms[player].add(deviation);
+}
+
+uint32_t getPlayerRoundTrip(unsigned player, unsigned percent)
+{
+	ASSERT_OR_RETURN(0, player < MAX_PLAYERS, "Bad player %u", player);
+	return roundTripHistograms[player].percentile(percent);
+}
+
+uint32_t getPlayerJitter(unsigned player, unsigned percent)
+{
+	ASSERT_OR_RETURN(0, player < MAX_PLAYERS, "Bad player %u", player);
+	return jitterHistograms[player].percentile(percent);
+}
+
+uint32_t getChosenLatency()
+{
+	return discreteChosenLatency;
+}
+
+uint32_t getWantedLatency()
+{
+	return wantedLatency;
+}
+
+uint32_t getStallCount(bool isTotal)
+{
+	if (isTotal)
+	{
+		return totalStalls;
+	}
+	uint32_t stalls = 0;
+	for (unsigned n = 0; n < std::min<unsigned>(latencySamples, GAME_UPDATES_PER_SEC); ++n)
+	{
+		stalls += stallTimes[(latencySamples - 1 - n) % LATENCY_WINDOW] != 0;
+	}
+	return stalls;
+}
@@ -194,4 +194,12 @@ void recvPlayerGameTime(NETQUEUE queue);                  ///< Processes a GAME_
 bool checkPlayerGameTime(unsigned player);                ///< Checks that we are not waiting for a GAME_GAME_TIME message from this player. (player can be NET_ALL_PLAYERS.)
 void setPlayerGameTime(unsigned player, uint32_t time);   ///< Sets the player's time.
 
+void recordPlayerRoundTrip(unsigned player, uint32_t roundTrip);  ///< Records a measured round trip time to the player, in milliseconds.
+void recordPlayerGameTimeArrival(unsigned player);                ///< Records that a GAME_GAME_TIME message from the player just arrived over the network.
+uint32_t getPlayerRoundTrip(unsigned player, unsigned percent);   ///< Returns the round trip time to the player which percent% of recent measurements did not exceed, in milliseconds.
+uint32_t getPlayerJitter(unsigned player, unsigned percent);      ///< Returns the jitter in the arrival of the player's GAME_GAME_TIME messages which percent% of recent ones did not exceed, in milliseconds.
+uint32_t getChosenLatency();                                      ///< Returns the latency currently added to our game messages, in milliseconds.
+uint32_t getWantedLatency();                                      ///< Returns the latency we are asking others to agree on, in milliseconds.
+uint32_t getStallCount(bool isTotal);                             ///< Returns the number of ticks which waited for other players in the last second, or in the whole game.
+
 #endif
@@ -158,6 +158,38 @@ inline void ImageMerge::arrange()
 	}
 }
 
+void iV_PreloadImageFile(const char *fileName)
+{
+	std::string imageDir = fileName;
+	if (imageDir.find_last_of('.') != std::string::npos)
+	{
+		imageDir.erase(imageDir.find_last_of('.'));
+	}
+	imageDir += '/';
+
+	char *pFileData;
+	unsigned pFileSize;
+	if (!loadFile(fileName, &pFileData, &pFileSize))
+	{
+		return;  // iV_LoadImageFile reports the error
+	}
+
+	char *ptr = pFileData;
+	while (ptr < pFileData + pFileSize)
+	{
+		int xOffset, yOffset, temp;
+		char tmpName[256];
+		if (sscanf(ptr, "%d,%d,%255[^\r\n\",]%n", &xOffset, &yOffset, tmpName, &temp) != 3)
+		{
+			break;
+		}
+		iV_preloadImage_PNG((imageDir + tmpName).c_str());
+		ptr += temp;
+		while (ptr < pFileData + pFileSize && *ptr++ != '\n') {} // skip rest of line
+	}
+	free(pFileData);
+}
+
 IMAGEFILE *iV_LoadImageFile(const char *fileName)
 {
 	// Find the directory of images.
@@ -53,6 +53,7 @@ static inline WZ_DECL_PURE short iV_GetImageYOffset(const IMAGEFILE *ImageFile,
 
 ImageDef *iV_GetImage(const WzString &filename);
 IMAGEFILE *iV_LoadImageFile(const char *FileData);
+void iV_PreloadImageFile(const char *fileName);  ///< Decode the images listed in the file, from any thread
 void iV_FreeImageFile(IMAGEFILE *ImageFile);
 
 #endif
@@ -24,8 +24,10 @@
  * Load IMD (.pie) files
  */
 
+#include <algorithm>
 #include <string>
 #include <unordered_map>
+#include <map>
 
 #include "lib/framework/frame.h"
 #include "lib/framework/string_ext.h"
@@ -46,7 +48,129 @@
 
 static std::unordered_map<std::string, iIMDShape> models;
 
-static void iV_ProcessIMD(const WzString &filename, const char **ppFileData, const char *FileDataEnd);
+#define MODEL_CACHE_FILE	"modelcache.bin"	///< Parsed models, so that PIE files only need parsing when they change. In the write directory.
+#define MODEL_CACHE_MAGIC	0x434d5a57	///< "WZMC", also catches caches written on a machine of the other endianness.
+#define MODEL_CACHE_VERSION	1	///< Increase whenever the layout below or the parser output changes.
+
+/// A parsed model. Only valid while the PIE file has the same size, modification time and real directory.
+struct ModelCacheEntry
+{
+	int64_t size = -1;
+	int64_t modTime = -1;
+	std::vector<char> blob;  ///< Model-wide data, then each level including its GPU buffer contents. See modelCacheWrite().
+	bool used = false;       ///< Looked up this session. Only these are saved, so models no longer loaded drop out of the cache.
+};
+
+static std::map<std::string, ModelCacheEntry> modelCache;  ///< Keyed by real directory and path, such as "/usr/share/warzone2100/base.wz/structs/blbase.pie".
+static bool modelCacheLoaded = false;
+static bool modelCacheDirty = false;
+
+/// Model-wide data, which iV_ProcessIMD() reads before the levels and applies after them.
+struct ModelHeader
+{
+	uint32_t flags = 0;
+	bool textured = false;
+	std::string texfile;
+	std::string normalfile;
+	std::string specfile;
+	std::string animpie[ANIM_EVENT_COUNT];  ///< Model used for each animation event, empty if none.
+	uint32_t firstLevel = 0;
+};
+
+/// Appends plain values to a model cache blob.
+class ModelCacheWriter
+{
+public:
+	template <typename T>
+	void put(T const &value)
+	{
+		char const *p = reinterpret_cast<char const *>(&value);
+		data.insert(data.end(), p, p + sizeof(T));
+	}
+
+	template <typename T>
+	void putVector(T const *values, size_t count)
+	{
+		put<uint32_t>(count);
+		char const *p = reinterpret_cast<char const *>(values);
+		data.insert(data.end(), p, p + count * sizeof(T));
+	}
+
+	template <typename T>
+	void putVector(std::vector<T> const &values)
+	{
+		putVector(values.data(), values.size());
+	}
+
+	void putString(std::string const &value)
+	{
+		putVector(value.data(), value.size());
+	}
+
+	std::vector<char> data;
+};
+
+/// Reads back what ModelCacheWriter wrote. Every get fails instead of reading past the end.
+class ModelCacheReader
+{
+public:
+	ModelCacheReader(char const *begin, char const *end) : pos(begin), end(end) {}
+
+	template <typename T>
+	bool get(T &value)
+	{
+		if (size_t(end - pos) < sizeof(T))
+		{
+			return false;
+		}
+		memcpy(&value, pos, sizeof(T));
+		pos += sizeof(T);
+		return true;
+	}
+
+	template <typename T>
+	bool getVector(std::vector<T> &values)
+	{
+		uint32_t count;
+		if (!get(count) || size_t(end - pos) / sizeof(T) < count)
+		{
+			return false;
+		}
+		values.resize(count);
+		memcpy(values.data(), pos, count * sizeof(T));
+		pos += count * sizeof(T);
+		return true;
+	}
+
+	bool getString(std::string &value)
+	{
+		uint32_t count;
+		if (!get(count) || size_t(end - pos) < count)
+		{
+			return false;
+		}
+		value.assign(pos, count);
+		pos += count;
+		return true;
+	}
+
+	size_t remaining() const
+	{
+		return end - pos;
+	}
+
+	bool atEnd() const
+	{
+		return pos == end;
+	}
+
+private:
+	char const *pos;
+	char const *end;
+};
+
+static bool iV_ProcessIMD(const WzString &filename, const char **ppFileData, const char *FileDataEnd, ModelCacheWriter *cacheWriter);
+static bool modelCacheRead(const WzString &filename, std::vector<char> const &blob);
 
 iIMDShape::~iIMDShape()
 {
@@ -58,15 +182,130 @@ iIMDShape::~iIMDShape()
 	}
 }
 
+static void modelCacheLoad()
+{
+	modelCache.clear();
+	modelCacheLoaded = true;
+	modelCacheDirty = false;
+
+	char *pBuffer;
+	UDWORD size;
+	if (!PHYSFS_exists(MODEL_CACHE_FILE) || !loadFile(MODEL_CACHE_FILE, &pBuffer, &size))
+	{
+		return;
+	}
+	ModelCacheReader reader(pBuffer, pBuffer + size);
+	uint32_t magic = 0, version = 0, count = 0;
+	if (!reader.get(magic) || !reader.get(version) || magic != MODEL_CACHE_MAGIC || version != MODEL_CACHE_VERSION)
+	{
+		debug(LOG_WZ, "Ignoring %s from another version", MODEL_CACHE_FILE);
+		free(pBuffer);
+		return;
+	}
+	bool ok = reader.get(count);
+	for (uint32_t i = 0; ok && i < count; ++i)
+	{
+		std::string key;
+		ModelCacheEntry entry;
+		ok = reader.getString(key) && reader.get(entry.size) && reader.get(entry.modTime) && reader.getVector(entry.blob);
+		if (ok)
+		{
+			modelCache[key] = std::move(entry);
+		}
+	}
+	if (!ok || !reader.atEnd())
+	{
+		debug(LOG_WARNING, "Ignoring broken %s", MODEL_CACHE_FILE);
+		modelCache.clear();
+	}
+	free(pBuffer);
+}
+
+static void modelCacheSave()
+{
+	if (!modelCacheDirty)
+	{
+		return;
+	}
+	ModelCacheWriter writer;
+	writer.put<uint32_t>(MODEL_CACHE_MAGIC);
+	writer.put<uint32_t>(MODEL_CACHE_VERSION);
+	uint32_t count = std::count_if(modelCache.begin(), modelCache.end(), [](std::pair<const std::string, ModelCacheEntry> const &it) {
+		return it.second.used && !it.second.blob.empty();
+	});
+	writer.put<uint32_t>(count);
+	for (auto const &it : modelCache)
+	{
+		if (!it.second.used || it.second.blob.empty())
+		{
+			continue;
+		}
+		writer.putString(it.first);
+		writer.put(it.second.size);
+		writer.put(it.second.modTime);
+		writer.putVector(it.second.blob);
+	}
+	if (saveFile(MODEL_CACHE_FILE, writer.data.data(), writer.data.size()))
+	{
+		modelCacheDirty = false;
+	}
+}
+
+/// Returns the cache entry for the PIE file, cleared if the file changed since it was cached.
+static ModelCacheEntry &modelCacheLookup(const WzString &path)
+{
+	std::string fileName = path.toStdString();
+	int64_t size = -1;
+	PHYSFS_file *fileHandle = PHYSFS_openRead(fileName.c_str());
+	if (fileHandle != nullptr)
+	{
+		size = PHYSFS_fileLength(fileHandle);
+		PHYSFS_close(fileHandle);
+	}
+	int64_t modTime = WZ_PHYSFS_getLastModTime(fileName.c_str());
+	const char *realDir = PHYSFS_getRealDir(fileName.c_str());
+
+	ModelCacheEntry &entry = modelCache[std::string(realDir != nullptr ? realDir : "") + "/" + fileName];
+	if (entry.size != size || entry.modTime != modTime || size < 0)
+	{
+		entry = ModelCacheEntry();
+		entry.size = size;
+		entry.modTime = modTime;
+	}
+	entry.used = true;
+	return entry;
+}
+
 void modelShutdown()
 {
 	models.clear();
+	if (modelCacheLoaded)
+	{
+		modelCacheSave();
+		modelCache.clear();
+		modelCacheLoaded = false;
+	}
 }
 
 static bool tryLoad(const WzString &path, const WzString &filename)
 {
 	if (PHYSFS_exists(path + filename))
 	{
+		if (!modelCacheLoaded)
+		{
+			modelCacheLoad();
+		}
+		ModelCacheEntry &entry = modelCacheLookup(path + filename);
+		if (!entry.blob.empty())
+		{
+			if (modelCacheRead(filename, entry.blob))
+			{
+				return true;
+			}
+			debug(LOG_WARNING, "Ignoring broken cached model %s", WzString(path + filename).toUtf8().c_str());
+			entry.blob.clear();
+		}
+
 		char *pFileData = nullptr, *fileEnd;
 		UDWORD size = 0;
 		if (!loadFile(WzString(path + filename).toUtf8().c_str(), &pFileData, &size))
@@ -76,7 +315,12 @@ static bool tryLoad(const WzString &path, const WzString &filename)
 		}
 		fileEnd = pFileData + size;
 		const char *pFileDataPt = pFileData;
-		iV_ProcessIMD(filename, (const char **)&pFileDataPt, fileEnd);
+		ModelCacheWriter writer;
+		if (iV_ProcessIMD(filename, (const char **)&pFileDataPt, fileEnd, &writer))
+		{
+			entry.blob = std::move(writer.data);
+			modelCacheDirty = true;
+		}
 		free(pFileData);
 		return true;
 	}
@@ -580,6 +824,163 @@ static inline uint16_t addVertex(iIMDShape &s, int i, const iIMDPoly *p, int fra
 	return vertexCount - 1;
 }
 
+static std::string modelLevelKey(const WzString &filename, int level)
+{
+	std::string key = filename.toStdString();
+	if (level > 0)
+	{
+		key += "_" + std::to_string(level);
+	}
+	return key;
+}
+
+/// Massages the level into what can stream directly to OpenGL, leaving it in vertices, normals, texcoords and indices.
+static void _imd_build_buffers(iIMDShape &s)
+{
+	vertexCount = 0;
+	for (int k = 0; k < MAX(1, s.numFrames); k++)
+	{
+		// Go through all polygons for each frame
+		for (const iIMDPoly &p : s.polys)
+		{
+			// Do we already have the vertex data for this polygon?
+			indices.emplace_back(addVertex(s, 0, &p, k));
+			indices.emplace_back(addVertex(s, 1, &p, k));
+			indices.emplace_back(addVertex(s, 2, &p, k));
+		}
+	}
+}
+
+static void _imd_upload_buffers(iIMDShape &s)
+{
+	if (!s.buffers[VBO_VERTEX])
+		s.buffers[VBO_VERTEX] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer);
+	s.buffers[VBO_VERTEX]->upload(vertices.size() * sizeof(gfx_api::gfxFloat), vertices.data());
+
+	if (!s.buffers[VBO_NORMAL])
+		s.buffers[VBO_NORMAL] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer);
+	s.buffers[VBO_NORMAL]->upload(normals.size() * sizeof(gfx_api::gfxFloat), normals.data());
+
+	if (!s.buffers[VBO_INDEX])
+		s.buffers[VBO_INDEX] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::index_buffer);
+	s.buffers[VBO_INDEX]->upload(indices.size() * sizeof(uint16_t), indices.data());
+
+	if (!s.buffers[VBO_TEXCOORD])
+		s.buffers[VBO_TEXCOORD] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer);
+	s.buffers[VBO_TEXCOORD]->upload(texcoords.size() * sizeof(gfx_api::gfxFloat), texcoords.data());
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0); // unbind
+}
+
+static void _imd_clear_buffers()
+{
+	indices.resize(0);
+	vertices.resize(0);
+	texcoords.resize(0);
+	normals.resize(0);
+}
+
+/// Stores everything loading the level produced, including the buffers _imd_build_buffers() left behind.
+static void modelCacheWriteLevel(ModelCacheWriter &writer, const iIMDShape &s)
+{
+	writer.put(s.min);
+	writer.put(s.max);
+	writer.put<int32_t>(s.sradius);
+	writer.put<int32_t>(s.radius);
+	writer.put(s.ocen);
+	writer.put<uint16_t>(s.numFrames);
+	writer.put<uint16_t>(s.animInterval);
+	writer.putVector(s.connectors, s.nconnectors);
+	writer.putVector(s.points);
+	writer.put<uint32_t>(s.polys.size());
+	for (const iIMDPoly &poly : s.polys)
+	{
+		writer.put<uint32_t>(poly.flags);
+		writer.put<int32_t>(poly.zcentre);
+		writer.put(poly.normal);
+		writer.put(poly.pindex);
+		writer.put(poly.texAnim);
+		writer.putVector(poly.texCoord);
+	}
+	writer.put<int32_t>(s.objanimtime);
+	writer.put<int32_t>(s.objanimcycles);
+	writer.putVector(s.objanimdata);
+	writer.putVector(vertices);
+	writer.putVector(normals);
+	writer.putVector(texcoords);
+	writer.putVector(indices);
+}
+
+/// Counterpart of modelCacheWriteLevel(), leaving the buffers in vertices, normals, texcoords and indices.
+static bool modelCacheReadLevel(ModelCacheReader &reader, iIMDShape &s)
+{
+	int32_t sradius, radius, objanimtime, objanimcycles;
+	uint16_t numFrames, animInterval;
+	std::vector<Vector3i> connectors;
+	uint32_t npolys;
+	if (!reader.get(s.min) || !reader.get(s.max) || !reader.get(sradius) || !reader.get(radius) || !reader.get(s.ocen)
+	    || !reader.get(numFrames) || !reader.get(animInterval) || !reader.getVector(connectors) || !reader.getVector(s.points)
+	    || !reader.get(npolys) || npolys > reader.remaining())
+	{
+		return false;
+	}
+	s.sradius = sradius;
+	s.radius = radius;
+	s.numFrames = numFrames;
+	s.animInterval = animInterval;
+
+	s.polys.resize(npolys);
+	for (iIMDPoly &poly : s.polys)
+	{
+		int32_t zcentre;
+		if (!reader.get(poly.flags) || !reader.get(zcentre) || !reader.get(poly.normal) || !reader.get(poly.pindex)
+		    || !reader.get(poly.texAnim) || !reader.getVector(poly.texCoord))
+		{
+			return false;
+		}
+		poly.zcentre = zcentre;
+		for (int index : poly.pindex)
+		{
+			if (index < 0 || unsigned(index) >= s.points.size())
+			{
+				return false;
+			}
+		}
+	}
+
+	if (!reader.get(objanimtime) || !reader.get(objanimcycles) || !reader.getVector(s.objanimdata)
+	    || !reader.getVector(vertices) || !reader.getVector(normals) || !reader.getVector(texcoords) || !reader.getVector(indices))
+	{
+		return false;
+	}
+	s.objanimtime = objanimtime;
+	s.objanimcycles = objanimcycles;
+	s.objanimframes = s.objanimdata.size();
+
+	// The draw code relies on these, so a cache that does not match them is as good as no cache.
+	const size_t count = vertices.size() / 3;
+	if (vertices.size() != count * 3 || normals.size() != count * 3 || texcoords.size() != count * 2
+	    || indices.size() != s.polys.size() * 3 * MAX(1, s.numFrames))
+	{
+		return false;
+	}
+	for (uint16_t index : indices)
+	{
+		if (index >= count)
+		{
+			return false;
+		}
+	}
+
+	if (!connectors.empty())
+	{
+		s.connectors = (Vector3i *)malloc(sizeof(Vector3i) * connectors.size());
+		memcpy(s.connectors, connectors.data(), sizeof(Vector3i) * connectors.size());
+	}
+	s.nconnectors = connectors.size();
+	return true;
+}
+
 /*!
  * Load shape levels recursively
  * \param ppFileData Pointer to the data (usually read from a file)
@@ -602,11 +1003,7 @@ static iIMDShape *_imd_load_level(const WzString &filename, const char **ppFileD
 	}
 
 	// insert model
-	std::string key = filename.toStdString();
-	if (level > 0)
-	{
-		key += "_" + std::to_string(level);
-	}
+	std::string key = modelLevelKey(filename, level);
 	ASSERT(models.count(key) == 0, "Duplicate model load for %s!", key.c_str());
 	iIMDShape &s = models[key]; // create entry and return reference
 
@@ -722,46 +1119,107 @@ static iIMDShape *_imd_load_level(const WzString &filename, const char **ppFileD
 		}
 	}
 
-	// FINALLY, massage the data into what can stream directly to OpenGL
-	vertexCount = 0;
-	for (int k = 0; k < MAX(1, s.numFrames); k++)
+	*ppFileData = pFileData;
+
+	return &s;
+}
+
+static void modelCacheWriteHeader(ModelCacheWriter &writer, ModelHeader const &header, uint32_t levelCount)
+{
+	writer.put<uint32_t>(header.flags);
+	writer.put<uint8_t>(header.textured);
+	writer.putString(header.texfile);
+	writer.putString(header.normalfile);
+	writer.putString(header.specfile);
+	for (const std::string &animpie : header.animpie)
 	{
-		// Go through all polygons for each frame
-		for (const iIMDPoly &p : s.polys)
+		writer.putString(animpie);
+	}
+	writer.put<uint32_t>(header.firstLevel);
+	writer.put<uint32_t>(levelCount);
+}
+
+static bool modelCacheReadHeader(ModelCacheReader &reader, ModelHeader &header, uint32_t &levelCount)
+{
+	uint8_t textured;
+	if (!reader.get(header.flags) || !reader.get(textured) || !reader.getString(header.texfile)
+	    || !reader.getString(header.normalfile) || !reader.getString(header.specfile))
+	{
+		return false;
+	}
+	header.textured = textured != 0;
+	for (std::string &animpie : header.animpie)
+	{
+		if (!reader.getString(animpie))
 		{
-			// Do we already have the vertex data for this polygon?
-			indices.emplace_back(addVertex(s, 0, &p, k));
-			indices.emplace_back(addVertex(s, 1, &p, k));
-			indices.emplace_back(addVertex(s, 2, &p, k));
+			return false;
 		}
 	}
+	return reader.get(header.firstLevel) && reader.get(levelCount) && levelCount > 0;
+}
 
-	if (!s.buffers[VBO_VERTEX])
-		s.buffers[VBO_VERTEX] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer);
-	s.buffers[VBO_VERTEX]->upload(vertices.size() * sizeof(gfx_api::gfxFloat), vertices.data());
+/// Loads the textures and animation models named in the header, and stores them in the levels of the shape.
+static bool modelApplyHeader(const WzString &filename, iIMDShape *shape, ModelHeader const &header)
+{
+	// load texture page if specified
+	if (header.textured)
+	{
+		int texpage = iV_GetTexture(header.texfile.c_str());
+		int normalpage = iV_TEX_INVALID;
+		int specpage = iV_TEX_INVALID;
 
-	if (!s.buffers[VBO_NORMAL])
-		s.buffers[VBO_NORMAL] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer);
-	s.buffers[VBO_NORMAL]->upload(normals.size() * sizeof(gfx_api::gfxFloat), normals.data());
+		ASSERT_OR_RETURN(false, texpage >= 0, "%s could not load tex page %s", filename.toUtf8().c_str(), header.texfile.c_str());
 
-	if (!s.buffers[VBO_INDEX])
-		s.buffers[VBO_INDEX] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::index_buffer);
-	s.buffers[VBO_INDEX]->upload(indices.size() * sizeof(uint16_t), indices.data());
+		if (!header.normalfile.empty())
+		{
+			debug(LOG_TEXTURE, "Loading normal map %s for %s", header.normalfile.c_str(), filename.toUtf8().c_str());
+			normalpage = iV_GetTexture(header.normalfile.c_str(), false);
+			ASSERT_OR_RETURN(false, normalpage >= 0, "%s could not load tex page %s", filename.toUtf8().c_str(), header.normalfile.c_str());
+		}
 
-	if (!s.buffers[VBO_TEXCOORD])
-		s.buffers[VBO_TEXCOORD] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer);
-	s.buffers[VBO_TEXCOORD]->upload(texcoords.size() * sizeof(gfx_api::gfxFloat), texcoords.data());
+		if (!header.specfile.empty())
+		{
+			debug(LOG_TEXTURE, "Loading specular map %s for %s", header.specfile.c_str(), filename.toUtf8().c_str());
+			specpage = iV_GetTexture(header.specfile.c_str(), false);
+			ASSERT_OR_RETURN(false, specpage >= 0, "%s could not load tex page %s", filename.toUtf8().c_str(), header.specfile.c_str());
+		}
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0); // unbind
+		// assign tex pages and flags to all levels
+		for (iIMDShape *psShape = shape; psShape != nullptr; psShape = psShape->next)
+		{
+			psShape->texpage = texpage;
+			psShape->normalpage = normalpage;
+			psShape->specularpage = specpage;
+			psShape->flags = header.flags;
+		}
 
-	indices.resize(0);
-	vertices.resize(0);
-	texcoords.resize(0);
-	normals.resize(0);
+		// check if model should use team colour mask
+		if (header.flags & iV_IMD_TCMASK)
+		{
+			char texfile[PATH_MAX];
+			int texpage_mask;
 
-	*ppFileData = pFileData;
+			sstrcpy(texfile, header.texfile.c_str());
+			pie_MakeTexPageTCMaskName(texfile);
+			sstrcat(texfile, ".png");
+			texpage_mask = iV_GetTexture(texfile);
 
-	return &s;
+			ASSERT_OR_RETURN(false, texpage_mask >= 0, "%s could not load tcmask %s", filename.toUtf8().c_str(), texfile);
+
+			// Propagate settings through levels
+			for (iIMDShape *psShape = shape; psShape != nullptr; psShape = psShape->next)
+			{
+				psShape->tcmaskpage = texpage_mask;
+			}
+		}
+	}
+
+	// copy over model-wide animation information, stored only in the first level
+	for (int i = 0; i < ANIM_EVENT_COUNT; i++)
+	{
+		shape->objanimpie[i] = header.animpie[i].empty() ? nullptr : modelGet(WzString::fromUtf8(header.animpie[i]));
+	}
+	return true;
 }
 
 /*!
@@ -771,7 +1229,7 @@ static iIMDShape *_imd_load_level(const WzString &filename, const char **ppFileD
  * \return The shape, constructed from the data read
  */
 // ppFileData is incremented to the end of the file on exit!
-static void iV_ProcessIMD(const WzString &filename, const char **ppFileData, const char *FileDataEnd)
+static bool iV_ProcessIMD(const WzString &filename, const char **ppFileData, const char *FileDataEnd, ModelCacheWriter *cacheWriter)
 {
 	const char *pFileData = *ppFileData;
 	char buffer[PATH_MAX], texfile[PATH_MAX], normalfile[PATH_MAX], specfile[PATH_MAX];
@@ -779,8 +1237,7 @@ static void iV_ProcessIMD(const WzString &filename, const char **ppFileData, con
 	UDWORD level;
 	int32_t imd_version;
 	uint32_t imd_flags;
-	bool bTextured = false;
-	iIMDShape *objanimpie[ANIM_EVENT_COUNT];
+	ModelHeader header;
 
 	memset(normalfile, 0, sizeof(normalfile));
 	memset(specfile, 0, sizeof(specfile));
@@ -789,28 +1246,28 @@ static void iV_ProcessIMD(const WzString &filename, const char **ppFileData, con
 	{
 		debug(LOG_ERROR, "%s: bad PIE version: (%s)", filename.toUtf8().c_str(), buffer);
 		assert(false);
-		return;
+		return false;
 	}
 	pFileData += cnt;
 
 	if (strcmp(PIE_NAME, buffer) != 0)
 	{
 		debug(LOG_ERROR, "%s: Not an IMD file (%s %d)", filename.toUtf8().c_str(), buffer, imd_version);
-		return;
+		return false;
 	}
 
 	//Now supporting version PIE_VER and PIE_FLOAT_VER files
 	if (imd_version != PIE_VER && imd_version != PIE_FLOAT_VER)
 	{
 		debug(LOG_ERROR, "%s: Version %d not supported", filename.toUtf8().c_str(), imd_version);
-		return;
+		return false;
 	}
 
 	// Read flag
 	if (sscanf(pFileData, "%255s %x%n", buffer, &imd_flags, &cnt) != 2)
 	{
 		debug(LOG_ERROR, "%s: bad flags: %s", filename.toUtf8().c_str(), buffer);
-		return;
+		return false;
 	}
 	pFileData += cnt;
 
@@ -818,7 +1275,7 @@ static void iV_ProcessIMD(const WzString &filename, const char **ppFileData, con
 	if (sscanf(pFileData, "%255s %d%n", buffer, &nlevels, &cnt) != 2)
 	{
 		debug(LOG_ERROR, "%s: Expecting TEXTURE or LEVELS: %s", filename.toUtf8().c_str(), buffer);
-		return;
+		return false;
 	}
 	pFileData += cnt;
 
@@ -842,21 +1299,21 @@ static void iV_ProcessIMD(const WzString &filename, const char **ppFileData, con
 		if (sscanf(pFileData, "%255s%n", texType, &cnt) != 1)
 		{
 			debug(LOG_ERROR, "%s: Texture info corrupt: %s", filename.toUtf8().c_str(), buffer);
-			return;
+			return false;
 		}
 		pFileData += cnt;
 
 		if (strcmp(texType, "png") != 0)
 		{
 			debug(LOG_ERROR, "%s: Only png textures supported", filename.toUtf8().c_str());
-			return;
+			return false;
 		}
 		sstrcat(texfile, ".png");
 
 		if (sscanf(pFileData, "%d %d%n", &pwidth, &pheight, &cnt) != 2)
 		{
 			debug(LOG_ERROR, "%s: Bad texture size: %s", filename.toUtf8().c_str(), buffer);
-			return;
+			return false;
 		}
 		pFileData += cnt;
 
@@ -864,11 +1321,12 @@ static void iV_ProcessIMD(const WzString &filename, const char **ppFileData, con
 		if (sscanf(pFileData, "%255s %d%n", buffer, &nlevels, &cnt) != 2)
 		{
 			debug(LOG_ERROR, "%s: Bad levels info: %s", filename.toUtf8().c_str(), buffer);
-			return;
+			return false;
 		}
 		pFileData += cnt;
 
-		bTextured = true;
+		header.textured = true;
+		header.texfile = texfile;
 	}
 
 	if (strncmp(buffer, "NORMALMAP", 9) == 0)
@@ -890,22 +1348,23 @@ static void iV_ProcessIMD(const WzString &filename, const char **ppFileData, con
 		if (sscanf(pFileData, "%255s%n", texType, &cnt) != 1)
 		{
 			debug(LOG_ERROR, "%s: Normal map info corrupt: %s", filename.toUtf8().c_str(), buffer);
-			return;
+			return false;
 		}
 		pFileData += cnt;
 
 		if (strcmp(texType, "png") != 0)
 		{
 			debug(LOG_ERROR, "%s: Only png normal maps supported", filename.toUtf8().c_str());
-			return;
+			return false;
 		}
 		sstrcat(normalfile, ".png");
+		header.normalfile = normalfile;
 
 		/* Now read in LEVELS directive */
 		if (sscanf(pFileData, "%255s %d%n", buffer, &nlevels, &cnt) != 2)
 		{
 			debug(LOG_ERROR, "%s: Bad levels info: %s", filename.toUtf8().c_str(), buffer);
-			return;
+			return false;
 		}
 		pFileData += cnt;
 	}
@@ -928,50 +1387,47 @@ static void iV_ProcessIMD(const WzString &filename, const char **ppFileData, con
 		if (sscanf(pFileData, "%255s%n", texType, &cnt) != 1)
 		{
 			debug(LOG_ERROR, "%s specular map info corrupt: %s", filename.toUtf8().c_str(), buffer);
-			return;
+			return false;
 		}
 		pFileData += cnt;
 
 		if (strcmp(texType, "png") != 0)
 		{
 			debug(LOG_ERROR, "%s: only png specular maps supported", filename.toUtf8().c_str());
-			return;
+			return false;
 		}
 		sstrcat(specfile, ".png");
+		header.specfile = specfile;
 
 		/* Try -again- to read in LEVELS directive */
 		if (sscanf(pFileData, "%255s %d%n", buffer, &nlevels, &cnt) != 2)
 		{
 			debug(LOG_ERROR, "%s: Bad levels info: %s", filename.toUtf8().c_str(), buffer);
-			return;
+			return false;
 		}
 		pFileData += cnt;
 	}
 
-	for (int i = 0; i < ANIM_EVENT_COUNT; i++)
-	{
-		objanimpie[i] = nullptr;
-	}
 	while (strncmp(buffer, "EVENT", 5) == 0)
 	{
 		char animpie[PATH_MAX];
 
-		ASSERT(nlevels < ANIM_EVENT_COUNT && nlevels >= 0, "Invalid event type %d", nlevels);
+		ASSERT_OR_RETURN(false, nlevels < ANIM_EVENT_COUNT && nlevels >= 0, "Invalid event type %d", nlevels);
 		pFileData++;
 		if (sscanf(pFileData, "%255s%n", animpie, &cnt) != 1)
 		{
 			debug(LOG_ERROR, "%s animation model corrupt: %s", filename.toUtf8().c_str(), buffer);
-			return;
+			return false;
 		}
 		pFileData += cnt;
 
-		objanimpie[nlevels] = modelGet(animpie);
+		header.animpie[nlevels] = animpie;
 
 		/* Try -yet again- to read in LEVELS directive */
 		if (sscanf(pFileData, "%255s %d%n", buffer, &nlevels, &cnt) != 2)
 		{
 			debug(LOG_ERROR, "%s: Bad levels info: %s", filename.toUtf8().c_str(), buffer);
-			return;
+			return false;
 		}
 		pFileData += cnt;
 	}
@@ -979,14 +1435,14 @@ static void iV_ProcessIMD(const WzString &filename, const char **ppFileData, con
 	if (strncmp(buffer, "LEVELS", 6) != 0)
 	{
 		debug(LOG_ERROR, "%s: Expecting 'LEVELS' directive (%s)", filename.toUtf8().c_str(), buffer);
-		return;
+		return false;
 	}
 
 	/* Read first LEVEL directive */
 	if (sscanf(pFileData, "%255s %u%n", buffer, &level, &cnt) != 2)
 	{
 		debug(LOG_ERROR, "(_load_level) file corrupt -J");
-		return;
+		return false;
 	}
 	pFileData += cnt;
 	level--; // make zero indexed
@@ -994,72 +1450,86 @@ static void iV_ProcessIMD(const WzString &filename, const char **ppFileData, con
 	if (strncmp(buffer, "LEVEL", 5) != 0)
 	{
 		debug(LOG_ERROR, "%s: Expecting 'LEVEL' directive (%s)", filename.toUtf8().c_str(), buffer);
-		return;
+		return false;
 	}
 
 	iIMDShape *shape = _imd_load_level(filename, &pFileData, FileDataEnd, nlevels, imd_version, level);
 	if (shape == nullptr)
 	{
 		debug(LOG_ERROR, "%s: Unsuccessful", filename.toUtf8().c_str());
-		return;
+		return false;
 	}
+	header.flags = imd_flags;
+	header.firstLevel = level;
 
-	// load texture page if specified
-	if (bTextured)
+	uint32_t levelCount = 0;
+	for (iIMDShape *psShape = shape; psShape != nullptr; psShape = psShape->next)
 	{
-		int texpage = iV_GetTexture(texfile);
-		int normalpage = iV_TEX_INVALID;
-		int specpage = iV_TEX_INVALID;
-
-		ASSERT_OR_RETURN(, texpage >= 0, "%s could not load tex page %s", filename.toUtf8().c_str(), texfile);
-
-		if (normalfile[0] != '\0')
+		++levelCount;
+	}
+	if (cacheWriter != nullptr)
+	{
+		modelCacheWriteHeader(*cacheWriter, header, levelCount);
+	}
+	for (iIMDShape *psShape = shape; psShape != nullptr; psShape = psShape->next)
+	{
+		_imd_build_buffers(*psShape);
+		_imd_upload_buffers(*psShape);
+		if (cacheWriter != nullptr)
 		{
-			debug(LOG_TEXTURE, "Loading normal map %s for %s", normalfile, filename.toUtf8().c_str());
-			normalpage = iV_GetTexture(normalfile, false);
-			ASSERT_OR_RETURN(, normalpage >= 0, "%s could not load tex page %s", filename.toUtf8().c_str(), normalfile);
+			modelCacheWriteLevel(*cacheWriter, *psShape);
 		}
+		_imd_clear_buffers();
+	}
 
-		if (specfile[0] != '\0')
-		{
-			debug(LOG_TEXTURE, "Loading specular map %s for %s", specfile, filename.toUtf8().c_str());
-			specpage = iV_GetTexture(specfile, false);
-			ASSERT_OR_RETURN(, specpage >= 0, "%s could not load tex page %s", filename.toUtf8().c_str(), specfile);
-		}
+	*ppFileData = pFileData;
 
-		// assign tex pages and flags to all levels
-		for (iIMDShape *psShape = shape; psShape != nullptr; psShape = psShape->next)
+	return modelApplyHeader(filename, shape, header);
+}
+
+static bool modelCacheRead(const WzString &filename, std::vector<char> const &blob)
+{
+	ModelCacheReader reader(blob.data(), blob.data() + blob.size());
+	ModelHeader header;
+	uint32_t levelCount = 0;
+	if (!modelCacheReadHeader(reader, header, levelCount))
+	{
+		return false;
+	}
+
+	std::vector<std::string> keys;
+	iIMDShape *shape = nullptr;
+	iIMDShape **link = &shape;
+	bool ok = true;
+	for (uint32_t i = 0; ok && i < levelCount; ++i)
+	{
+		std::string key = modelLevelKey(filename, header.firstLevel + i);
+		if (models.count(key) > 0)
 		{
-			psShape->texpage = texpage;
-			psShape->normalpage = normalpage;
-			psShape->specularpage = specpage;
-			psShape->flags = imd_flags;
+			ok = false;
+			break;
 		}
-
-		// check if model should use team colour mask
-		if (imd_flags & iV_IMD_TCMASK)
+		iIMDShape &s = models[key];
+		keys.push_back(key);
+		*link = &s;
+		link = &s.next;
+		ok = modelCacheReadLevel(reader, s);
+		if (ok)
 		{
-			int texpage_mask;
-
-			pie_MakeTexPageTCMaskName(texfile);
-			sstrcat(texfile, ".png");
-			texpage_mask = iV_GetTexture(texfile);
-
-			ASSERT_OR_RETURN(, texpage_mask >= 0, "%s could not load tcmask %s", filename.toUtf8().c_str(), texfile);
-
-			// Propagate settings through levels
-			for (iIMDShape *psShape = shape; psShape != nullptr; psShape = psShape->next)
-			{
-				psShape->tcmaskpage = texpage_mask;
-			}
+			_imd_upload_buffers(s);
 		}
+		_imd_clear_buffers();
 	}
-
-	// copy over model-wide animation information, stored only in the first level
-	for (int i = 0; i < ANIM_EVENT_COUNT; i++)
+	if (!ok || !reader.atEnd())
 	{
-		shape->objanimpie[i] = objanimpie[i];
+		for (const std::string &key : keys)
+		{
+			models.erase(key);
+		}
+		return false;
 	}
 
-	*ppFileData = pFileData;
+	// Whether or not the textures load, the model is as loaded as parsing would have left it.
+	modelApplyHeader(filename, shape, header);
+	return true;
 }
@@ -109,7 +109,7 @@ void GFX::makeTexture(int width, int height, GLenum filter, const gfx_api::pixel
 	mFormat = format;
 }
 
-void GFX::updateTexture(const void *image, int width, int height)
+void GFX::updateTexture(const void *image, int width, int height, int offsetX, int offsetY)
 {
 	ASSERT(mType == GFX_TEXTURE, "Wrong GFX type");
 	if (width == -1)
@@ -121,7 +121,7 @@ void GFX::updateTexture(const void *image, int width, int height)
 		height = mHeight;
 	}
 	pie_SetTexturePage(TEXPAGE_EXTERN);
-	mTexture->upload(0u, 0u, 0u, width, height, mFormat, image);
+	mTexture->upload(0u, offsetX, offsetY, width, height, mFormat, image);
 }
 
 void GFX::buffers(int vertices, const GLvoid *vertBuf, const GLvoid *auxBuf)
@@ -151,13 +151,13 @@ void GFX::buffers(int vertices, const GLvoid *vertBuf, const GLvoid *auxBuf)
 #define VERTEX_COORDS_ATTRIB_INDEX 1
 #define VERTEX_COLOR_ATTRIB_INDEX 2
 
-void GFX::draw(const glm::mat4 &modelViewProjectionMatrix)
+void GFX::draw(const glm::mat4 &modelViewProjectionMatrix, const glm::vec4 &colour)
 {
 	if (mType == GFX_TEXTURE)
 	{
 		pie_SetTexturePage(TEXPAGE_EXTERN);
 		mTexture->bind();
-		pie_ActivateShader(SHADER_GFX_TEXT, modelViewProjectionMatrix, glm::vec4(1), 0);
+		pie_ActivateShader(SHADER_GFX_TEXT, modelViewProjectionMatrix, colour, 0);
 		mBuffers[VBO_TEXCOORD]->bind();
 		glVertexAttribPointer(VERTEX_COORDS_ATTRIB_INDEX, 2, GL_FLOAT, false, 0, nullptr);
 		glEnableVertexAttribArray(VERTEX_COORDS_ATTRIB_INDEX);
@@ -405,17 +405,6 @@ void iV_DrawImage(GLuint TextureID, Vector2i Position, Vector2f offset, Vector2f
 	iv_DrawImageImpl(offset, size, Vector2f(0.f, 0.f), Vector2f(1.f, 1.f), colour, mvp);
 }
 
-void iV_DrawImageText(gfx_api::texture& TextureID, Vector2i Position, Vector2f offset, Vector2f size, float angle, REND_MODE mode, PIELIGHT colour)
-{
-	pie_SetRendMode(mode);
-	pie_SetTexturePage(TEXPAGE_EXTERN);
-	TextureID.bind();
-
-	glm::mat4 mvp = defaultProjectionMatrix() * glm::translate(glm::vec3(Position.x, Position.y, 0)) * glm::rotate(RADIANS(angle), glm::vec3(0.f, 0.f, 1.f));
-
-	iv_DrawImageImpl(offset, size, Vector2f(0.f, 0.f), Vector2f(1.f, 1.f), colour, mvp, SHADER_TEXT);
-}
-
 static void pie_DrawImage(IMAGEFILE *imageFile, int id, Vector2i size, const PIERECT *dest, PIELIGHT colour, const glm::mat4 &modelViewProjection, Vector2i textureInset = Vector2i(0, 0))
 {
 	ImageDef const &image2 = imageFile->imageDefs[id];
@@ -639,6 +628,122 @@ void iV_DrawImageRepeatY(IMAGEFILE *ImageFile, UWORD ID, int x, int y, int Heigh
 	pBatchedRequests->draw();
 }
 
+ScreenLayer::ScreenLayer()
+{
+}
+
+ScreenLayer::~ScreenLayer()
+{
+	release();
+}
+
+void ScreenLayer::release()
+{
+	if (mFramebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &mFramebuffer);
+		mFramebuffer = 0;
+	}
+	if (mDepthbuffer != 0)
+	{
+		glDeleteRenderbuffers(1, &mDepthbuffer);
+		mDepthbuffer = 0;
+	}
+	delete mGfx;
+	mGfx = nullptr;
+	mTexWidth = 0;
+	mTexHeight = 0;
+	mScreenSize = Vector2i(0, 0);
+}
+
+bool ScreenLayer::matches(int x, int y, int width, int height) const
+{
+	return mGfx != nullptr && mRect == WzRect(x, y, width, height)
+	       && mScreenSize == Vector2i(pie_GetVideoBufferWidth(), pie_GetVideoBufferHeight());
+}
+
+bool ScreenLayer::begin(int x, int y, int width, int height)
+{
+	if (!GLEW_VERSION_3_0 && !GLEW_ARB_framebuffer_object)
+	{
+		return false;
+	}
+	if (width <= 0 || height <= 0)
+	{
+		return false;
+	}
+
+	// The screen is drawn in video buffer coordinates, but the viewport is in actual pixels.
+	glGetIntegerv(GL_VIEWPORT, mSavedViewport);
+	const float scaleX = (float)mSavedViewport[2] / std::max<int>(pie_GetVideoBufferWidth(), 1);
+	const float scaleY = (float)mSavedViewport[3] / std::max<int>(pie_GetVideoBufferHeight(), 1);
+	const int texWidth = std::max((int)ceilf(width * scaleX), 1);
+	const int texHeight = std::max((int)ceilf(height * scaleY), 1);
+
+	if (texWidth == mFailedWidth && texHeight == mFailedHeight)
+	{
+		return false;  // Already failed at this size, so just draw directly.
+	}
+	if (mGfx == nullptr || texWidth != mTexWidth || texHeight != mTexHeight)
+	{
+		release();
+		mGfx = new GFX(GFX_TEXTURE, GL_TRIANGLE_STRIP, 2);
+		mGfx->makeTexture(texWidth, texHeight, GL_NEAREST, gfx_api::pixel_format::rgba);
+		mTexWidth = texWidth;
+		mTexHeight = texHeight;
+
+		glGenRenderbuffers(1, &mDepthbuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, mDepthbuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, texWidth, texHeight);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &mSavedFramebuffer);
+		glGenFramebuffers(1, &mFramebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mGfx->getTexture()->id(), 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mDepthbuffer);
+		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, mSavedFramebuffer);
+		if (status != GL_FRAMEBUFFER_COMPLETE)
+		{
+			debug(LOG_WARNING, "Offscreen layer of %dx%d not supported (status 0x%x)", texWidth, texHeight, status);
+			release();
+			mFailedWidth = texWidth;
+			mFailedHeight = texHeight;
+			return false;
+		}
+	}
+
+	mRect = WzRect(x, y, width, height);
+	mScreenSize = Vector2i(pie_GetVideoBufferWidth(), pie_GetVideoBufferHeight());
+
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &mSavedFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	// Keep the screen projection, but move the viewport so that our rectangle ends up in the layer.
+	glViewport(-(GLint)(x * scaleX), -(GLint)(mSavedViewport[3] - (y + height) * scaleY), mSavedViewport[2], mSavedViewport[3]);
+	glClearColor(0.f, 0.f, 0.f, 0.f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	return true;
+}
+
+void ScreenLayer::end()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, mSavedFramebuffer);
+	glViewport(mSavedViewport[0], mSavedViewport[1], mSavedViewport[2], mSavedViewport[3]);
+}
+
+void ScreenLayer::draw()
+{
+	ASSERT_OR_RETURN(, mGfx != nullptr, "Nothing drawn into layer");
+	const gfx_api::gfxFloat x0 = mRect.x(), y0 = mRect.y(), x1 = mRect.x() + mRect.width(), y1 = mRect.y() + mRect.height();
+	// The layer is upside down, like everything rendered by OpenGL.
+	gfx_api::gfxFloat texcoords[] = { 0.0f, 1.0f,  1.0f, 1.0f,  0.0f, 0.0f,  1.0f, 0.0f };
+	gfx_api::gfxFloat vertices[] = { x0, y0,  x1, y0,  x0, y1,  x1, y1 };
+	mGfx->buffers(4, vertices, texcoords);
+	pie_SetRendMode(REND_PREMULTIPLIED);
+	mGfx->draw(defaultProjectionMatrix());
+}
+
 bool pie_InitRadar()
 {
 	radarGfx = new GFX(GFX_TEXTURE, GL_TRIANGLE_STRIP, 2);
@@ -661,10 +766,10 @@ void pie_SetRadar(gfx_api::gfxFloat x, gfx_api::gfxFloat y, gfx_api::gfxFloat wi
 	radarGfx->buffers(4, vertices, texcoords);
 }
 
-/** Store radar texture with given width and height. */
-void pie_DownLoadRadar(UDWORD *buffer)
+/** Store numRows full-width rows of the radar texture, starting at firstRow. */
+void pie_DownLoadRadar(const UDWORD *rows, int firstRow, int numRows)
 {
-	radarGfx->updateTexture(buffer);
+	radarGfx->updateTexture(rows, -1, numRows, 0, firstRow);
 }
 
 /** Display radar texture using the given height and width, depending on zoom level. */
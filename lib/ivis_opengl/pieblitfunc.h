@@ -35,6 +35,7 @@
 #include "lib/framework/frame.h"
 #include "lib/framework/string_ext.h"
 #include "lib/framework/vector.h"
+#include "lib/framework/geometry.h"
 #include "lib/framework/wzstring.h"
 #include <glm/mat4x4.hpp>
 #include "piedef.h"
@@ -87,14 +88,21 @@ public:
 	/// then that memory buffer is uploaded to the GPU.
 	void makeTexture(int width, int height, GLenum filter = GL_LINEAR, const gfx_api::pixel_format& format = gfx_api::pixel_format::rgba, const GLvoid *image = nullptr);
 
-	/// Upload given memory buffer to already allocated texture space on the GPU
-	void updateTexture(const GLvoid *image, int width = -1, int height = -1);
+	/// Upload given memory buffer to already allocated texture space on the GPU, optionally
+	/// only to the sub-rectangle starting at (offsetX, offsetY). The buffer must be tightly packed.
+	void updateTexture(const GLvoid *image, int width = -1, int height = -1, int offsetX = 0, int offsetY = 0);
 
 	/// Upload vertex and texture buffer data to the GPU
 	void buffers(int vertices, const GLvoid *vertBuf, const GLvoid *texBuf);
 
-	/// Draw everything
-	void draw(const glm::mat4 &modelViewProjectionMatrix);
+	/// Draw everything, modulating textured GFX by the given colour
+	void draw(const glm::mat4 &modelViewProjectionMatrix, const glm::vec4 &colour = glm::vec4(1));
+
+	/// The texture allocated by makeTexture() or loadTexture(), if any
+	gfx_api::texture *getTexture()
+	{
+		return mTexture;
+	}
 
 private:
 	GFXTYPE mType;
@@ -108,6 +116,42 @@ private:
 	int mSize;
 };
 
+/// An offscreen copy of a rectangle of the screen. Anything drawn between begin() and end() goes into the
+/// layer instead of onto the screen, at the same place, and draw() then puts it on the screen as it was.
+class ScreenLayer
+{
+public:
+	ScreenLayer();
+	~ScreenLayer();
+
+	/// Start drawing into the layer, which is cleared first. Returns false if offscreen drawing is not
+	/// supported, in which case nothing was changed and end() must not be called.
+	bool begin(int x, int y, int width, int height);
+	/// Stop drawing into the layer, and go back to drawing on the screen.
+	void end();
+	/// Put the contents of the layer on the screen, at the rectangle it was drawn for.
+	void draw();
+
+	/// Whether the layer holds something that was drawn for the given rectangle at the current screen size.
+	bool matches(int x, int y, int width, int height) const;
+
+private:
+	void release();
+
+	GFX *mGfx = nullptr;
+	GLuint mFramebuffer = 0;
+	GLuint mDepthbuffer = 0;
+	int mTexWidth = 0, mTexHeight = 0;
+	int mFailedWidth = 0, mFailedHeight = 0;  ///< Size the framebuffer was last found incomplete at, so it isn't tried again every frame.
+	WzRect mRect;
+	Vector2i mScreenSize = Vector2i(0, 0);
+	GLint mSavedFramebuffer = 0;
+	GLint mSavedViewport[4] = {0, 0, 0, 0};
+
+	ScreenLayer(ScreenLayer const &) = delete;
+	ScreenLayer &operator =(ScreenLayer const &) = delete;
+};
+
 /***************************************************************************/
 /*
  *	Global ProtoTypes
@@ -195,7 +239,6 @@ private:
 	std::list<PieDrawImageRequest> _imageDrawRequests;
 };
 void iV_DrawImage(GLuint TextureID, Vector2i position, Vector2f offset, Vector2i size, float angle, REND_MODE mode, PIELIGHT colour);
-void iV_DrawImageText(gfx_api::texture& TextureID, Vector2i Position, Vector2f offset, Vector2f size, float angle, REND_MODE mode, PIELIGHT colour);
 void iV_DrawImage(IMAGEFILE *ImageFile, UWORD ID, int x, int y, const glm::mat4 &modelViewProjection = defaultProjectionMatrix(), BatchedImageDrawRequests* pBatchedRequests = nullptr);
 void iV_DrawImage2(const WzString &filename, float x, float y, float width = -0.0f, float height = -0.0f);
 void iV_DrawImageTc(Image image, Image imageTc, int x, int y, PIELIGHT colour, const glm::mat4 &modelViewProjection = defaultProjectionMatrix());
@@ -216,7 +259,7 @@ void pie_UniTransBoxFill(float x0, float y0, float x1, float y1, PIELIGHT colour
 
 bool pie_InitRadar();
 bool pie_ShutdownRadar();
-void pie_DownLoadRadar(UDWORD *buffer);
+void pie_DownLoadRadar(const UDWORD *rows, int firstRow, int numRows);
 void pie_RenderRadar(const glm::mat4 &modelViewProjectionMatrix);
 void pie_SetRadar(gfx_api::gfxFloat x, gfx_api::gfxFloat y, gfx_api::gfxFloat width, gfx_api::gfxFloat height, int twidth, int theight);
 
@@ -976,14 +976,16 @@ void pie_SetRendMode(REND_MODE rendMode)
 			glDisable(GL_BLEND);
 			break;
 
+		// The alpha channel is blended separately, so that things drawn into a ScreenLayer end up with the
+		// premultiplied alpha needed to composite the layer later.
 		case REND_ALPHA:
 			glEnable(GL_BLEND);
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 			break;
 
 		case REND_ADDITIVE:
 			glEnable(GL_BLEND);
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+			glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE, GL_ZERO, GL_ONE);
 			break;
 
 		case REND_MULTIPLICATIVE:
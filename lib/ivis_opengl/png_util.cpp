@@ -25,6 +25,9 @@
 #include <png.h>
 #include <physfs.h>
 #include "lib/framework/physfs_ext.h"
+#include "lib/framework/wzapp.h"
+#include <string>
+#include <unordered_map>
 
 #define PNG_BYTES_TO_CHECK 8
 
@@ -89,6 +92,9 @@ static inline void PNGWriteCleanup(png_infop *info_ptr, png_structp *png_ptr, PH
 MSVC_PRAGMA(warning( push )) // see matching "pop" below
 MSVC_PRAGMA(warning( disable : 4611 ))
 
+static wz::mutex preloadedImagesMutex;
+static std::unordered_map<std::string, iV_Image> preloadedImages;	///< Decoded by iV_preloadImage_PNG, until claimed
+
 bool iV_loadImage_PNG(const char *fileName, iV_Image *image)
 {
 	unsigned char PNGheader[PNG_BYTES_TO_CHECK];
@@ -97,6 +103,17 @@ bool iV_loadImage_PNG(const char *fileName, iV_Image *image)
 	png_structp png_ptr = nullptr;
 	png_infop info_ptr = nullptr;
 
+	{
+		std::lock_guard<wz::mutex> lock(preloadedImagesMutex);
+		auto it = preloadedImages.find(fileName);
+		if (it != preloadedImages.end())
+		{
+			*image = it->second;
+			preloadedImages.erase(it);
+			return true;
+		}
+	}
+
 	// Open file
 	PHYSFS_file *fileHandle = PHYSFS_openRead(fileName);
 	ASSERT_OR_RETURN(false, fileHandle != nullptr, "Could not open %s: %s", fileName, WZ_PHYSFS_getLastError());
@@ -190,6 +207,32 @@ bool iV_loadImage_PNG(const char *fileName, iV_Image *image)
 	return true;
 }
 
+void iV_preloadImage_PNG(const char *fileName)
+{
+	iV_Image image;
+	if (!iV_loadImage_PNG(fileName, &image))
+	{
+		return;
+	}
+
+	std::lock_guard<wz::mutex> lock(preloadedImagesMutex);
+	auto inserted = preloadedImages.insert(std::make_pair(std::string(fileName), image));
+	if (!inserted.second)
+	{
+		free(image.bmp);  // Already preloaded
+	}
+}
+
+void iV_discardPreloadedImages()
+{
+	std::lock_guard<wz::mutex> lock(preloadedImagesMutex);
+	for (auto &preloaded : preloadedImages)
+	{
+		free(preloaded.second.bmp);
+	}
+	preloadedImages.clear();
+}
+
 // Note: This function must be thread-safe.
 //       It does not call the debug() macro directly, but instead returns an IMGSaveError structure with the text of any error.
 static IMGSaveError internal_saveImage_PNG(const char *fileName, const iV_Image *image, int color_type)
@@ -50,6 +50,21 @@ struct IMGSaveError
  */
 bool iV_loadImage_PNG(const char *fileName, iV_Image *image);
 
+/*!
+ * Decode a PNG ahead of time, so that the next iV_loadImage_PNG of the same file
+ * only has to take the result
+ *
+ * This function is safe to call from any thread
+ *
+ * \param fileName input file to load from
+ */
+void iV_preloadImage_PNG(const char *fileName);
+
+/*!
+ * Free the preloaded images that nobody asked for
+ */
+void iV_discardPreloadedImages();
+
 /*!
  * Save a PNG from image into file
  *
@@ -21,6 +21,7 @@
 #include "lib/framework/frame.h"
 #include "lib/framework/file.h"
 #include "lib/framework/opengl.h"
+#include "lib/framework/fixedpoint.h"
 #include <stdlib.h>
 #include <string.h>
 #include "lib/framework/string_ext.h"
@@ -33,9 +34,13 @@
 #include "lib/ivis_opengl/bitimage.h"
 #include "src/multiplay.h"
 #include <algorithm>
-#include <numeric>
 #include <array>
+#include <list>
 #include <physfs.h>
+#ifndef GLM_ENABLE_EXPERIMENTAL
+	#define GLM_ENABLE_EXPERIMENTAL
+#endif
+#include <glm/gtx/transform.hpp>
 
 #define ASCII_SPACE			(32)
 #define ASCII_NEWLINE			('@')
@@ -205,6 +210,27 @@ struct FTFace
 		};
 	}
 
+	/// A rasterized glyph kept for reuse, together with its location in the glyph atlas
+	struct CachedGlyph
+	{
+		RasterizedGlyph raster;
+		Vector2i atlasPosition = Vector2i(0, 0);
+		uint32_t atlasGeneration = 0; ///< atlasPosition is only valid while this matches glyphAtlasGeneration
+	};
+
+	// Returns the rasterized glyph, rendering it on first use
+	CachedGlyph &getCached(uint32_t codePoint, Vector2i subpixeloffset64)
+	{
+		const uint64_t key = (uint64_t)codePoint << 16 | (uint64_t)((subpixeloffset64.x + 64) & 0xff) << 8 | ((subpixeloffset64.y + 64) & 0xff);
+		auto it = glyphCache.find(key);
+		if (it == glyphCache.end())
+		{
+			it = glyphCache.emplace(key, CachedGlyph()).first;
+			it->second.raster = get(codePoint, subpixeloffset64);
+		}
+		return it->second;
+	}
+
 	operator FT_Face()
 	{
 		return m_face;
@@ -217,6 +243,7 @@ struct FTFace
 
 private:
 	FT_Face m_face;
+	std::unordered_map<uint64_t, CachedGlyph> glyphCache;
 };
 
 struct FTlib
@@ -253,33 +280,32 @@ struct TextLayoutMetrics
 	uint32_t height;
 };
 
-struct RenderedText
+/// A shaped and measured string, ready to be drawn from the glyph atlas
+struct ShapedRun
 {
-	RenderedText(std::unique_ptr<unsigned char[]> &&_data, uint32_t _width, uint32_t _height, int32_t _offset_x, int32_t _offset_y)
-	: data(std::move(_data)), width(_width), height(_height), offset_x(_offset_x), offset_y(_offset_y)
-	{ }
+	struct Glyph
+	{
+		uint32_t codePoint;
+		Vector2i subpixelOffset;
+		Vector2i position; ///< Top left corner *IN PIXELS*, relative to the pen origin
+		Vector2i size;     ///< *IN PIXELS*
+	};
 
-	RenderedText() : data(nullptr) , width(0) , height(0) , offset_x(0) , offset_y(0)
-	{ }
+	std::vector<Glyph> glyphs;
+	TextLayoutMetrics layoutMetrics;
 
-	std::unique_ptr<unsigned char[]> data;
-	uint32_t width;
-	uint32_t height;
-	int32_t offset_x;
-	int32_t offset_y;
+	// Two triangles per glyph *IN POINTS*, and their atlas coordinates. Rebuilt whenever the atlas is emptied.
+	std::vector<gfx_api::gfxFloat> vertices;
+	std::vector<gfx_api::gfxFloat> texCoords;
+	uint32_t atlasGeneration = 0;
 };
 
-struct DrawTextResult
+// Glyphs are rasterized at quarter pixel offsets only, so that a glyph needs at most a few atlas entries
+static Vector2i quantizeSubpixelOffset(Vector2i penPosition)
 {
-	DrawTextResult(RenderedText &&_text, TextLayoutMetrics _layoutMetrics) : text(std::move(_text)), layoutMetrics(_layoutMetrics)
-	{ }
-
-	DrawTextResult()
-	{ }
-
-	RenderedText text;
-	TextLayoutMetrics layoutMetrics;
-};
+	const Vector2i offset = penPosition % 64;
+	return Vector2i(offset.x / 16 * 16, offset.y / 16 * 16);
+}
 
 // Note:
 // Technically glyph antialiasing is dependent of text rotation.
@@ -298,49 +324,16 @@ struct TextShaper
 		hb_buffer_destroy(m_buffer);
 	}
 
-	// Returns the text width and height *IN PIXELS*
-	TextLayoutMetrics getTextMetrics(const TextRun& text, FTFace &face)
+	// Shapes the text and measures its bounds *IN PIXELS*
+	void layoutText(const TextRun& text, FTFace &face, ShapedRun &run)
 	{
 		const ShapingResult &shapingResult = shapeText(text, face);
-		if (shapingResult.glyphes.empty())
-		{
-			return TextLayoutMetrics(shapingResult.x_advance / 64, shapingResult.y_advance / 64);
-		}
-
-		int32_t min_x;
-		int32_t max_x;
-		int32_t min_y;
-		int32_t max_y;
-
-		std::tie(min_x, max_x, min_y, max_y) = std::accumulate(shapingResult.glyphes.begin(), shapingResult.glyphes.end(), std::make_tuple(1000, -1000, 1000, -1000),
-			[&face] (const std::tuple<int32_t, int32_t, int32_t, int32_t> &bounds, const HarfbuzzPosition &g) {
-			RasterizedGlyph glyph = face.get(g.codepoint, g.penPosition % 64);
-			int32_t x0 = g.penPosition.x / 64 + glyph.bearing_x;
-			int32_t y0 = g.penPosition.y / 64 - glyph.bearing_y;
-			return std::make_tuple(
-				std::min(x0, std::get<0>(bounds)),
-				std::max(static_cast<int32_t>(x0 + glyph.width), std::get<1>(bounds)),
-				std::min(y0, std::get<2>(bounds)),
-				std::max(static_cast<int32_t>(y0 + glyph.height), std::get<3>(bounds))
-				);
-			});
-
-		const uint32_t texture_width = max_x - min_x + 1;
-		const uint32_t texture_height = max_y - min_y + 1;
 		const uint32_t x_advance = (shapingResult.x_advance / 64);
 		const uint32_t y_advance = (shapingResult.y_advance / 64);
-
-		// return the maximum of the x_advance / y_advance (converted from harfbuzz units) and the texture dimensions
-		return TextLayoutMetrics(std::max(texture_width, x_advance), std::max(texture_height, y_advance));
-	}
-
-	// Draws the text and returns the text buffer, width and height, etc *IN PIXELS*
-	DrawTextResult drawText(const TextRun& text, FTFace &face)
-	{
-		const ShapingResult &shapingResult = shapeText(text, face);
 		if (shapingResult.glyphes.empty())
 		{
-			return DrawTextResult(RenderedText(), TextLayoutMetrics(shapingResult.x_advance / 64, shapingResult.y_advance / 64));
+			run.layoutMetrics = TextLayoutMetrics(x_advance, y_advance);
+			return;
 		}
 
 		int32_t min_x = 1000;
@@ -348,61 +341,25 @@ struct TextShaper
 		int32_t min_y = 1000;
 		int32_t max_y = -1000;
 
-		// build glyphes
-		struct glyphRaster
+		run.glyphs.reserve(shapingResult.glyphes.size());
+		for (const HarfbuzzPosition &g : shapingResult.glyphes)
 		{
-			std::unique_ptr<unsigned char[]> buffer;
-			Vector2i pixelPosition;
-			Vector2i size;
-			uint32_t pitch;
-
-			glyphRaster(std::unique_ptr<unsigned char[]> &&b, Vector2i &&p, Vector2i &&s, uint32_t _pitch)
-				: buffer(std::move(b)), pixelPosition(p), size(s), pitch(_pitch) {}
-		};
-
-		std::vector<glyphRaster> glyphs;
-		std::transform(shapingResult.glyphes.begin(), shapingResult.glyphes.end(), std::back_inserter(glyphs),
-			[&] (const HarfbuzzPosition &g) {
-			RasterizedGlyph glyph = face.get(g.codepoint, g.penPosition % 64);
+			const Vector2i subpixelOffset = quantizeSubpixelOffset(g.penPosition);
+			const RasterizedGlyph &glyph = face.getCached(g.codepoint, subpixelOffset).raster;
 			int32_t x0 = g.penPosition.x / 64 + glyph.bearing_x;
 			int32_t y0 = g.penPosition.y / 64 - glyph.bearing_y;
 			min_x = std::min(x0, min_x);
 			max_x = std::max(static_cast<int32_t>(x0 + glyph.width), max_x);
 			min_y = std::min(y0, min_y);
 			max_y = std::max(static_cast<int32_t>(y0 + glyph.height), max_y);
-			return glyphRaster(std::move(glyph.buffer), Vector2i(x0, y0), Vector2i(glyph.width, glyph.height), glyph.pitch);
-			});
+			run.glyphs.push_back({g.codepoint, subpixelOffset, Vector2i(x0, y0), Vector2i(glyph.width, glyph.height)});
+		}
 
 		const uint32_t texture_width = max_x - min_x + 1;
 		const uint32_t texture_height = max_y - min_y + 1;
-		const uint32_t x_advance = (shapingResult.x_advance / 64);
-		const uint32_t y_advance = (shapingResult.y_advance / 64);
-
-		std::unique_ptr<unsigned char[]> stringTexture(new unsigned char[4 * texture_width * texture_height]);
-		memset(stringTexture.get(), 0, 4 * texture_width * texture_height);
 
-		std::for_each(glyphs.begin(), glyphs.end(),
-			[&](const glyphRaster &g)
-			{
-				for (int i = 0; i < g.size.y; ++i)
-				{
-					uint32_t i0 = g.pixelPosition.y - min_y;
-					for (int j = 0; j < g.size.x; ++j)
-					{
-						uint32_t j0 = g.pixelPosition.x - min_x;
-						uint8_t const *src = &g.buffer[i * g.pitch + 3 * j];
-						uint8_t *dst = &stringTexture[4 * ((i0 + i) * texture_width + j + j0)];
-						dst[0] = std::min(dst[0] + src[0], 255);
-						dst[1] = std::min(dst[1] + src[1], 255);
-						dst[2] = std::min(dst[2] + src[2], 255);
-						dst[3] = std::min(dst[3] + ((src[0] * 77 + src[1] * 150 + src[2] * 29) >> 8), 255);
-					}
-				}
-			});
-		return DrawTextResult(
-				RenderedText(std::move(stringTexture), texture_width, texture_height, min_x, min_y),
-				TextLayoutMetrics(std::max(texture_width, x_advance), std::max(texture_height, y_advance))
-		);
+		// the maximum of the x_advance / y_advance (converted from harfbuzz units) and the text bounds
+		run.layoutMetrics = TextLayoutMetrics(std::max(texture_width, x_advance), std::max(texture_height, y_advance));
 	}
 
 public:
@@ -521,10 +478,195 @@ static FTFace &getFTFace(iV_fonts FontID)
 	}
 }
 
-static gfx_api::texture* textureID = nullptr;
-
 const GLint text_filtering = GL_LINEAR;
 
+/***************************************************************************/
+/*
+ *	Glyph atlas and shaped run cache
+ */
+/***************************************************************************/
+
+#define GLYPH_ATLAS_SIZE		1024
+#define SHAPED_RUN_CACHE_SIZE		2048
+
+static GFX *glyphAtlas = nullptr;		///< Every glyph on screen, so that a string is drawn as one batch of quads
+static uint32_t glyphAtlasGeneration = 0;	///< Bumped whenever the atlas is emptied, invalidating all atlas positions
+static int glyphAtlasShelfX = 0;		///< Next free column on the current shelf
+static int glyphAtlasShelfY = 0;		///< Top row of the current shelf
+static int glyphAtlasShelfHeight = 0;		///< Height of the tallest glyph on the current shelf
+
+struct ShapedRunKey
+{
+	iV_fonts fontID;
+	std::string text;
+
+	bool operator ==(const ShapedRunKey &other) const
+	{
+		return fontID == other.fontID && text == other.text;
+	}
+};
+
+struct ShapedRunKeyHash
+{
+	size_t operator()(const ShapedRunKey &key) const
+	{
+		return std::hash<std::string>()(key.text) * 31 + key.fontID;
+	}
+};
+
+typedef std::list<std::pair<ShapedRunKey, std::shared_ptr<ShapedRun>>> ShapedRunList;
+static ShapedRunList shapedRuns;	///< Most recently used first
+static std::unordered_map<ShapedRunKey, ShapedRunList::iterator, ShapedRunKeyHash> shapedRunIndex;
+
+// Returns the shaped run for the text, shaping it on a cache miss.
+// The cache is emptied whenever the fonts are reloaded, so the scale factor is implicitly part of the key.
+static std::shared_ptr<ShapedRun> getShapedRun(const std::string &text, iV_fonts fontID)
+{
+	ShapedRunKey key = {fontID, text};
+	auto it = shapedRunIndex.find(key);
+	if (it != shapedRunIndex.end())
+	{
+		shapedRuns.splice(shapedRuns.begin(), shapedRuns, it->second);
+		return it->second->second;
+	}
+
+	std::shared_ptr<ShapedRun> run = std::make_shared<ShapedRun>();
+	TextRun tr(text, "en", HB_SCRIPT_COMMON, HB_DIRECTION_LTR);
+	getShaper().layoutText(tr, getFTFace(fontID), *run);
+	shapedRuns.emplace_front(key, run);
+	shapedRunIndex.emplace(std::move(key), shapedRuns.begin());
+	if (shapedRuns.size() > SHAPED_RUN_CACHE_SIZE)
+	{
+		shapedRunIndex.erase(shapedRuns.back().first);
+		shapedRuns.pop_back();
+	}
+	return run;
+}
+
+static void resetGlyphAtlas()
+{
+	++glyphAtlasGeneration;
+	glyphAtlasShelfX = 0;
+	glyphAtlasShelfY = 0;
+	glyphAtlasShelfHeight = 0;
+}
+
+// Finds room for the glyph on a shelf of the atlas and uploads it. Returns false if the atlas is full.
+static bool addGlyphToAtlas(FTFace::CachedGlyph &glyph)
+{
+	const RasterizedGlyph &raster = glyph.raster;
+	// Leave a transparent border, so that linear filtering doesn't pick up the neighbouring glyphs
+	const int width = raster.width + 2;
+	const int height = raster.height + 2;
+	if (glyphAtlasShelfX + width > GLYPH_ATLAS_SIZE)
+	{
+		glyphAtlasShelfX = 0;
+		glyphAtlasShelfY += glyphAtlasShelfHeight;
+		glyphAtlasShelfHeight = 0;
+	}
+	if (width > GLYPH_ATLAS_SIZE || glyphAtlasShelfY + height > GLYPH_ATLAS_SIZE)
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> pixels(4 * width * height, 0);
+	for (uint32_t i = 0; i < raster.height; ++i)
+	{
+		for (uint32_t j = 0; j < raster.width; ++j)
+		{
+			uint8_t const *src = &raster.buffer[i * raster.pitch + 3 * j];
+			uint8_t *dst = &pixels[4 * ((i + 1) * width + j + 1)];
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+			dst[3] = (src[0] * 77 + src[1] * 150 + src[2] * 29) >> 8;
+		}
+	}
+	glyphAtlas->updateTexture(pixels.data(), width, height, glyphAtlasShelfX, glyphAtlasShelfY);
+
+	glyph.atlasPosition = Vector2i(glyphAtlasShelfX + 1, glyphAtlasShelfY + 1);
+	glyph.atlasGeneration = glyphAtlasGeneration;
+	glyphAtlasShelfX += width;
+	glyphAtlasShelfHeight = std::max(glyphAtlasShelfHeight, height);
+	return true;
+}
+
+// Builds the quads of the run, adding any missing glyphs to the atlas.
+// Returns false if the atlas ran out of room, in which case it has been emptied and the run must be rebuilt.
+static bool buildShapedRunVertices(ShapedRun &run, FTFace &face)
+{
+	const float invAtlasSize = 1.f / GLYPH_ATLAS_SIZE;
+
+	run.vertices.clear();
+	run.texCoords.clear();
+	for (const ShapedRun::Glyph &g : run.glyphs)
+	{
+		if (g.size.x == 0 || g.size.y == 0)
+		{
+			continue; // Nothing to draw, for example a space
+		}
+		FTFace::CachedGlyph &glyph = face.getCached(g.codePoint, g.subpixelOffset);
+		if (glyph.atlasGeneration != glyphAtlasGeneration && !addGlyphToAtlas(glyph))
+		{
+			resetGlyphAtlas();
+			return false;
+		}
+
+		const gfx_api::gfxFloat x0 = g.position.x / _horizScaleFactor;
+		const gfx_api::gfxFloat y0 = g.position.y / _vertScaleFactor;
+		const gfx_api::gfxFloat x1 = (g.position.x + g.size.x) / _horizScaleFactor;
+		const gfx_api::gfxFloat y1 = (g.position.y + g.size.y) / _vertScaleFactor;
+		const gfx_api::gfxFloat u0 = glyph.atlasPosition.x * invAtlasSize;
+		const gfx_api::gfxFloat v0 = glyph.atlasPosition.y * invAtlasSize;
+		const gfx_api::gfxFloat u1 = (glyph.atlasPosition.x + g.size.x) * invAtlasSize;
+		const gfx_api::gfxFloat v1 = (glyph.atlasPosition.y + g.size.y) * invAtlasSize;
+		const gfx_api::gfxFloat quad[] = { x0, y0, x1, y0, x0, y1, x0, y1, x1, y0, x1, y1 };
+		const gfx_api::gfxFloat uv[] = { u0, v0, u1, v0, u0, v1, u0, v1, u1, v0, u1, v1 };
+		run.vertices.insert(run.vertices.end(), std::begin(quad), std::end(quad));
+		run.texCoords.insert(run.texCoords.end(), std::begin(uv), std::end(uv));
+	}
+	run.atlasGeneration = glyphAtlasGeneration;
+	return true;
+}
+
+static void drawShapedRun(ShapedRun &run, iV_fonts fontID, Vector2i position, float rotation, PIELIGHT colour)
+{
+	if (run.glyphs.empty())
+	{
+		return;
+	}
+	if (glyphAtlas == nullptr)
+	{
+		glyphAtlas = new GFX(GFX_TEXTURE, GL_TRIANGLES, 2);
+		glyphAtlas->makeTexture(GLYPH_ATLAS_SIZE, GLYPH_ATLAS_SIZE, text_filtering);
+		resetGlyphAtlas();
+	}
+	if (run.atlasGeneration != glyphAtlasGeneration && !buildShapedRunVertices(run, getFTFace(fontID)))
+	{
+		// The atlas was full and has been emptied, so only a run larger than the whole atlas can fail now
+		ASSERT_OR_RETURN(, buildShapedRunVertices(run, getFTFace(fontID)), "Text does not fit in the glyph atlas");
+	}
+	if (run.vertices.empty())
+	{
+		return;
+	}
+
+	if (rotation != 0.f)
+	{
+		rotation = 180. - rotation;
+	}
+	glm::mat4 mvp = defaultProjectionMatrix() * glm::translate(glm::vec3(position.x, position.y, 0)) * glm::rotate(RADIANS(rotation), glm::vec3(0.f, 0.f, 1.f));
+	// The text shader multiplies by the colour's alpha twice (premultiplied output); do the same for the gfx shader
+	const float alpha = colour.vector[3] / 255.f;
+	glm::vec4 textColour(colour.vector[0] / 255.f * alpha, colour.vector[1] / 255.f * alpha, colour.vector[2] / 255.f * alpha, alpha * alpha);
+
+	pie_SetRendMode(REND_TEXT);
+	glyphAtlas->buffers(run.vertices.size() / 2, run.vertices.data(), run.texCoords.data());
+	glDisable(GL_CULL_FACE);
+	glyphAtlas->draw(mvp, textColour);
+	glEnable(GL_CULL_FACE);
+}
+
 void iV_TextInit(float horizScaleFactor, float vertScaleFactor)
 {
 	assert(horizScaleFactor >= 1.0f);
@@ -557,8 +699,10 @@ void iV_TextShutdown()
 	bold = nullptr;
 	small = nullptr;
 	smallBold = nullptr;
-	delete textureID;
-	textureID = nullptr;
+	shapedRunIndex.clear();
+	shapedRuns.clear();
+	delete glyphAtlas;
+	glyphAtlas = nullptr;
 }
 
 void iV_TextUpdateScaleFactor(float horizScaleFactor, float vertScaleFactor)
@@ -579,9 +723,7 @@ unsigned int height_pixelsToPoints(unsigned int heightInPixels)
 // Returns the text width *in points*
 unsigned int iV_GetTextWidth(const char *string, iV_fonts fontID)
 {
-	TextRun tr(string, "en", HB_SCRIPT_COMMON, HB_DIRECTION_LTR);
-	TextLayoutMetrics metrics = getShaper().getTextMetrics(tr, getFTFace(fontID));
-	return width_pixelsToPoints(metrics.width);
+	return width_pixelsToPoints(getShapedRun(string, fontID)->layoutMetrics.width);
 }
 
 // Returns the counted text width *in points*
@@ -593,9 +735,7 @@ unsigned int iV_GetCountedTextWidth(const char *string, size_t string_length, iV
 // Returns the text height *in points*
 unsigned int iV_GetTextHeight(const char *string, iV_fonts fontID)
 {
-	TextRun tr(string, "en", HB_SCRIPT_COMMON, HB_DIRECTION_LTR);
-	TextLayoutMetrics metrics = getShaper().getTextMetrics(tr, getFTFace(fontID));
-	return height_pixelsToPoints(metrics.height);
+	return height_pixelsToPoints(getShapedRun(string, fontID)->layoutMetrics.height);
 }
 
 // Returns the character width *in points*
@@ -785,12 +925,6 @@ int iV_DrawFormattedText(const char *String, UDWORD x, UDWORD y, UDWORD Width, U
 void iV_DrawTextRotated(const char *string, float XPos, float YPos, float rotation, iV_fonts fontID)
 {
 	ASSERT_OR_RETURN(, string, "Couldn't render string!");
-	pie_SetTexturePage(TEXPAGE_EXTERN);
-
-	if (rotation != 0.f)
-	{
-		rotation = 180. - rotation;
-	}
 
 	PIELIGHT color;
 	color.vector[0] = font_colour[0] * 255.f;
@@ -798,24 +932,7 @@ void iV_DrawTextRotated(const char *string, float XPos, float YPos, float rotati
 	color.vector[2] = font_colour[2] * 255.f;
 	color.vector[3] = font_colour[3] * 255.f;
 
-	TextRun tr(string, "en", HB_SCRIPT_COMMON, HB_DIRECTION_LTR);
-	DrawTextResult drawResult = getShaper().drawText(tr, getFTFace(fontID));
-
-	if (drawResult.text.width > 0 && drawResult.text.height > 0)
-	{
-		pie_SetTexturePage(TEXPAGE_EXTERN);
-		if (textureID)
-			delete textureID;
-		textureID = gfx_api::context::get().create_texture(drawResult.text.width, drawResult.text.height, gfx_api::pixel_format::rgba);
-		textureID->upload(0u, 0u, 0u, drawResult.text.width, drawResult.text.height, gfx_api::pixel_format::rgba, drawResult.text.data.get());
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, text_filtering);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, text_filtering);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glDisable(GL_CULL_FACE);
-		iV_DrawImageText(*textureID, Vector2i(XPos, YPos), Vector2f((float)drawResult.text.offset_x / _horizScaleFactor, (float)drawResult.text.offset_y / _vertScaleFactor), Vector2f((float)drawResult.text.width / _horizScaleFactor, (float)drawResult.text.height / _vertScaleFactor), rotation, REND_TEXT, color);
-		glEnable(GL_CULL_FACE);
-	}
+	drawShapedRun(*getShapedRun(string, fontID), fontID, Vector2i(XPos, YPos), rotation, color);
 }
 
 #if 0
@@ -895,36 +1012,14 @@ void WzText::drawAndCacheText(const std::string &string, iV_fonts fontID)
 	mRenderingHorizScaleFactor = iV_GetHorizScaleFactor();
 	mRenderingVertScaleFactor = iV_GetVertScaleFactor();
 
-	TextRun tr(string, "en", HB_SCRIPT_COMMON, HB_DIRECTION_LTR);
-	FTFace &face = getFTFace(fontID);
-	FT_Face &type = face.face();
+	FT_Face &type = getFTFace(fontID).face();
 
 	mPtsAboveBase = metricsHeight_PixelsToPoints(-(type->size->metrics.ascender >> 6));
 	mPtsLineSize = metricsHeight_PixelsToPoints((type->size->metrics.ascender - type->size->metrics.descender) >> 6);
 	mPtsBelowBase = metricsHeight_PixelsToPoints(type->size->metrics.descender >> 6);
 
-	DrawTextResult drawResult = getShaper().drawText(tr, face);
-	dimensions = Vector2i(drawResult.text.width, drawResult.text.height);
-	offsets = Vector2i(drawResult.text.offset_x, drawResult.text.offset_y);
-	layoutMetrics = Vector2i(drawResult.layoutMetrics.width, drawResult.layoutMetrics.height);
-
-	if (texture)
-	{
-		delete texture;
-		texture = nullptr;
-	}
-
-	if (dimensions.x > 0 && dimensions.y > 0)
-	{
-		pie_SetTexturePage(TEXPAGE_EXTERN);
-		texture = gfx_api::context::get().create_texture(dimensions.x, dimensions.y, gfx_api::pixel_format::rgba);
-		texture->upload(0u, 0u, 0u, dimensions.x , dimensions.y, gfx_api::pixel_format::rgba, drawResult.text.data.get());
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, text_filtering);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, text_filtering);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	}
-	glBindTexture(GL_TEXTURE_2D, 0);
+	run = getShapedRun(string, fontID);
+	layoutMetrics = Vector2i(run->layoutMetrics.width, run->layoutMetrics.height);
 }
 
 void WzText::redrawAndCacheText()
@@ -937,37 +1032,19 @@ WzText::WzText(const std::string &string, iV_fonts fontID)
 	setText(string, fontID);
 }
 
-WzText::~WzText()
-{
-	if (texture)
-		delete texture;
-}
-
 WzText& WzText::operator=(WzText&& other)
 {
 	if (this != &other)
 	{
-		// Free the existing texture, if any.
-		if (texture)
-		{
-			delete texture;
-		}
-
-		// Get the other data
-		texture = other.texture;
+		run = std::move(other.run);
 		mFontID = other.mFontID;
 		mText = std::move(other.mText);
 		mPtsAboveBase = other.mPtsAboveBase;
 		mPtsBelowBase = other.mPtsBelowBase;
 		mPtsLineSize = other.mPtsLineSize;
-		offsets = other.offsets;
-		dimensions = other.dimensions;
 		mRenderingHorizScaleFactor = other.mRenderingHorizScaleFactor;
 		mRenderingVertScaleFactor = other.mRenderingVertScaleFactor;
 		layoutMetrics = other.layoutMetrics;
-
-		// Reset other's texture
-		other.texture = nullptr;
 	}
 	return *this;
 }
@@ -995,20 +1072,12 @@ void WzText::render(Vector2i position, PIELIGHT colour, float rotation)
 {
 	updateCacheIfNecessary();
 
-	if (texture == nullptr)
+	if (!run)
 	{
-		// A texture will not always be created. (For example, if the rendered text is empty.)
-		// No need to render if there's nothing to render.
-		return;
+		return; // No text has been set yet.
 	}
 
-	if (rotation != 0.f)
-	{
-		rotation = 180. - rotation;
-	}
-	glDisable(GL_CULL_FACE);
-	iV_DrawImageText(*texture, position, Vector2f(offsets.x / mRenderingHorizScaleFactor, offsets.y / mRenderingVertScaleFactor), Vector2f(dimensions.x / mRenderingHorizScaleFactor, dimensions.y / mRenderingVertScaleFactor), rotation, REND_TEXT, colour);
-	glEnable(GL_CULL_FACE);
+	drawShapedRun(*run, mFontID, position, rotation, colour);
 }
 
 // Sets the text, truncating to a desired width limit (in *points*) if needed
@@ -22,6 +22,7 @@
 #define _INCLUDED_TEXTDRAW_
 
 #include <string>
+#include <memory>
 
 #include "lib/framework/vector.h"
 #include "gfx_api.h"
@@ -38,13 +39,14 @@ enum iV_fonts
 	font_count
 };
 
+struct ShapedRun;
+
 class WzText
 {
 public:
 	WzText() {}
 	WzText(const std::string &text, iV_fonts fontID);
 	void setText(const std::string &text, iV_fonts fontID/*, bool delayRender = false*/);
-	~WzText();
 	// Width (in points)
 	int width();
 	// Height (in points)
@@ -70,12 +72,10 @@ private:
 	void updateCacheIfNecessary();
 private:
 	std::string mText;
-	gfx_api::texture* texture = nullptr;
+	std::shared_ptr<ShapedRun> run; ///< Shared with the shaped run cache; drawn from the glyph atlas
 	int mPtsAboveBase = 0;
 	int mPtsBelowBase = 0;
 	int mPtsLineSize = 0;
-	Vector2i offsets = Vector2i(0, 0);
-	Vector2i dimensions = Vector2i(0, 0);
 	float mRenderingHorizScaleFactor = 0.f;
 	float mRenderingVertScaleFactor = 0.f;
 	iV_fonts mFontID = font_count;
@@ -41,9 +41,11 @@
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <unordered_map>
 
 #include "netplay.h"
 #include "netlog.h"
+#include "netreplay.h"
 #include "netsocket.h"
 
 #include <miniupnpc/miniwget.h>
@@ -168,6 +170,16 @@ static char externalIPAddress[40];
 static Socket *tmp_socket[MAX_TMP_SOCKETS] = { nullptr };  ///< Sockets used to talk to clients which have not yet been assigned a player number (host only).
 
 static SocketSet *tmp_socket_set = nullptr;
+
+/// How far a client in tmp_socket[] has got with connecting.
+struct TmpSocketInfo
+{
+	uint32_t connectTime;       ///< When the connection was accepted, for timing out the version check.
+	bool     versionChecked;    ///< True once the client sent a version we can talk to, and may send NET_JOIN.
+	uint8_t  versionBuffer[8];  ///< NETCODE_VERSION_MAJOR and NETCODE_VERSION_MINOR, as received so far.
+	unsigned versionReceived;
+};
+static TmpSocketInfo tmp_socket_info[MAX_TMP_SOCKETS];
 static int32_t          NetGameFlags[4] = { 0, 0, 0, 0 };
 char iptoconnect[PATH_MAX] = "\0"; // holds IP/hostname from command line
 
@@ -187,7 +199,7 @@ unsigned NET_PlayerConnectionStatus[CONNECTIONSTATUS_NORMAL][MAX_PLAYERS];
 **/
 static char const *versionString = version_getVersionString();
 static int NETCODE_VERSION_MAJOR = 0x1000;
-static int NETCODE_VERSION_MINOR = 1;
+static int NETCODE_VERSION_MINOR = 2;
 
 bool NETisCorrectVersion(uint32_t game_version_major, uint32_t game_version_minor)
 {
@@ -1255,7 +1267,7 @@ int NETclose()
 
 // ////////////////////////////////////////////////////////////////////////
 // return bytes of data sent recently.
-unsigned NETgetStatistic(NetStatisticType type, bool sent, bool isTotal)
+unsigned NETgetStatistic(NetStatisticType type, bool sent, bool isTotal, unsigned player)
 {
 	unsigned Statistic::*statisticType = sent ? &Statistic::sent : &Statistic::received;
 	Statistic NETSTATS::*statsType;
@@ -1264,6 +1276,22 @@ unsigned NETgetStatistic(NetStatisticType type, bool sent, bool isTotal)
 	case NetStatisticRawBytes:          statsType = &NETSTATS::rawBytes;          break;
 	case NetStatisticUncompressedBytes: statsType = &NETSTATS::uncompressedBytes; break;
 	case NetStatisticPackets:           statsType = &NETSTATS::packets;           break;
+	case NetStatisticLatency:           return sent ? getChosenLatency() : getWantedLatency();
+	case NetStatisticStalls:            return getStallCount(isTotal);
+	case NetStatisticRoundTrip:
+	case NetStatisticJitter:
+		{
+			unsigned percent = isTotal ? 95 : 50;
+			unsigned worst = 0;
+			for (unsigned i = 0; i < MAX_PLAYERS; ++i)
+			{
+				if ((player == NET_ALL_PLAYERS && NetPlay.players[i].allocated && i != selectedPlayer) || i == player)
+				{
+					worst = std::max(worst, type == NetStatisticRoundTrip ? getPlayerRoundTrip(i, percent) : getPlayerJitter(i, percent));
+				}
+			}
+			return worst;
+		}
 	default: ASSERT(false, " "); return 0;
 	}
 
@@ -1550,6 +1578,10 @@ static bool NETprocessSystemMessage(NETQUEUE playerQueue, uint8_t type)
 
 				NETinsertMessageFromNet(NETgameQueue(player), message);
 				NETlogPacket(message->type, message->rawLen(), true);
+				if (message->type == GAME_GAME_TIME)
+				{
+					recordPlayerGameTimeArrival(player);  // For measuring the jitter of the player's game messages.
+				}
 
 				delete message;
 				message = nullptr;
@@ -1910,6 +1942,11 @@ checkMessages:
 
 bool NETrecvGame(NETQUEUE *queue, uint8_t *type)
 {
+	if (NETisReplay())
+	{
+		NETreplayLoadNetMessages(gameTime);
+	}
+
 	for (unsigned current = 0; current < MAX_PLAYERS; ++current)
 	{
 		*queue = NETgameQueue(current);
@@ -1947,10 +1984,17 @@ bool NETrecvGame(NETQUEUE *queue, uint8_t *type)
 *         NET_BUFFER_SIZE is at 16k.  (also remember text chat, plus all the other cruff)
 */
 #define MAX_FILE_TRANSFER_PACKET 2048
+#define MAX_FILE_TRANSFER_BACKLOG (64 * 1024)  ///< Stop sending file chunks to a client which has this much data waiting to be written.
 int NETsendFile(WZFile &file, unsigned player)
 {
 	ASSERT_OR_RETURN(100, NetPlay.isHost, "Trying to send a file and we are not the host!");
 
+	// Let a slow download catch up, instead of reading and compressing the whole file into the socket's write queue.
+	if (player < MAX_CONNECTED_PLAYERS && connected_bsocket[player] != nullptr && socketWriteQueueSize(connected_bsocket[player]) > MAX_FILE_TRANSFER_BACKLOG)
+	{
+		return (uint64_t)file.pos * 100 / file.size;
+	}
+
 	uint8_t inBuff[MAX_FILE_TRANSFER_PACKET];
 	memset(inBuff, 0x0, sizeof(inBuff));
 
@@ -2285,17 +2329,91 @@ void NETfixPlayerCount()
 	}
 
 }
+
+/// Reads the version a newly connected client sends, without waiting for it. Returns false if the connection should be dropped.
+static bool NETcheckJoiningVersion(unsigned i)
+{
+	TmpSocketInfo &info = tmp_socket_info[i];
+	std::string rIP = "Incoming connection from:";
+	rIP.append(getSocketTextAddress(tmp_socket[i]));
+
+	if (socketReadReady(tmp_socket[i]))
+	{
+		ssize_t recv_result = readNoInt(tmp_socket[i], info.versionBuffer + info.versionReceived, sizeof(info.versionBuffer) - info.versionReceived);
+		if (recv_result == SOCKET_ERROR || (recv_result == 0 && socketReadDisconnected(tmp_socket[i])))
+		{
+			debug(LOG_NET, "Failed to process joining, recv_result is :%d", (int)recv_result);
+			return false;
+		}
+		info.versionReceived += recv_result;
+	}
+
+	// A 2.3.7 client sends a "list" command first, just drop the connection.
+	if (info.versionReceived >= 4 && memcmp(info.versionBuffer, "list", 4) == 0)
+	{
+		NETlogEntry(rIP.c_str(), SYNC_FLAG, i);
+		debug(LOG_INFO, "An old client tried to connect, closing the socket.");
+		NETlogEntry("Dropping old client.", SYNC_FLAG, i);
+		NETlogEntry("Invalid (old)game version", SYNC_FLAG, i);
+		addToBanList(rIP.c_str(), "BAD_USER");
+		return false;
+	}
+
+	if (info.versionReceived < sizeof(info.versionBuffer))
+	{
+		if (wzGetTicks() - info.connectTime > NET_TIMEOUT_DELAY)
+		{
+			debug(LOG_NET, "Failed to process joining, no version received after %d ms", NET_TIMEOUT_DELAY);
+			return false;
+		}
+		return true;  // Check again next time.
+	}
+
+	NETlogEntry(rIP.c_str(), SYNC_FLAG, i);
+
+	// New clients send NETCODE_VERSION_MAJOR and NETCODE_VERSION_MINOR
+	// Check these numbers with our own.
+	int32_t major, minor, result;
+	memcpy(&major, info.versionBuffer, sizeof(int32_t));
+	major = ntohl(major);
+	memcpy(&minor, info.versionBuffer + sizeof(int32_t), sizeof(int32_t));
+	minor = ntohl(minor);
+
+	if (!NETisCorrectVersion(major, minor))
+	{
+		debug(LOG_ERROR, "Received an invalid version \"%d.%d\".", major, minor);
+		result = htonl(ERROR_WRONGVERSION);
+		writeAll(tmp_socket[i], &result, sizeof(result));
+		NETlogEntry("Invalid game version", SYNC_FLAG, i);
+		addToBanList(rIP.c_str(), "BAD_USER");
+		return false;
+	}
+
+	result = htonl(ERROR_NOERROR);
+	writeAll(tmp_socket[i], &result, sizeof(result));
+	socketBeginCompression(tmp_socket[i]);
+	info.versionChecked = true;
+
+	if ((int)NetPlay.playercount == gamestruct.desc.dwMaxPlayers)
+	{
+		// early player count test, in case they happen to get in before updates.
+		// Tell the player that we are full.
+		uint8_t rejected = ERROR_FULL;
+		NETbeginEncode(NETnetTmpQueue(i), NET_REJECTED);
+		NETuint8_t(&rejected);
+		NETend();
+		NETflush();
+		return false;
+	}
+
+	return true;
+}
+
 // ////////////////////////////////////////////////////////////////////////
 // Host a game with a given name and player name. & 4 user game flags
 static void NETallowJoining()
 {
 	unsigned int i;
-	char buffer[10] = {'\0'};
-	char *p_buffer;
-	int32_t result;
-	bool connectFailed = true;
-	int32_t major, minor;
-	ssize_t recv_result = 0;
 
 	if (allow_joining == false)
 	{
@@ -2325,112 +2443,42 @@ static void NETallowJoining()
 		}
 	}
 
-	// Find the first empty socket slot
+	// Accept any incoming connections into free slots. Their versions are checked below, as the data arrives, rather than waiting for it here.
 	for (i = 0; i < MAX_TMP_SOCKETS; ++i)
 	{
+		if (tmp_socket[i] != nullptr)
+		{
+			continue;
+		}
+		tmp_socket[i] = socketAccept(tcp_socket);
 		if (tmp_socket[i] == nullptr)
 		{
-			break;
+			break;  // No more pending connections.
 		}
-	}
-	if (i == MAX_TMP_SOCKETS)
-	{
-		// this should *never* happen, it would mean we are going to reuse a socket already in use.
-		debug(LOG_ERROR, "all temp sockets are used up!");
-		return;
-	}
-
-	// See if there's an incoming connection
-	if (tmp_socket[i] == nullptr // Make sure that we're not out of sockets
-	    && (tmp_socket[i] = socketAccept(tcp_socket)) != nullptr)
-	{
 		NETinitQueue(NETnetTmpQueue(i));
 		SocketSet_AddSocket(tmp_socket_set, tmp_socket[i]);
+		tmp_socket_info[i].connectTime = wzGetTicks();
+		tmp_socket_info[i].versionChecked = false;
+		tmp_socket_info[i].versionReceived = 0;
+	}
 
-		p_buffer = buffer;
-		// We check for socket activity (connection), and then we check if we got data, since it is possible to have a connection
-		// and have no data waiting.
-		if (checkSockets(tmp_socket_set, NET_TIMEOUT_DELAY) > 0
-		    && socketReadReady(tmp_socket[i])
-		    && (recv_result = readNoInt(tmp_socket[i], p_buffer, 8))
-		    && recv_result != SOCKET_ERROR)
-		{
-			std::string rIP = "Incoming connection from:";
-			rIP.append(getSocketTextAddress(tmp_socket[i]));
-			NETlogEntry(rIP.c_str(), SYNC_FLAG, i);
-			// A 2.3.7 client sends a "list" command first, just drop the connection.
-			if (strcmp(buffer, "list") == 0)
-			{
-				debug(LOG_INFO, "An old client tried to connect, closing the socket.");
-				NETlogEntry("Dropping old client.", SYNC_FLAG, i);
-				NETlogEntry("Invalid (old)game version", SYNC_FLAG, i);
-				addToBanList(rIP.c_str(), "BAD_USER");
-				connectFailed = true;
-			}
-			else
+	if (checkSockets(tmp_socket_set, NET_READ_TIMEOUT) >= 0)
+	{
+		for (i = 0; i < MAX_TMP_SOCKETS; ++i)
+		{
+			if (tmp_socket[i] != nullptr && !tmp_socket_info[i].versionChecked)
 			{
-				// New clients send NETCODE_VERSION_MAJOR and NETCODE_VERSION_MINOR
-				// Check these numbers with our own.
-
-				memcpy(&major, p_buffer, sizeof(int32_t));
-				major = ntohl(major);
-				p_buffer += sizeof(int32_t);
-				memcpy(&minor, p_buffer, sizeof(int32_t));
-				minor = ntohl(minor);
-
-				if (NETisCorrectVersion(major, minor))
+				if (!NETcheckJoiningVersion(i))
 				{
-					result = htonl(ERROR_NOERROR);
-					memcpy(&buffer, &result, sizeof(result));
-					writeAll(tmp_socket[i], &buffer, sizeof(result));
-					socketBeginCompression(tmp_socket[i]);
-
-					// Connection is successful.
-					connectFailed = false;
-				}
-				else
-				{
-					debug(LOG_ERROR, "Received an invalid version \"%d.%d\".", major, minor);
-					result = htonl(ERROR_WRONGVERSION);
-					memcpy(&buffer, &result, sizeof(result));
-					writeAll(tmp_socket[i], &buffer, sizeof(result));
-					NETlogEntry("Invalid game version", SYNC_FLAG, i);
-					addToBanList(rIP.c_str(), "BAD_USER");
-					connectFailed = true;
-				}
-				if ((int)NetPlay.playercount == gamestruct.desc.dwMaxPlayers)
-				{
-					// early player count test, in case they happen to get in before updates.
-					// Tell the player that we are full.
-					uint8_t rejected = ERROR_FULL;
-					NETbeginEncode(NETnetTmpQueue(i), NET_REJECTED);
-					NETuint8_t(&rejected);
-					NETend();
-					NETflush();
-					connectFailed = true;
+					// Remove a failed connection.
+					debug(LOG_NET, "freeing temp socket %p (%d)", static_cast<void *>(tmp_socket[i]), __LINE__);
+					SocketSet_DelSocket(tmp_socket_set, tmp_socket[i]);
+					socketClose(tmp_socket[i]);
+					tmp_socket[i] = nullptr;
 				}
+				continue;
 			}
-		}
-		else
-		{
-			debug(LOG_NET, "Failed to process joining, socket not ready or no data, recv_result is :%d", (int)recv_result);
-			connectFailed = true;
-		}
 
-		// Remove a failed connection.
-		if (connectFailed)
-		{
-			debug(LOG_NET, "freeing temp socket %p (%d)", static_cast<void *>(tmp_socket[i]), __LINE__);
-			SocketSet_DelSocket(tmp_socket_set, tmp_socket[i]);
-			socketClose(tmp_socket[i]);
-			tmp_socket[i] = nullptr;
-		}
-	}
-
-	if (checkSockets(tmp_socket_set, NET_READ_TIMEOUT) > 0)
-	{
-		for (i = 0; i < MAX_TMP_SOCKETS; ++i)
-		{
 			if (tmp_socket[i] != nullptr
 			    && socketReadReady(tmp_socket[i]))
 			{
@@ -3312,6 +3360,245 @@ struct SyncDebugIntList : public SyncDebugEntry
 	unsigned numInts;
 };
 
+/// How syncDebug() takes an argument of a format string, so that it can store the raw value and format it later.
+enum SyncDebugArgType
+{
+	SDA_NONE,      ///< Trailing text, no argument.
+	SDA_INT,       ///< Also char and short, which are promoted to int.
+	SDA_LONG,
+	SDA_LONGLONG,
+	SDA_SIZE,
+	SDA_DOUBLE,
+	SDA_STRING,    ///< Stored as a copy, since the string might not outlive the call.
+	SDA_POINTER,
+};
+
+/// A syncDebug() format string split up into one printf call per argument, parsed once per call site.
+struct SyncDebugFormat
+{
+	struct Piece
+	{
+		std::string format;         ///< Literal text followed by one conversion, or just text if type == SDA_NONE.
+		unsigned numStars;          ///< '*' widths and precisions, which take an int argument before the value.
+		SyncDebugArgType type;
+	};
+
+	bool deferrable = true;             ///< False if the format uses something not handled here, so it has to be formatted immediately.
+	uint32_t id = 0;                    ///< CRC of the function name and format string, which is the same on all clients.
+	std::vector<Piece> pieces;
+};
+
+static void syncDebugParseFormat(SyncDebugFormat &format, char const *function, char const *str)
+{
+	format.id = crcSum(0, function, strlen(function) + 1);
+	format.id = crcSum(format.id, str, strlen(str) + 1);
+
+	std::string text;   // Literal text since the previous conversion, with "%%" kept escaped.
+	std::string plain;  // The same text, unescaped.
+	char const *c = str;
+	while (*c != '\0')
+	{
+		if (*c != '%')
+		{
+			text += *c;
+			plain += *c++;
+			continue;
+		}
+		if (c[1] == '%')
+		{
+			text += "%%";
+			plain += '%';
+			c += 2;
+			continue;
+		}
+
+		SyncDebugFormat::Piece piece;
+		piece.numStars = 0;
+		char const *begin = c++;
+		while (*c != '\0' && strchr("-+ #0'", *c) != nullptr)
+		{
+			++c;
+		}
+		for (int part = 0; part < 2; ++part)  // Width, then precision.
+		{
+			if (part == 1)
+			{
+				if (*c != '.')
+				{
+					break;
+				}
+				++c;
+			}
+			if (*c == '*')
+			{
+				++piece.numStars;
+				++c;
+			}
+			while (*c >= '0' && *c <= '9')
+			{
+				++c;
+			}
+		}
+		int longs = 0;
+		bool sizeT = false, other = false;
+		if (strncmp(c, "I64", 3) == 0)
+		{
+			longs = 2;
+			c += 3;
+		}
+		else if (strncmp(c, "I32", 3) == 0)
+		{
+			c += 3;
+		}
+		for (; *c != '\0' && strchr("hlLqzjtI", *c) != nullptr; ++c)
+		{
+			longs += *c == 'l' ? 1 : *c == 'q' ? 2 : 0;
+			sizeT |= *c == 'z';
+			other |= *c == 'L' || *c == 'j' || *c == 't' || *c == 'I';
+		}
+		if (*c == '\0' || other)
+		{
+			format.deferrable = false;
+			return;
+		}
+		switch (*c)
+		{
+		case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+			piece.type = sizeT ? SDA_SIZE : longs == 0 ? SDA_INT : longs == 1 ? SDA_LONG : SDA_LONGLONG;
+			break;
+		case 'c':
+			piece.type = SDA_INT;
+			format.deferrable &= longs == 0;
+			break;
+		case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+			piece.type = SDA_DOUBLE;
+			break;
+		case 's':
+			piece.type = SDA_STRING;
+			format.deferrable &= longs == 0;
+			break;
+		case 'p':
+			piece.type = SDA_POINTER;
+			break;
+		default:
+			format.deferrable = false;  // %n, wide characters and anything unknown.
+			break;
+		}
+		if (!format.deferrable)
+		{
+			return;
+		}
+		++c;
+		piece.format = text + std::string(begin, c);
+		format.pieces.push_back(piece);
+		text.clear();
+		plain.clear();
+	}
+	if (!plain.empty())
+	{
+		SyncDebugFormat::Piece piece;
+		piece.format = plain;
+		piece.numStars = 0;
+		piece.type = SDA_NONE;
+		format.pieces.push_back(piece);
+	}
+}
+
+struct SyncDebugFormatKey
+{
+	bool operator ==(SyncDebugFormatKey const &b) const
+	{
+		return function == b.function && str == b.str;
+	}
+
+	char const *function;
+	char const *str;
+};
+
+struct SyncDebugFormatKeyHash
+{
+	size_t operator ()(SyncDebugFormatKey const &key) const
+	{
+		return std::hash<char const *>()(key.function) * 31 + std::hash<char const *>()(key.str);
+	}
+};
+
+/// Parsed format strings, keyed by the function name and format string pointers, which are string literals.
+static std::unordered_map<SyncDebugFormatKey, SyncDebugFormat, SyncDebugFormatKeyHash> syncDebugFormats;
+
+static SyncDebugFormat const &syncDebugGetFormat(char const *function, char const *str)
+{
+	SyncDebugFormatKey key = {function, str};
+	auto it = syncDebugFormats.find(key);
+	if (it == syncDebugFormats.end())
+	{
+		it = syncDebugFormats.emplace(key, SyncDebugFormat()).first;
+		syncDebugParseFormat(it->second, function, str);
+	}
+	return it->second;
+}
+
+template <typename T>
+static int syncDebugPrintPiece(char *buf, size_t bufSize, SyncDebugFormat::Piece const &piece, int const *stars, T value)
+{
+	switch (piece.numStars)
+	{
+	case 0:  return snprintf(buf, bufSize, piece.format.c_str(), value);
+	case 1:  return snprintf(buf, bufSize, piece.format.c_str(), stars[0], value);
+	default: return snprintf(buf, bufSize, piece.format.c_str(), stars[0], stars[1], value);
+	}
+}
+
+template <typename T>
+static T syncDebugReadArg(char const *&args)
+{
+	T value;
+	memcpy(&value, args, sizeof(T));
+	args += sizeof(T);
+	return value;
+}
+
+/// A syncDebug() call, stored as its format and raw arguments instead of the formatted string.
+struct SyncDebugDeferred : public SyncDebugEntry
+{
+	int snprint(char *buf, size_t bufSize, char const *&args) const
+	{
+		size_t index = snprintf(buf, bufSize, "[%s] ", function);
+		for (SyncDebugFormat::Piece const &piece : format->pieces)
+		{
+			int stars[2] = {0, 0};
+			for (unsigned n = 0; n < piece.numStars; ++n)
+			{
+				stars[n] = syncDebugReadArg<int>(args);
+			}
+			// Arguments must be read even once the buffer is full, so that args ends up at the next entry.
+			char *pieceBuf = buf + std::min(index, bufSize);
+			size_t pieceSize = index < bufSize ? bufSize - index : 0;
+			switch (piece.type)
+			{
+			case SDA_NONE:     index += snprintf(pieceBuf, pieceSize, "%s", piece.format.c_str()); break;
+			case SDA_INT:      index += syncDebugPrintPiece(pieceBuf, pieceSize, piece, stars, syncDebugReadArg<int>(args)); break;
+			case SDA_LONG:     index += syncDebugPrintPiece(pieceBuf, pieceSize, piece, stars, syncDebugReadArg<long>(args)); break;
+			case SDA_LONGLONG: index += syncDebugPrintPiece(pieceBuf, pieceSize, piece, stars, syncDebugReadArg<long long>(args)); break;
+			case SDA_SIZE:     index += syncDebugPrintPiece(pieceBuf, pieceSize, piece, stars, syncDebugReadArg<size_t>(args)); break;
+			case SDA_DOUBLE:   index += syncDebugPrintPiece(pieceBuf, pieceSize, piece, stars, syncDebugReadArg<double>(args)); break;
+			case SDA_POINTER:  index += syncDebugPrintPiece(pieceBuf, pieceSize, piece, stars, syncDebugReadArg<void *>(args)); break;
+			case SDA_STRING:
+				index += syncDebugPrintPiece(pieceBuf, pieceSize, piece, stars, args);
+				args += strlen(args) + 1;
+				break;
+			}
+		}
+		if (index < bufSize)
+		{
+			index += snprintf(buf + index, bufSize - index, "\n");
+		}
+		return index;
+	}
+
+	SyncDebugFormat const *format;
+};
+
 struct SyncDebugLog
 {
 	SyncDebugLog() : time(0), crc(0x00000000) {}
@@ -3324,8 +3611,10 @@ struct SyncDebugLog
 		strings.clear();
 		valueChanges.clear();
 		intLists.clear();
+		deferreds.clear();
 		chars.clear();
 		ints.clear();
+		args.clear();
 	}
 	void string(char const *f, char const *s)
 	{
@@ -3356,13 +3645,63 @@ struct SyncDebugLog
 		intLists.back().set(crc, f, s, buf, num);
 		log.push_back('i');
 	}
+	/// Stores the raw arguments and adds them to the CRC, in a form that is the same on all clients, without formatting anything.
+	void deferred(char const *f, SyncDebugFormat const *format, va_list ap)
+	{
+		crcBytes.clear();
+		appendCrcValue(format->id, 4);
+		for (SyncDebugFormat::Piece const &piece : format->pieces)
+		{
+			for (unsigned n = 0; n < piece.numStars; ++n)
+			{
+				appendCrcValue(appendArg<int>(va_arg(ap, int)), 8);
+			}
+			switch (piece.type)
+			{
+			case SDA_NONE:     break;
+			case SDA_INT:      appendCrcValue(appendArg<int>(va_arg(ap, int)), 8); break;
+			case SDA_LONG:     appendCrcValue(appendArg<long>(va_arg(ap, long)), 8); break;
+			case SDA_LONGLONG: appendCrcValue(appendArg<long long>(va_arg(ap, long long)), 8); break;
+			case SDA_SIZE:     appendCrcValue(appendArg<size_t>(va_arg(ap, size_t)), 8); break;
+			case SDA_POINTER:  appendCrcValue((uintptr_t)appendArg<void *>(va_arg(ap, void *)), 8); break;
+			case SDA_DOUBLE:
+				{
+					double value = appendArg<double>(va_arg(ap, double));
+					uint64_t bits;
+					memcpy(&bits, &value, sizeof(bits));
+					appendCrcValue(bits, 8);
+					break;
+				}
+			case SDA_STRING:
+				{
+					char const *string = va_arg(ap, char const *);
+					if (string == nullptr)
+					{
+						string = "(null)";
+					}
+					size_t length = strlen(string) + 1;
+					args.insert(args.end(), string, string + length);
+					crcBytes.insert(crcBytes.end(), string, string + length);
+					break;
+				}
+			}
+		}
+		crc = crcSum(crc, crcBytes.data(), crcBytes.size());
+
+		deferreds.resize(deferreds.size() + 1);
+		deferreds.back().function = f;
+		deferreds.back().format = format;
+		log.push_back('f');
+	}
 	int snprint(char *buf, size_t bufSize)
 	{
 		SyncDebugString const *stringPtr = strings.empty() ? nullptr : &strings[0]; // .empty() check, since &strings[0] is undefined if strings is empty(), even if it's likely to work, anyway.
 		SyncDebugValueChange const *valueChangePtr = valueChanges.empty() ? nullptr : &valueChanges[0];
 		SyncDebugIntList const *intListPtr = intLists.empty() ? nullptr : &intLists[0];
+		SyncDebugDeferred const *deferredPtr = deferreds.empty() ? nullptr : &deferreds[0];
 		char const *charPtr = chars.empty() ? nullptr : &chars[0];
 		int const *intPtr = ints.empty() ? nullptr : &ints[0];
+		char const *argPtr = args.empty() ? nullptr : &args[0];
 
 		int index = 0;
 		for (size_t n = 0; n < log.size() && (size_t)index < bufSize; ++n)
@@ -3379,6 +3718,9 @@ struct SyncDebugLog
 			case 'i':
 				index += intListPtr++->snprint(buf + index, bufSize - index, intPtr);
 				break;
+			case 'f':
+				index += deferredPtr++->snprint(buf + index, bufSize - index, argPtr);
+				break;
 			default:
 				abort();
 				break;
@@ -3408,6 +3750,22 @@ struct SyncDebugLog
 	}
 
 private:
+	template <typename T>
+	T appendArg(T value)
+	{
+		char const *bytes = reinterpret_cast<char const *>(&value);
+		args.insert(args.end(), bytes, bytes + sizeof(T));
+		return value;
+	}
+	/// Appends the value to crcBytes as numBytes big-endian bytes, so that the CRC does not depend on the size of long or the byte order.
+	void appendCrcValue(uint64_t value, unsigned numBytes)
+	{
+		for (unsigned n = numBytes; n-- > 0;)
+		{
+			crcBytes.push_back(char(value >> n * 8));
+		}
+	}
+
 	std::vector<char> log;
 	uint32_t time;
 	uint32_t crc;
@@ -3415,9 +3773,12 @@ private:
 	std::vector<SyncDebugString> strings;
 	std::vector<SyncDebugValueChange> valueChanges;
 	std::vector<SyncDebugIntList> intLists;
+	std::vector<SyncDebugDeferred> deferreds;
 
 	std::vector<char> chars;
 	std::vector<int> ints;
+	std::vector<char> args;      ///< Raw arguments of deferreds, kept until the log is reused, so only dumps format them.
+	std::vector<char> crcBytes;  ///< Scratch space for deferred(), so that each call updates the CRC once.
 
 private:
 	SyncDebugLog(SyncDebugLog const &)/* = delete*/;
@@ -3444,13 +3805,19 @@ void _syncDebug(const char *function, const char *str, ...)
 #endif
 
 	va_list ap;
-	char outputBuffer[MAX_LEN_LOG_LINE];
-
 	va_start(ap, str);
-	vssprintf(outputBuffer, str, ap);
+	SyncDebugFormat const &format = syncDebugGetFormat(function, str);
+	if (format.deferrable)
+	{
+		syncDebugLog[syncDebugNext].deferred(function, &format, ap);
+	}
+	else
+	{
+		char outputBuffer[MAX_LEN_LOG_LINE];
+		vssprintf(outputBuffer, str, ap);
+		syncDebugLog[syncDebugNext].string(function, outputBuffer);
+	}
 	va_end(ap);
-
-	syncDebugLog[syncDebugNext].string(function, outputBuffer);
 }
 
 void _syncDebugIntList(const char *function, const char *str, int *ints, size_t numInts)
@@ -279,7 +279,7 @@ WZ_DECL_NONNULL(1, 2) bool NETrecvNet(NETQUEUE *queue, uint8_t *type);        //
 WZ_DECL_NONNULL(1, 2) bool NETrecvGame(NETQUEUE *queue, uint8_t *type);       ///< recv a message from the game queues which is sceduled to execute by time, if possible.
 void NETflush();                                                              ///< Flushes any data stuck in compression buffers.
 
-int NETsendFile(WZFile &file, unsigned player);  ///< Send file chunk. Returns 100 when done.
+int NETsendFile(WZFile &file, unsigned player);  ///< Send file chunk. Returns 100 when done. Sends nothing if the player isn't keeping up.
 int NETrecvFile(NETQUEUE queue);                 ///< Receive file chunk. Returns 100 when done.
 unsigned NETgetDownloadProgress(unsigned player);     ///< Returns 100 when done.
 
@@ -290,8 +290,15 @@ void NETaddRedirects();
 void NETremRedirects();
 void NETdiscoverUPnPDevices();
 
-enum NetStatisticType {NetStatisticRawBytes, NetStatisticUncompressedBytes, NetStatisticPackets};
-unsigned NETgetStatistic(NetStatisticType type, bool sent, bool isTotal = false);     // Return some statistic. Call regularly for good results.
+enum NetStatisticType
+{
+	NetStatisticRawBytes, NetStatisticUncompressedBytes, NetStatisticPackets,
+	NetStatisticLatency,    ///< Latency added to our game messages (sent = true), or which we are asking for (sent = false), in milliseconds.
+	NetStatisticStalls,     ///< Ticks which waited for other players, in the last second or the whole game.
+	NetStatisticRoundTrip,  ///< Median round trip time in milliseconds. (isTotal = true for the 95th percentile.)
+	NetStatisticJitter,     ///< Median jitter of the player's game messages in milliseconds. (isTotal = true for the 95th percentile.)
+};
+unsigned NETgetStatistic(NetStatisticType type, bool sent, bool isTotal = false, unsigned player = NET_ALL_PLAYERS);     // Return some statistic. Call regularly for good results. Round trip and jitter are for the given player, or the worst player.
 
 void NETplayerKicked(UDWORD index);			// Cleanup after player has been kicked
 
@@ -335,6 +342,7 @@ bool NETcheckPlayerConnectionStatus(CONNECTION_STATUS status, unsigned player);
 const char *messageTypeToString(unsigned messageType);
 
 /// Sync debugging. Only prints anything, if different players would print different things.
+/// Stores the raw arguments and only formats them when dumping, so the format string must be a string literal.
 #define syncDebug(...) do { _syncDebug(__FUNCTION__, __VA_ARGS__); } while(0)
 #ifdef WZ_CC_MINGW
 void _syncDebug(const char *function, const char *str, ...) WZ_DECL_FORMAT(__MINGW_PRINTF_FORMAT, 2, 3);
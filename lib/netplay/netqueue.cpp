@@ -153,7 +153,7 @@ void NetQueue::writeRawData(const uint8_t *netData, size_t netLen)
 		}
 		unsigned headerLen = 1 + n;
 
-		ASSERT(len < 40000000, "Trying to write a very large packet (%u bytes) to the queue.", len);
+		ASSERT(len < MAX_NET_MESSAGE_SIZE, "Trying to write a very large packet (%u bytes) to the queue.", len);
 		if (buffer.size() - used - headerLen < len)
 		{
 			break;  // Don't have a whole message ready yet.
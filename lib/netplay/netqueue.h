@@ -39,6 +39,8 @@
 // At socket level:
 // There should be a NetQueuePair per socket.
 
+#define MAX_NET_MESSAGE_SIZE 40000000  ///< Messages are never this large, so a length this big means the data is corrupt.
+
 
 /// A NetMessage consists of a type (uint8_t) and some data, the meaning of which depends on the type.
 class NetMessage
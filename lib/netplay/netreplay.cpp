@@ -0,0 +1,421 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Recording and playback of the game message queues.
+ *
+ *  A replay file starts with the magic "WZRP" and a 32-bit version, followed by a single zlib stream holding the
+ *  length-prefixed settings JSON, and then one record per message read from a game queue. All integers are big endian.
+ *
+ *  Record: uint32 gameTime, uint8 player, uint8 message type, uint32 data length, data.
+ *  The stream ends with a record whose player is REPLAY_END_PLAYER, and which has no type, length or data.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/framework/jobsystem.h"
+#include "lib/framework/physfs_ext.h"
+#include "lib/gamelib/gtime.h"
+
+#include <time.h>
+#include <algorithm>
+#include <physfs.h>
+#include <zlib.h>
+
+#include "netreplay.h"
+#include "netplay.h"
+#include "nettypes.h"
+#include "netqueue.h"
+
+#define REPLAY_MAGIC "WZRP"
+#define REPLAY_VERSION 1
+#define REPLAY_END_PLAYER 0xFF
+#define REPLAY_SAVE_CHUNK 65536   ///< Uncompressed bytes to collect before handing them to the compression job.
+#define REPLAY_IO_CHUNK 16384     ///< Size of the compressed buffers used when reading and writing the file.
+#define REPLAY_MAX_SETTINGS 1048576  ///< Far more than the settings JSON ever needs, a longer length means the file is corrupt.
+#define REPLAY_MAX_KEPT 20        ///< Recorded replays to keep, older ones are deleted when starting a new one.
+
+// Recording. saveBuffer is only touched by the main thread, saveHandle and saveDeflate only by the compression jobs, which are chained to run in order.
+static bool                 saving = false;
+static std::vector<uint8_t> saveBuffer;
+static JobHandle            saveJob;
+static PHYSFS_file         *saveHandle = nullptr;
+static z_stream             saveDeflate;
+static bool                 saveError = false;
+
+// Playback.
+static bool                 loading = false;
+static PHYSFS_file         *loadHandle = nullptr;
+static z_stream             loadInflate;
+static uint8_t              loadBuffer[REPLAY_IO_CHUNK];
+static bool                 loadHavePending = false;
+static uint32_t             loadPendingTime = 0;
+static uint8_t              loadPendingPlayer = 0;
+static NetMessage           loadPendingMessage;
+
+static void putUint8(std::vector<uint8_t> &buffer, uint8_t v)
+{
+	buffer.push_back(v);
+}
+
+static void putUint32(std::vector<uint8_t> &buffer, uint32_t v)
+{
+	buffer.push_back(v >> 24);
+	buffer.push_back(v >> 16);
+	buffer.push_back(v >> 8);
+	buffer.push_back(v);
+}
+
+static uint32_t getUint32(uint8_t const *b)
+{
+	return uint32_t(b[0]) << 24 | uint32_t(b[1]) << 16 | uint32_t(b[2]) << 8 | uint32_t(b[3]);
+}
+
+/// Runs in a job. Compresses data into the file, finishing the stream if flush is Z_FINISH.
+static void replayDeflate(std::vector<uint8_t> &data, int flush)
+{
+	uint8_t out[REPLAY_IO_CHUNK];
+
+	saveDeflate.next_in = data.empty() ? nullptr : &data[0];
+	saveDeflate.avail_in = data.size();
+	do
+	{
+		saveDeflate.next_out = out;
+		saveDeflate.avail_out = sizeof(out);
+		int ret = deflate(&saveDeflate, flush);
+		ASSERT(ret != Z_STREAM_ERROR, "zlib compression failed!");
+		size_t have = sizeof(out) - saveDeflate.avail_out;
+		if (have != 0 && !saveError && WZ_PHYSFS_writeBytes(saveHandle, out, have) != (PHYSFS_sint64)have)
+		{
+			debug(LOG_ERROR, "Could not write replay: %s", WZ_PHYSFS_getLastError());
+			saveError = true;  // Keep compressing, so the stream can still be finished and freed.
+		}
+	}
+	while (saveDeflate.avail_out == 0);
+}
+
+/// Hands the collected messages over to be compressed after any earlier ones.
+static void replaySaveFlush(int flush)
+{
+	auto data = std::make_shared<std::vector<uint8_t>>();
+	data->swap(saveBuffer);
+	saveBuffer.reserve(REPLAY_SAVE_CHUNK + 256);
+	saveJob = jobSubmitAfter({saveJob}, [data, flush]() {
+		replayDeflate(*data, flush);
+	});
+}
+
+/// Deletes the oldest replays, so that there is room for one more. The file names sort by the time they were started.
+static void replayDeleteOld()
+{
+	std::vector<std::string> replays;
+	char **files = PHYSFS_enumerateFiles("replay");
+	for (char **i = files; *i != nullptr; ++i)
+	{
+		std::string name = *i;
+		if (name.size() > 5 && name.compare(name.size() - 5, 5, ".wzrp") == 0)
+		{
+			replays.push_back(name);
+		}
+	}
+	PHYSFS_freeList(files);
+
+	std::sort(replays.begin(), replays.end());
+	for (size_t n = 0; n + REPLAY_MAX_KEPT <= replays.size(); ++n)
+	{
+		std::string path = "replay/" + replays[n];
+		if (!PHYSFS_delete(path.c_str()))
+		{
+			debug(LOG_WARNING, "Could not delete old replay %s: %s", path.c_str(), WZ_PHYSFS_getLastError());
+		}
+	}
+}
+
+bool NETreplaySaveStart(nlohmann::json const &settings)
+{
+	ASSERT_OR_RETURN(false, !saving && !loading, "Already recording or playing back a replay");
+
+	replayDeleteOld();
+
+	time_t aclock;
+	time(&aclock);
+	struct tm *newtime = localtime(&aclock);
+	char filename[256];
+	snprintf(filename, sizeof(filename), "replay/%04d%02d%02d_%02d%02d%02d.wzrp", newtime->tm_year + 1900, newtime->tm_mon + 1, newtime->tm_mday, newtime->tm_hour, newtime->tm_min, newtime->tm_sec);
+
+	saveHandle = PHYSFS_openWrite(filename);
+	if (saveHandle == nullptr)
+	{
+		debug(LOG_ERROR, "Could not create replay %s: %s", filename, WZ_PHYSFS_getLastError());
+		return false;
+	}
+
+	std::vector<uint8_t> header(REPLAY_MAGIC, REPLAY_MAGIC + 4);
+	putUint32(header, REPLAY_VERSION);
+	memset(&saveDeflate, 0, sizeof(saveDeflate));
+	if (WZ_PHYSFS_writeBytes(saveHandle, &header[0], header.size()) != (PHYSFS_sint64)header.size() || deflateInit(&saveDeflate, 6) != Z_OK)
+	{
+		debug(LOG_ERROR, "Could not start replay %s", filename);
+		PHYSFS_close(saveHandle);
+		saveHandle = nullptr;
+		return false;
+	}
+
+	std::string settingsString = settings.dump();
+	saveBuffer.clear();
+	saveBuffer.reserve(REPLAY_SAVE_CHUNK + 256);
+	putUint32(saveBuffer, settingsString.size());
+	saveBuffer.insert(saveBuffer.end(), settingsString.begin(), settingsString.end());
+
+	saveError = false;
+	saving = true;
+	debug(LOG_NET, "Recording replay %s", filename);
+	return true;
+}
+
+bool NETreplaySaveStop()
+{
+	if (!saving)
+	{
+		return false;
+	}
+	saving = false;
+
+	putUint32(saveBuffer, gameTime);
+	putUint8(saveBuffer, REPLAY_END_PLAYER);
+	replaySaveFlush(Z_FINISH);
+	saveJob.wait();
+	saveJob = JobHandle();
+
+	deflateEnd(&saveDeflate);
+	bool ok = !saveError;
+	if (!PHYSFS_close(saveHandle))
+	{
+		debug(LOG_ERROR, "Could not close replay: %s", WZ_PHYSFS_getLastError());
+		ok = false;
+	}
+	saveHandle = nullptr;
+	std::vector<uint8_t>().swap(saveBuffer);
+	return ok;
+}
+
+void NETreplaySaveNetMessage(NetMessage const *message, uint8_t player)
+{
+	if (!saving)
+	{
+		return;
+	}
+
+	putUint32(saveBuffer, gameTime);
+	putUint8(saveBuffer, player);
+	putUint8(saveBuffer, message->type);
+	putUint32(saveBuffer, message->data.size());
+	saveBuffer.insert(saveBuffer.end(), message->data.begin(), message->data.end());
+
+	if (saveBuffer.size() >= REPLAY_SAVE_CHUNK)
+	{
+		replaySaveFlush(Z_NO_FLUSH);
+	}
+}
+
+/// Decompresses exactly len bytes from the replay.
+static bool replayRead(uint8_t *out, size_t len)
+{
+	loadInflate.next_out = out;
+	loadInflate.avail_out = len;
+	while (loadInflate.avail_out != 0)
+	{
+		if (loadInflate.avail_in == 0)
+		{
+			PHYSFS_sint64 got = WZ_PHYSFS_readBytes(loadHandle, loadBuffer, sizeof(loadBuffer));
+			if (got <= 0)
+			{
+				return false;  // Truncated, such as if the game crashed while recording.
+			}
+			loadInflate.next_in = loadBuffer;
+			loadInflate.avail_in = got;
+		}
+		int ret = inflate(&loadInflate, Z_NO_FLUSH);
+		if (ret == Z_STREAM_END)
+		{
+			return loadInflate.avail_out == 0;
+		}
+		if (ret != Z_OK)
+		{
+			debug(LOG_ERROR, "Couldn't decompress replay. zlib error %s", loadInflate.msg != nullptr ? loadInflate.msg : "(unknown)");
+			return false;
+		}
+	}
+	return true;
+}
+
+/// Reads the next record into loadPending*. Returns false at the end of the replay.
+static bool replayReadRecord()
+{
+	uint8_t header[4 + 1 + 1 + 4];
+	if (!replayRead(header, 4 + 1))
+	{
+		debug(LOG_WARNING, "Replay ends without an end marker.");
+		return false;
+	}
+	loadPendingTime = getUint32(header);
+	loadPendingPlayer = header[4];
+	if (loadPendingPlayer == REPLAY_END_PLAYER)
+	{
+		return false;
+	}
+	if (loadPendingPlayer >= MAX_PLAYERS || !replayRead(header + 5, 1 + 4))
+	{
+		debug(LOG_ERROR, "Corrupt replay record.");
+		return false;
+	}
+	uint32_t length = getUint32(header + 6);
+	if (length >= MAX_NET_MESSAGE_SIZE)
+	{
+		debug(LOG_ERROR, "Corrupt replay record, message of %u bytes is longer than any message sent.", length);
+		return false;
+	}
+	loadPendingMessage.type = header[5];
+	loadPendingMessage.data.resize(length);
+	if (!loadPendingMessage.data.empty() && !replayRead(&loadPendingMessage.data[0], loadPendingMessage.data.size()))
+	{
+		debug(LOG_ERROR, "Corrupt replay record.");
+		return false;
+	}
+	return true;
+}
+
+static void replayLoadClose()
+{
+	if (loadHandle != nullptr)
+	{
+		inflateEnd(&loadInflate);
+		PHYSFS_close(loadHandle);
+		loadHandle = nullptr;
+	}
+	loadHavePending = false;
+	loadPendingMessage = NetMessage();
+}
+
+bool NETreplayLoadStart(std::string const &filename, nlohmann::json &settings)
+{
+	ASSERT_OR_RETURN(false, !saving && !loading, "Already recording or playing back a replay");
+
+	loadHandle = PHYSFS_openRead(filename.c_str());
+	if (loadHandle == nullptr)
+	{
+		debug(LOG_ERROR, "Could not open replay %s: %s", filename.c_str(), WZ_PHYSFS_getLastError());
+		return false;
+	}
+
+	uint8_t header[8];
+	memset(&loadInflate, 0, sizeof(loadInflate));
+	if (WZ_PHYSFS_readBytes(loadHandle, header, sizeof(header)) != sizeof(header) || memcmp(header, REPLAY_MAGIC, 4) != 0)
+	{
+		debug(LOG_ERROR, "%s is not a replay.", filename.c_str());
+		PHYSFS_close(loadHandle);
+		loadHandle = nullptr;
+		return false;
+	}
+	if (getUint32(header + 4) != REPLAY_VERSION)
+	{
+		debug(LOG_ERROR, "Replay %s has version %u, but only version %u is supported.", filename.c_str(), getUint32(header + 4), REPLAY_VERSION);
+		PHYSFS_close(loadHandle);
+		loadHandle = nullptr;
+		return false;
+	}
+	if (inflateInit(&loadInflate) != Z_OK)
+	{
+		debug(LOG_ERROR, "inflateInit failed!");
+		PHYSFS_close(loadHandle);
+		loadHandle = nullptr;
+		return false;
+	}
+
+	uint8_t lengthBytes[4];
+	std::string settingsString;
+	if (replayRead(lengthBytes, 4))
+	{
+		uint32_t length = getUint32(lengthBytes);
+		if (length > REPLAY_MAX_SETTINGS)
+		{
+			debug(LOG_ERROR, "Replay %s is corrupt, its settings claim to be %u bytes long.", filename.c_str(), length);
+			replayLoadClose();
+			return false;
+		}
+		settingsString.resize(length);
+	}
+	if (settingsString.empty() || !replayRead(reinterpret_cast<uint8_t *>(&settingsString[0]), settingsString.size()))
+	{
+		debug(LOG_ERROR, "Replay %s has no settings.", filename.c_str());
+		replayLoadClose();
+		return false;
+	}
+	try
+	{
+		settings = nlohmann::json::parse(settingsString);
+	}
+	catch (const std::exception &e)
+	{
+		debug(LOG_ERROR, "Replay %s has bad settings: %s", filename.c_str(), e.what());
+		replayLoadClose();
+		return false;
+	}
+
+	loading = true;
+	debug(LOG_NET, "Playing back replay %s", filename.c_str());
+	return true;
+}
+
+bool NETreplayLoadStop()
+{
+	if (!loading)
+	{
+		return false;
+	}
+	loading = false;
+	replayLoadClose();
+	return true;
+}
+
+void NETreplayLoadNetMessages(uint32_t time)
+{
+	while (loadHandle != nullptr)
+	{
+		if (!loadHavePending)
+		{
+			loadHavePending = replayReadRecord();
+			if (!loadHavePending)
+			{
+				debug(LOG_INFO, "Replay finished at gameTime %u.", time);
+				replayLoadClose();  // Stay in playback mode, so the game waits instead of running on without the recorded players.
+				return;
+			}
+		}
+		if (loadPendingTime > time)
+		{
+			return;  // Not read yet at this time.
+		}
+		NETinsertMessageFromNet(NETgameQueue(loadPendingPlayer), &loadPendingMessage);
+		loadHavePending = false;
+	}
+}
+
+bool NETisReplay()
+{
+	return loading;
+}
@@ -0,0 +1,54 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Recording and playback of the game message queues.
+ *
+ *  Since all clients process the same game messages in the same order, the settings a game started with, plus
+ *  every message read from the game queues, are enough to play the whole game again. While recording, messages
+ *  are logged as they are popped, tagged with the gameTime they were read at, and compressed on a worker thread.
+ *  While playing back, the recorded messages are inserted into the game queues as gameTime reaches them, and any
+ *  game messages generated locally are dropped.
+ */
+
+#ifndef __INCLUDED_LIB_NETPLAY_NETREPLAY_H__
+#define __INCLUDED_LIB_NETPLAY_NETREPLAY_H__
+
+#include "lib/framework/frame.h"
+#include <3rdparty/json/json.hpp>
+
+class NetMessage;
+
+/// Starts recording to a new file in the replay directory, which begins with the given game settings. Only the newest few replays are kept.
+bool NETreplaySaveStart(nlohmann::json const &settings);
+/// Finishes the replay file, if recording.
+bool NETreplaySaveStop();
+/// Records a message read from the game queue of player, if recording.
+void NETreplaySaveNetMessage(NetMessage const *message, uint8_t player);
+
+/// Opens a replay file for playback, returning the game settings it was recorded with.
+bool NETreplayLoadStart(std::string const &filename, nlohmann::json &settings);
+/// Stops playback, if playing back.
+bool NETreplayLoadStop();
+/// Inserts all recorded messages which were read at or before time into the game queues.
+void NETreplayLoadNetMessages(uint32_t time);
+
+/// True while playing back a replay.
+bool NETisReplay();
+
+#endif // __INCLUDED_LIB_NETPLAY_NETREPLAY_H__
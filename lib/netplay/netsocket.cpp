@@ -78,6 +78,9 @@ struct Socket
 struct SocketSet
 {
 	std::vector<Socket *> fds;
+#if defined(WZ_OS_UNIX)
+	mutable std::vector<pollfd> pollFds;  ///< Kept in step with fds by SocketSet_AddSocket/SocketSet_DelSocket, so checkSockets doesn't rebuild it each call.
+#endif
 };
 
 
@@ -325,7 +328,8 @@ const char *strSockError(int error)
  */
 static bool connectionIsOpen(Socket *sock)
 {
-	const SocketSet set = {std::vector<Socket *>(1, sock)};
+	SocketSet set;
+	set.fds.push_back(sock);
 
 	ASSERT_OR_RETURN((setSockErr(EBADF), false),
 	                 sock && sock->fd[SOCK_CONNECTION] != INVALID_SOCKET, "Invalid socket");
@@ -721,6 +725,15 @@ void socketFlush(Socket *sock, size_t *rawByteCount)
 	sock->zDeflateOutBuf.clear();
 }
 
+size_t socketWriteQueueSize(Socket const *sock)
+{
+	wzMutexLock(socketThreadMutex);
+	SocketThreadWriteMap::const_iterator i = socketThreadWrites.find(const_cast<Socket *>(sock));
+	size_t size = i != socketThreadWrites.end() ? i->second.size() : 0;
+	wzMutexUnlock(socketThreadMutex);
+	return size;
+}
+
 void socketBeginCompression(Socket *sock)
 {
 	if (sock->isCompressed)
@@ -788,6 +801,10 @@ void SocketSet_AddSocket(SocketSet *set, Socket *socket)
 	}
 
 	set->fds.push_back(socket);
+#if defined(WZ_OS_UNIX)
+	pollfd pfd = {socket->fd[SOCK_CONNECTION], POLLIN, 0};
+	set->pollFds.push_back(pfd);
+#endif
 	debug(LOG_NET, "Socket added: set->fds[%lu] = %p", (unsigned long)i, static_cast<void *>(socket));
 }
 
@@ -801,6 +818,12 @@ void SocketSet_DelSocket(SocketSet *set, Socket *socket)
 	{
 		debug(LOG_NET, "Socket %p erased (set->fds[%lu])", static_cast<void *>(socket), (unsigned long)i);
 		set->fds.erase(set->fds.begin() + i);
+#if defined(WZ_OS_UNIX)
+		if (i < set->pollFds.size())
+		{
+			set->pollFds.erase(set->pollFds.begin() + i);
+		}
+#endif
 	}
 }
 
@@ -863,9 +886,7 @@ int checkSockets(const SocketSet *set, unsigned int timeout)
 		return 0;
 	}
 
-#if   defined(WZ_OS_UNIX)
-	SOCKET maxfd = INT_MIN;
-#elif defined(WZ_OS_WIN)
+#if !defined(WZ_OS_UNIX)
 	SOCKET maxfd = 0;
 #endif
 
@@ -880,7 +901,9 @@ int checkSockets(const SocketSet *set, unsigned int timeout)
 			break;
 		}
 
+#if !defined(WZ_OS_UNIX)
 		maxfd = std::max(maxfd, set->fds[i]->fd[SOCK_CONNECTION]);
+#endif
 	}
 
 	if (compressedReady)
@@ -896,6 +919,40 @@ int checkSockets(const SocketSet *set, unsigned int timeout)
 		return ret;
 	}
 
+#if defined(WZ_OS_UNIX)
+	// Unlike select(), poll() doesn't need the descriptors rebuilt into an fd_set on each call, and isn't limited to FD_SETSIZE.
+	if (set->pollFds.size() != set->fds.size())
+	{
+		// Sets constructed directly, rather than with SocketSet_AddSocket.
+		set->pollFds.clear();
+		for (size_t i = 0; i < set->fds.size(); ++i)
+		{
+			pollfd pfd = {set->fds[i]->fd[SOCK_CONNECTION], POLLIN, 0};
+			set->pollFds.push_back(pfd);
+		}
+	}
+
+	int ret;
+	do
+	{
+		ret = poll(&set->pollFds[0], set->pollFds.size(), (int)timeout);
+	}
+	while (ret == SOCKET_ERROR && getSockErr() == EINTR);
+
+	if (ret == SOCKET_ERROR)
+	{
+		debug(LOG_ERROR, "poll failed: %s", strSockError(getSockErr()));
+		return SOCKET_ERROR;
+	}
+
+	for (size_t i = 0; i < set->fds.size(); ++i)
+	{
+		// Hangups and errors count as readable, so that the next read finds out about them.
+		set->fds[i]->ready = (set->pollFds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+	}
+
+	return ret;
+#else
 	int ret;
 	fd_set fds;
 	do
@@ -926,6 +983,7 @@ int checkSockets(const SocketSet *set, unsigned int timeout)
 	}
 
 	return ret;
+#endif
 }
 
 /**
@@ -946,7 +1004,8 @@ ssize_t readAll(Socket *sock, void *buf, size_t size, unsigned int timeout)
 {
 	ASSERT(!sock->isCompressed, "readAll on compressed sockets not implemented.");
 
-	const SocketSet set = {std::vector<Socket *>(1, sock)};
+	SocketSet set;
+	set.fds.push_back(sock);
 
 	size_t received = 0;
 
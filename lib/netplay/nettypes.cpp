@@ -38,6 +38,7 @@
 #include "nettypes.h"
 #include "netqueue.h"
 #include "netlog.h"
+#include "netreplay.h"
 #include "src/order.h"
 #include <cstring>
 
@@ -474,6 +475,13 @@ bool NETend()
 	// If we are encoding just return true
 	if (NETgetPacketDir() == PACKET_ENCODE)
 	{
+		if (NETisReplay() && (queueInfo.queueType == QUEUE_GAME || queueInfo.queueType == QUEUE_GAME_FORCED))
+		{
+			// The replay already holds every game message, so anything we generate ourselves would be a duplicate.
+			NETsetPacketDir(PACKET_INVALID);
+			return true;
+		}
+
 		// Push the message onto the list.
 		NetQueue *queue = sendQueue(queueInfo);
 		if (queue == nullptr) {
@@ -585,6 +593,10 @@ void NETflushGameQueues()
 
 void NETpop(NETQUEUE queue)
 {
+	if (queue.queueType == QUEUE_GAME)
+	{
+		NETreplaySaveNetMessage(&receiveQueue(queue)->getMessage(), queue.index);
+	}
 	receiveQueue(queue)->popMessage();
 }
 
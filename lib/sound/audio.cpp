@@ -30,9 +30,15 @@
 #include "audio_id.h"
 #include "openal_error.h"
 #include "mixer.h"
+
+#include <algorithm>
+#include <vector>
+
 // defines
 #define NO_SAMPLE				- 2
 #define MAX_SAME_SAMPLES		2
+#define MAX_SAME_3D_VOICES		8	// positional samples of one track playing at once, anywhere
+#define MAX_3D_VOICES			64	// positional samples playing at once, keeps us well within the OpenAL sources
 
 // global variables
 static AUDIO_SAMPLE *g_psSampleList = nullptr;
@@ -42,6 +48,12 @@ static bool			g_bAudioPaused = false;
 static AUDIO_SAMPLE g_sPreviousSample;
 static int			g_iPreviousSampleTime = 0;
 
+// positional samples which are playing, by track and all together
+static std::vector<AUDIO_SAMPLE *> g_ap3DVoicesByTrack[MAX_TRACKS];
+static std::vector<AUDIO_SAMPLE *> g_ap3DVoices;
+
+static void audio_ForgetAll3DVoices(void);
+
 /** Counts the number of samples in the SampleQueue
  *  \return the number of samples in the SampleQueue
  */
@@ -135,6 +147,8 @@ bool audio_Shutdown(void)
 	sound_StopAll();
 	bOK = sound_Shutdown();
 
+	audio_ForgetAll3DVoices();
+
 	// empty sample list
 	psSample = g_psSampleList;
 	while (psSample != nullptr)
@@ -283,6 +297,44 @@ static void audio_RemoveSample(AUDIO_SAMPLE **ppsSampleList, AUDIO_SAMPLE *psSam
 	psSample->psNext = nullptr;
 }
 
+//*
+//
+// audio_Forget3DVoice Stops counting a sample against the positional voice limits
+
+//*
+// =======================================================================================================================
+// =======================================================================================================================
+//
+static void audio_Forget3DVoice(AUDIO_SAMPLE *psSample)
+{
+	if (psSample->iTrack < 0 || psSample->iTrack >= MAX_TRACKS)
+	{
+		return;
+	}
+
+	std::vector<AUDIO_SAMPLE *> &voices = g_ap3DVoicesByTrack[psSample->iTrack];
+	auto it = std::find(voices.begin(), voices.end(), psSample);
+	if (it == voices.end())
+	{
+		return;  // Not a positional sample, or already forgotten.
+	}
+	voices.erase(it);
+	g_ap3DVoices.erase(std::find(g_ap3DVoices.begin(), g_ap3DVoices.end(), psSample));
+}
+
+//*
+// =======================================================================================================================
+// =======================================================================================================================
+//
+static void audio_ForgetAll3DVoices(void)
+{
+	for (AUDIO_SAMPLE *psSample : g_ap3DVoices)
+	{
+		g_ap3DVoicesByTrack[psSample->iTrack].clear();
+	}
+	g_ap3DVoices.clear();
+}
+
 //*
 // =======================================================================================================================
 // =======================================================================================================================
@@ -578,6 +630,7 @@ void audio_Update()
 		{
 			psSampleTemp = psSample->psNext;
 			audio_RemoveSample(&g_psSampleList, psSample);
+			audio_Forget3DVoice(psSample);
 			free(psSample);
 			psSample = psSampleTemp;
 		}
@@ -627,23 +680,32 @@ unsigned int audio_SetTrackVals(const char *fileName, bool loop, unsigned int vo
 	return sound_SetTrackVals(fileName, loop, volume, audibleRadius);
 }
 
+/// Squared distance from the listener to a sound at x, y, z.
+static float audio_ListenerDistSq(SDWORD x, SDWORD y, SDWORD z, float listenerX, float listenerY, float listenerZ)
+{
+	float dx = (float)x - listenerX, dy = (float)y - listenerY, dz = (float)z - listenerZ;
+	return dx * dx + dy * dy + dz * dz;
+}
+
 //*
 //
 //
-// * audio_CheckSame3DTracksPlaying Reject samples if too many already playing in
-// * same area
+// * audio_Reserve3DVoice Reject samples if too many already playing in same
+// * area, and make sure the closest samples get the limited amount of voices.
+// * Only looks at samples of the same track, unless all voices are taken, so
+// * the cost doesn't grow with the amount of sounds playing.
 //
 
 //*
 // =======================================================================================================================
 // =======================================================================================================================
 //
-static bool audio_CheckSame3DTracksPlaying(SDWORD iTrack, SDWORD iX, SDWORD iY, SDWORD iZ)
+static bool audio_Reserve3DVoice(SDWORD iTrack, SDWORD iX, SDWORD iY, SDWORD iZ, float listenerX, float listenerY, float listenerZ)
 {
 	//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 	SDWORD			iCount, iDx, iDy, iDz, iDistSq, iMaxDistSq, iRad;
-	AUDIO_SAMPLE	*psSample = nullptr;
-	bool			bOK = true;
+	AUDIO_SAMPLE	*psFarthest = nullptr;
+	float			fDistSq, fFarthestDistSq;
 	//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 	// return if audio not enabled
@@ -652,36 +714,75 @@ static bool audio_CheckSame3DTracksPlaying(SDWORD iTrack, SDWORD iX, SDWORD iY,
 		return true;
 	}
 
+	ASSERT_OR_RETURN(false, iTrack >= 0 && iTrack < MAX_TRACKS, "Track %d out of range", iTrack);
+	std::vector<AUDIO_SAMPLE *> &voices = g_ap3DVoicesByTrack[iTrack];
+
 	iCount = 0;
+	iRad = sound_GetTrackAudibleRadius(iTrack);
+	iMaxDistSq = iRad * iRad;
+	fFarthestDistSq = audio_ListenerDistSq(iX, iY, iZ, listenerX, listenerY, listenerZ);
+
+	// check whether too many of this track already in earshot, and which one is farthest from the listener
+	for (AUDIO_SAMPLE *psSample : voices)
+	{
+		iDx = iX - psSample->x;
+		iDy = iY - psSample->y;
+		iDz = iZ - psSample->z;
+		iDistSq = (iDx * iDx) + (iDy * iDy) + (iDz * iDz);
+		if (iDistSq < iMaxDistSq)
+		{
+			iCount++;
+		}
 
-	// loop through 3D sounds and check whether too many already in earshot
-	psSample = g_psSampleList;
-	while (psSample != nullptr)
+		if (iCount > MAX_SAME_SAMPLES)
+		{
+			return false;
+		}
+
+		if (sound_TrackLooped(psSample->iTrack))
+		{
+			continue;  // A stopped looping sound never starts again, so only one-shot sounds make room.
+		}
+		fDistSq = audio_ListenerDistSq(psSample->x, psSample->y, psSample->z, listenerX, listenerY, listenerZ);
+		if (fDistSq > fFarthestDistSq)
+		{
+			psFarthest = psSample;
+			fFarthestDistSq = fDistSq;
+		}
+	}
+
+	if (voices.size() < MAX_SAME_3D_VOICES && g_ap3DVoices.size() < MAX_3D_VOICES)
 	{
-		if (psSample->iTrack == iTrack)
+		return true;
+	}
+
+	// Out of voices; if all are taken, any track's farthest sample may make room
+	if (voices.size() < MAX_SAME_3D_VOICES)
+	{
+		for (AUDIO_SAMPLE *psSample : g_ap3DVoices)
 		{
-			iDx = iX - psSample->x;
-			iDy = iY - psSample->y;
-			iDz = iZ - psSample->z;
-			iDistSq = (iDx * iDx) + (iDy * iDy) + (iDz * iDz);
-			iRad = sound_GetTrackAudibleRadius(iTrack);
-			iMaxDistSq = iRad * iRad;
-			if (iDistSq < iMaxDistSq)
+			if (sound_TrackLooped(psSample->iTrack))
 			{
-				iCount++;
+				continue;
 			}
-
-			if (iCount > MAX_SAME_SAMPLES)
+			fDistSq = audio_ListenerDistSq(psSample->x, psSample->y, psSample->z, listenerX, listenerY, listenerZ);
+			if (fDistSq > fFarthestDistSq)
 			{
-				bOK = false;
-				break;
+				psFarthest = psSample;
+				fFarthestDistSq = fDistSq;
 			}
 		}
+	}
 
-		psSample = psSample->psNext;
+	// reject the new sample if every one-shot sound playing is closer to the listener
+	if (psFarthest == nullptr)
+	{
+		return false;
 	}
 
-	return bOK;
+	audio_Forget3DVoice(psFarthest);
+	sound_StopTrack(psFarthest);
+	return true;
 }
 
 //*
@@ -703,11 +804,6 @@ static bool audio_Play3DTrack(SDWORD iX, SDWORD iY, SDWORD iZ, int iTrack, SIMPL
 		return false;
 	}
 
-	if (audio_CheckSame3DTracksPlaying(iTrack, iX, iY, iZ) == false)
-	{
-		return false;
-	}
-
 	// compute distance
 	// NOTE, if this call fails, expect garbage
 	alGetListener3f(AL_POSITION, &listenerX, &listenerY, &listenerZ);
@@ -737,6 +833,11 @@ static bool audio_Play3DTrack(SDWORD iX, SDWORD iY, SDWORD iZ, int iTrack, SIMPL
 		return false;
 	}
 
+	if (audio_Reserve3DVoice(iTrack, iX, iY, iZ, listenerX, listenerY, listenerZ) == false)
+	{
+		return false;
+	}
+
 	psSample = (AUDIO_SAMPLE *)malloc(sizeof(AUDIO_SAMPLE));
 	if (psSample == nullptr)
 	{
@@ -763,6 +864,8 @@ static bool audio_Play3DTrack(SDWORD iX, SDWORD iY, SDWORD iZ, int iTrack, SIMPL
 	}
 
 	audio_AddSampleToHead(&g_psSampleList, psSample);
+	g_ap3DVoicesByTrack[iTrack].push_back(psSample);
+	g_ap3DVoices.push_back(psSample);
 	return true;
 }
 
@@ -1050,6 +1153,7 @@ void audio_StopAll(void)
 		// invoked by stageThreeShutDown().
 		psSample->psObj = nullptr;
 	}
+	audio_ForgetAll3DVoices();
 
 	// empty sample queue
 	psSample = g_psSampleQueue;
@@ -1166,6 +1270,7 @@ void audio_RemoveObj(SIMPLE_OBJECT const *psObj)
 
 			// Perform the actual task of destroying this sample
 			audio_RemoveSample(&g_psSampleList, toRemove);
+			audio_Forget3DVoice(toRemove);
 			free(toRemove);
 
 			// Increment the deletion count
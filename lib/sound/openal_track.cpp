@@ -39,6 +39,11 @@
 #include "lib/framework/physfs_ext.h"
 #include <string.h>
 #include <math.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "lib/framework/wzapp.h"
 
 #include "tracklib.h"
 #include "audio.h"
@@ -51,6 +56,15 @@ static ALuint current_queue_sample = -1;
 
 static bool openal_initialized = false;
 
+/** Amount of chunks the stream decoder thread keeps decoded ahead of playback, per stream */
+#define STREAM_DECODE_AHEAD	4
+
+/** Total size of decoded effect tracks to keep around, for when the same track is loaded again */
+#define DECODED_TRACK_CACHE_SIZE	(32 * 1024 * 1024)
+
+/** Tracks which decode to more than this aren't short effects, and aren't worth caching */
+#define DECODED_TRACK_MAX_SIZE	(2 * 1024 * 1024)
+
 struct AUDIO_STREAM
 {
 	ALuint                  source;        // OpenAL name of the sound source
@@ -64,10 +78,33 @@ struct AUDIO_STREAM
 
 	size_t                  bufferSize;
 
+	// OpenAL buffers of this stream, and those of them not queued on the source right now
+	ALuint                 *buffers;
+	ALuint                 *idleBuffers;
+	unsigned int            bufferCount;
+	unsigned int            idleCount;
+
+	// Ring of chunks decoded by the stream decoder thread, protected by streamMutex
+	soundDataBuffer        *decoded[STREAM_DECODE_AHEAD];
+	unsigned int            decodedFirst;
+	unsigned int            decodedCount;
+	bool                    decoding;       // the decoder thread is using our decoder right now
+	bool                    decodeFinished; // the decoder reached the end of the file
+
+	bool                    started;        // playing started with the first decoded chunks
+	bool                    paused;         // paused before playing even started
+	bool                    stopRequested;  // sound_StopStream() was called
+
 	// Linked list pointer
 	AUDIO_STREAM           *next;
 };
 
+struct DECODED_TRACK
+{
+	std::string             key;           // file name, location and size of the track
+	soundDataBuffer        *soundBuffer;
+};
+
 struct SAMPLE_LIST
 {
 	AUDIO_SAMPLE   *curr;
@@ -78,6 +115,17 @@ static SAMPLE_LIST *active_samples = nullptr;
 
 static AUDIO_STREAM *active_streams = nullptr;
 
+// Stream decoder thread; active_streams may only be changed with streamMutex locked
+static WZ_THREAD        *streamThread = nullptr;
+static WZ_MUTEX         *streamMutex = nullptr;
+static WZ_SEMAPHORE     *streamSemaphore = nullptr;
+static volatile bool     streamThreadQuit = false;
+
+// Decoded effect tracks, most recently used first
+static std::list<DECODED_TRACK> decodedTracks;
+static std::unordered_map<std::string, std::list<DECODED_TRACK>::iterator> decodedTrackIndex;
+static size_t decodedTracksSize = 0;
+
 static ALfloat		sfx_volume = 1.0;
 static ALfloat		sfx3d_volume = 1.0;
 
@@ -110,6 +158,112 @@ static void sound_RemoveSample(SAMPLE_LIST *previous, SAMPLE_LIST *to_remove)
 	}
 }
 
+/** Finds a stream which has room for more decoded data
+ *  \note Must be called with streamMutex locked.
+ */
+static AUDIO_STREAM *sound_FindStreamToDecode()
+{
+	for (AUDIO_STREAM *stream = active_streams; stream != nullptr; stream = stream->next)
+	{
+		if (!stream->decoding && !stream->decodeFinished && !stream->stopRequested && stream->decodedCount < STREAM_DECODE_AHEAD)
+		{
+			return stream;
+		}
+	}
+	return nullptr;
+}
+
+/** This runs in a separate thread, and decodes the data of all streams ahead of
+ *  playback, so the main loop only has to hand it over to OpenAL.
+ */
+static int sound_StreamThreadFunc(void *)
+{
+	wzMutexLock(streamMutex);
+
+	while (!streamThreadQuit)
+	{
+		AUDIO_STREAM *stream = sound_FindStreamToDecode();
+		if (stream == nullptr)
+		{
+			wzMutexUnlock(streamMutex);
+			wzSemaphoreWait(streamSemaphore);  // Go to sleep until needed.
+			wzMutexLock(streamMutex);
+			continue;
+		}
+
+		stream->decoding = true;
+		wzMutexUnlock(streamMutex);
+		soundDataBuffer *soundBuffer = sound_DecodeOggVorbis(stream->decoder, stream->bufferSize);
+		wzMutexLock(streamMutex);
+		stream->decoding = false;
+
+		if (soundBuffer && soundBuffer->size > 0)
+		{
+			stream->decoded[(stream->decodedFirst + stream->decodedCount) % STREAM_DECODE_AHEAD] = soundBuffer;
+			++stream->decodedCount;
+		}
+		else
+		{
+			// No more data, so we're at the end of the stream
+			free(soundBuffer);
+			stream->decodeFinished = true;
+		}
+	}
+	wzMutexUnlock(streamMutex);
+	return 0;
+}
+
+/** Looks up the decoded data of a previously loaded track, and marks it as most recently used
+ *  \return the decoded data, still owned by the cache, or NULL if not cached
+ */
+static soundDataBuffer *sound_FindDecodedTrack(const std::string &key)
+{
+	auto it = decodedTrackIndex.find(key);
+	if (it == decodedTrackIndex.end())
+	{
+		return nullptr;
+	}
+	decodedTracks.splice(decodedTracks.begin(), decodedTracks, it->second);
+	return it->second->soundBuffer;
+}
+
+/** Keeps the decoded data of a short track around, evicting the least recently used tracks
+ *  when the cache grows beyond DECODED_TRACK_CACHE_SIZE.
+ *  \return true if the cache took ownership of \c soundBuffer
+ */
+static bool sound_CacheDecodedTrack(const std::string &key, soundDataBuffer *soundBuffer)
+{
+	if (soundBuffer->size == 0 || soundBuffer->size > DECODED_TRACK_MAX_SIZE || decodedTrackIndex.count(key) != 0)
+	{
+		return false;
+	}
+
+	decodedTracks.push_front(DECODED_TRACK{key, soundBuffer});
+	decodedTrackIndex[key] = decodedTracks.begin();
+	decodedTracksSize += soundBuffer->size;
+
+	while (decodedTracksSize > DECODED_TRACK_CACHE_SIZE && decodedTracks.size() > 1)
+	{
+		DECODED_TRACK &oldest = decodedTracks.back();
+		decodedTracksSize -= oldest.soundBuffer->size;
+		free(oldest.soundBuffer);
+		decodedTrackIndex.erase(oldest.key);
+		decodedTracks.pop_back();
+	}
+	return true;
+}
+
+static void sound_ClearDecodedTracks()
+{
+	for (DECODED_TRACK &track : decodedTracks)
+	{
+		free(track.soundBuffer);
+	}
+	decodedTracks.clear();
+	decodedTrackIndex.clear();
+	decodedTracksSize = 0;
+}
+
 //*
 // =======================================================================================================================
 // =======================================================================================================================
@@ -211,6 +365,15 @@ bool sound_InitLibrary(void)
 	alDistanceModel(AL_NONE);
 	sound_GetError();
 
+	if (!streamThread)
+	{
+		streamThreadQuit = false;
+		streamMutex = wzMutexCreate();
+		streamSemaphore = wzSemaphoreCreate(0);
+		streamThread = wzThreadCreate(sound_StreamThreadFunc, nullptr);
+		wzThreadStart(streamThread);
+	}
+
 	return true;
 }
 
@@ -234,6 +397,22 @@ void sound_ShutdownLibrary(void)
 	}
 	sound_UpdateStreams();
 
+	if (streamThread)
+	{
+		// Signal the stream decoder thread to quit
+		streamThreadQuit = true;
+		wzSemaphorePost(streamSemaphore);  // Wake up thread.
+
+		wzThreadJoin(streamThread);
+		streamThread = nullptr;
+		wzMutexDestroy(streamMutex);
+		streamMutex = nullptr;
+		wzSemaphoreDestroy(streamSemaphore);
+		streamSemaphore = nullptr;
+	}
+
+	sound_ClearDecodedTracks();
+
 	alcGetError(device);	// clear error codes
 
 	/* On Linux since this caused some versions of OpenAL to hang on exit. - Per */
@@ -444,48 +623,57 @@ bool sound_QueueSamplePlaying(void)
 /** Decodes an opened OggVorbis file into an OpenAL buffer
  *  \param psTrack pointer to object which will contain the final buffer
  *  \param PHYSFS_fileHandle file handle given by PhysicsFS to the opened file
+ *  \param cacheKey identifies the file in the cache of decoded tracks
  *  \return on success the psTrack pointer, otherwise it will be free'd and a NULL pointer is returned instead
  */
-static inline TRACK *sound_DecodeOggVorbisTrack(TRACK *psTrack, PHYSFS_file *PHYSFS_fileHandle)
+static inline TRACK *sound_DecodeOggVorbisTrack(TRACK *psTrack, PHYSFS_file *PHYSFS_fileHandle, const std::string &cacheKey)
 {
 	ALenum		format;
 	ALuint		buffer;
 	struct OggVorbisDecoderState *decoder;
 	soundDataBuffer	*soundBuffer;
+	bool		cached = true;
 
 	if (!openal_initialized)
 	{
 		return nullptr;
 	}
 
-	decoder = sound_CreateOggVorbisDecoder(PHYSFS_fileHandle, true);
-	if (decoder == nullptr)
+	// Only decode the file if we haven't decoded it for an earlier level already
+	soundBuffer = sound_FindDecodedTrack(cacheKey);
+	if (soundBuffer == nullptr)
 	{
-		debug(LOG_WARNING, "Failed to open audio file for decoding");
-		free(psTrack);
-		return nullptr;
-	}
+		decoder = sound_CreateOggVorbisDecoder(PHYSFS_fileHandle, true);
+		if (decoder == nullptr)
+		{
+			debug(LOG_WARNING, "Failed to open audio file for decoding");
+			free(psTrack);
+			return nullptr;
+		}
 
-	soundBuffer = sound_DecodeOggVorbis(decoder, 0);
-	sound_DestroyOggVorbisDecoder(decoder);
+		soundBuffer = sound_DecodeOggVorbis(decoder, 0);
+		sound_DestroyOggVorbisDecoder(decoder);
 
-	if (soundBuffer == nullptr)
-	{
-		free(psTrack);
-		return nullptr;
-	}
+		if (soundBuffer == nullptr)
+		{
+			free(psTrack);
+			return nullptr;
+		}
 
-	if (soundBuffer->size == 0)
-	{
-		debug(LOG_WARNING, "sound_DecodeOggVorbisTrack: OggVorbis track is entirely empty after decoding");
+		if (soundBuffer->size == 0)
+		{
+			debug(LOG_WARNING, "sound_DecodeOggVorbisTrack: OggVorbis track is entirely empty after decoding");
 // NOTE: I'm not entirely sure if a track that's empty after decoding should be
 //       considered an error condition. Therefore I'll only error out on DEBUG
 //       builds. (Returning NULL here __will__ result in a program termination.)
 #ifdef DEBUG
-		free(soundBuffer);
-		free(psTrack);
-		return NULL;
+			free(soundBuffer);
+			free(psTrack);
+			return NULL;
 #endif
+		}
+
+		cached = sound_CacheDecodedTrack(cacheKey, soundBuffer);
 	}
 
 	// Determine PCM data format
@@ -497,7 +685,10 @@ static inline TRACK *sound_DecodeOggVorbisTrack(TRACK *psTrack, PHYSFS_file *PHY
 	alBufferData(buffer, format, soundBuffer->data, soundBuffer->size, soundBuffer->frequency);
 	sound_GetError();
 
-	free(soundBuffer);
+	if (!cached)
+	{
+		free(soundBuffer);
+	}
 
 	// save buffer name in track
 	psTrack->iBufferName = buffer;
@@ -561,8 +752,12 @@ TRACK *sound_LoadTrackFromFile(const char *fileName)
 	}
 	pTrack->fileName = track_name;
 
+	// Decoded tracks are cached by name, location and size, so a file replaced by a mod doesn't hit the cache
+	const char *realDir = PHYSFS_getRealDir(fileName);
+	std::string cacheKey = std::string(realDir ? realDir : "") + "/" + fileName + ":" + std::to_string(PHYSFS_fileLength(fileHandle));
+
 	// Now use sound_ReadTrackFromBuffer to decode the file's contents
-	pTrack = sound_DecodeOggVorbisTrack(pTrack, fileHandle);
+	pTrack = sound_DecodeOggVorbisTrack(pTrack, fileHandle, cacheKey);
 
 	PHYSFS_close(fileHandle);
 	return pTrack;
@@ -791,9 +986,7 @@ AUDIO_STREAM *sound_PlayStream(PHYSFS_file *fileHandle, float volume, void (*onF
 AUDIO_STREAM *sound_PlayStreamWithBuf(PHYSFS_file *fileHandle, float volume, void (*onFinished)(const void *), const void *user_data, size_t streamBufferSize, unsigned int buffer_count)
 {
 	AUDIO_STREAM *stream;
-	ALuint       *buffers = (ALuint *)alloca(sizeof(ALuint) * buffer_count);
 	ALint error;
-	unsigned int i;
 
 	if (!openal_initialized)
 	{
@@ -801,13 +994,17 @@ AUDIO_STREAM *sound_PlayStreamWithBuf(PHYSFS_file *fileHandle, float volume, voi
 		return nullptr;
 	}
 
-	stream = (AUDIO_STREAM *)malloc(sizeof(AUDIO_STREAM));
+	// allocate the stream, plus the memory required for the lists of buffers
+	stream = (AUDIO_STREAM *)malloc(sizeof(AUDIO_STREAM) + 2 * sizeof(ALuint) * buffer_count);
 	if (stream == nullptr)
 	{
 		debug(LOG_FATAL, "sound_PlayStream: Out of memory");
 		abort();
 		return nullptr;
 	}
+	memset(stream, 0, sizeof(AUDIO_STREAM));
+	stream->buffers = (ALuint *)(stream + 1);
+	stream->idleBuffers = stream->buffers + buffer_count;
 
 	// Clear error codes
 	alGetError();
@@ -830,6 +1027,7 @@ AUDIO_STREAM *sound_PlayStreamWithBuf(PHYSFS_file *fileHandle, float volume, voi
 	if (stream->decoder == nullptr)
 	{
 		debug(LOG_ERROR, "sound_PlayStream: Failed to open audio file for decoding");
+		alDeleteSources(1, &stream->source);
 		free(stream);
 		return nullptr;
 	}
@@ -843,79 +1041,25 @@ AUDIO_STREAM *sound_PlayStreamWithBuf(PHYSFS_file *fileHandle, float volume, voi
 	// The AL_PITCH value really should be 1.0.
 	alSourcef(stream->source, AL_PITCH, 1.001f);
 
-	// Create some OpenAL buffers to store the decoded data in
-	alGenBuffers(buffer_count, buffers);
-	sound_GetError();
-
-	// Fill some buffers with audio data
-	for (i = 0; i < buffer_count; ++i)
-	{
-		// Decode some audio data
-		soundDataBuffer *soundBuffer = sound_DecodeOggVorbis(stream->decoder, stream->bufferSize);
-
-		// If we actually decoded some data
-		if (soundBuffer && soundBuffer->size > 0)
-		{
-			// Determine PCM data format
-			ALenum format = (soundBuffer->channelCount == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
-
-			// Copy the audio data into one of OpenAL's own buffers
-			alBufferData(buffers[i], format, soundBuffer->data, soundBuffer->size, soundBuffer->frequency);
-			sound_GetError();
-
-			// Clean up our memory
-			free(soundBuffer);
-		}
-		else
-		{
-			// If no data has been decoded we're probably at the end of our
-			// stream. So cleanup the excess stuff here.
-
-			// First remove the data buffer itself
-			free(soundBuffer);
-
-			// Then remove OpenAL's buffers
-			alDeleteBuffers(buffer_count - i, &buffers[i]);
-			sound_GetError();
-
-			break;
-		}
-	}
-
-	// Bail out if we didn't fill any buffers
-	if (i == 0)
-	{
-		debug(LOG_ERROR, "Failed to fill buffers with decoded audio data!");
-
-		// Destroy the decoder
-		sound_DestroyOggVorbisDecoder(stream->decoder);
-
-		// Destroy the OpenAL source
-		alDeleteSources(1, &stream->source);
-
-		// Free allocated memory
-		free(stream);
-
-		return nullptr;
-	}
-
-	// Attach the OpenAL buffers to our OpenAL source
-	// (i = the amount of buffers we worked on in the above for-loop)
-	alSourceQueueBuffers(stream->source, i, buffers);
-	sound_GetError();
-
-	// Start playing the source
-	alSourcePlay(stream->source);
-
+	// Create some OpenAL buffers to store the decoded data in. They are
+	// filled, and playing starts, once the decoder thread has decoded some
+	// data, so we don't stall the main loop here.
+	alGenBuffers(buffer_count, stream->buffers);
 	sound_GetError();
+	memcpy(stream->idleBuffers, stream->buffers, sizeof(ALuint) * buffer_count);
+	stream->bufferCount = buffer_count;
+	stream->idleCount = buffer_count;
 
 	// Set callback info
 	stream->onFinished = onFinished;
 	stream->user_data = user_data;
 
-	// Prepend this stream to the linked list
+	// Prepend this stream to the linked list, and have the decoder thread start on it
+	wzMutexLock(streamMutex);
 	stream->next = active_streams;
 	active_streams = stream;
+	wzMutexUnlock(streamMutex);
+	wzSemaphorePost(streamSemaphore);
 
 	return stream;
 }
@@ -931,6 +1075,12 @@ bool sound_isStreamPlaying(AUDIO_STREAM *stream)
 
 	if (stream)
 	{
+		if (!stream->started)
+		{
+			// Still waiting for the decoder thread to provide the first data
+			return !stream->stopRequested;
+		}
+
 		alGetSourcei(stream->source, AL_SOURCE_STATE, &state);
 		sound_GetError();
 		if (state == AL_PLAYING)
@@ -952,6 +1102,10 @@ void sound_StopStream(AUDIO_STREAM *stream)
 {
 	assert(stream != nullptr);
 
+	wzMutexLock(streamMutex);
+	stream->stopRequested = true;
+	wzMutexUnlock(streamMutex);
+
 	alGetError();	// clear error codes
 	// Tell OpenAL to stop playing on the given source
 	alSourceStop(stream->source);
@@ -966,6 +1120,12 @@ void sound_PauseStream(AUDIO_STREAM *stream)
 {
 	ALint state;
 
+	if (!stream->started)
+	{
+		stream->paused = true;
+		return;
+	}
+
 	// To be sure we won't go mutilating this OpenAL source, check whether
 	// it's playing first.
 	alGetSourcei(stream->source, AL_SOURCE_STATE, &state);
@@ -988,6 +1148,12 @@ void sound_ResumeStream(AUDIO_STREAM *stream)
 {
 	ALint state;
 
+	if (!stream->started)
+	{
+		stream->paused = false;
+		return;
+	}
+
 	// To be sure we won't go mutilating this OpenAL source, check whether
 	// it's paused first.
 	alGetSourcei(stream->source, AL_SOURCE_STATE, &state);
@@ -1039,61 +1205,93 @@ void sound_SetStreamVolume(AUDIO_STREAM *stream, float volume)
 static bool sound_UpdateStream(AUDIO_STREAM *stream)
 {
 	ALint state, buffer_count;
+	unsigned int refilled = 0;
+	bool finished;
 
-	alGetSourcei(stream->source, AL_SOURCE_STATE, &state);
-	sound_GetError();
-
-	if (state != AL_PLAYING && state != AL_PAUSED)
+	if (stream->stopRequested)
 	{
 		return false;
 	}
 
-	// Retrieve the amount of buffers which were processed and need refilling
+	alGetSourcei(stream->source, AL_SOURCE_STATE, &state);
+	sound_GetError();
+
+	// Retrieve the buffers which were processed and need refilling
 	alGetSourcei(stream->source, AL_BUFFERS_PROCESSED, &buffer_count);
 	sound_GetError();
+	if (buffer_count > 0)
+	{
+		alSourceUnqueueBuffers(stream->source, buffer_count, &stream->idleBuffers[stream->idleCount]);
+		sound_GetError();
+		stream->idleCount += buffer_count;
+	}
 
-	// Refill and reattach all buffers
-	for (; buffer_count != 0; --buffer_count)
+	// Refill and reattach as many buffers as the decoder thread has data for
+	wzMutexLock(streamMutex);
+	while (stream->idleCount > 0 && stream->decodedCount > 0)
 	{
-		soundDataBuffer *soundBuffer;
-		ALuint buffer;
+		soundDataBuffer *soundBuffer = stream->decoded[stream->decodedFirst];
+		stream->decodedFirst = (stream->decodedFirst + 1) % STREAM_DECODE_AHEAD;
+		--stream->decodedCount;
+		wzMutexUnlock(streamMutex);
+
+		ALuint buffer = stream->idleBuffers[--stream->idleCount];
+
+		// Determine PCM data format
+		ALenum format = (soundBuffer->channelCount == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
 
-		// Retrieve the buffer to work on
-		alSourceUnqueueBuffers(stream->source, 1, &buffer);
+		// Insert the data into the buffer
+		alBufferData(buffer, format, soundBuffer->data, soundBuffer->size, soundBuffer->frequency);
 		sound_GetError();
 
-		// Decode some data to stuff in our buffer
-		soundBuffer = sound_DecodeOggVorbis(stream->decoder, stream->bufferSize);
+		// Reattach the buffer to the source
+		alSourceQueueBuffers(stream->source, 1, &buffer);
+		sound_GetError();
 
-		// If we actually decoded some data
-		if (soundBuffer && soundBuffer->size > 0)
-		{
-			// Determine PCM data format
-			ALenum format = (soundBuffer->channelCount == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+		// Now remove the data buffer itself
+		free(soundBuffer);
+		++refilled;
 
-			// Insert the data into the buffer
-			alBufferData(buffer, format, soundBuffer->data, soundBuffer->size, soundBuffer->frequency);
-			sound_GetError();
+		wzMutexLock(streamMutex);
+	}
+	finished = stream->decodeFinished && stream->decodedCount == 0;
+	wzMutexUnlock(streamMutex);
 
-			// Reattach the buffer to the source
-			alSourceQueueBuffers(stream->source, 1, &buffer);
-			sound_GetError();
-		}
-		else
-		{
-			// If no data has been decoded we're probably at the end of our
-			// stream. So cleanup this buffer.
+	if (refilled != 0)
+	{
+		wzSemaphorePost(streamSemaphore);  // There's room for more decoded data now.
+	}
 
-			// Then remove OpenAL's buffer
-			alDeleteBuffers(1, &buffer);
+	alGetSourcei(stream->source, AL_BUFFERS_QUEUED, &buffer_count);
+	sound_GetError();
+
+	if (!stream->started)
+	{
+		if (buffer_count > 0 && !stream->paused)
+		{
+			// Start playing the source
+			alSourcePlay(stream->source);
 			sound_GetError();
+			stream->started = true;
 		}
+		// An empty or undecodable file just finishes without playing
+		return buffer_count > 0 || !finished;
+	}
 
-		// Now remove the data buffer itself
-		free(soundBuffer);
+	if (state == AL_PLAYING || state == AL_PAUSED)
+	{
+		return true;
 	}
 
-	return true;
+	// The source stopped by itself. Either we're at the end of the stream,
+	// or it ran out of data before the decoder thread could catch up.
+	if (buffer_count > 0)
+	{
+		alSourcePlay(stream->source);
+		sound_GetError();
+		return true;
+	}
+	return !finished;
 }
 
 /** Destroy the given stream and release its associated resources. This function
@@ -1103,63 +1301,30 @@ static bool sound_UpdateStream(AUDIO_STREAM *stream)
  */
 static void sound_DestroyStream(AUDIO_STREAM *stream)
 {
-	ALint buffer_count;
-	ALuint *buffers;
-	bool freeBuffers = false;
-	ALint error;
-
-	// Stop the OpenAL source from playing
-	alSourceStop(stream->source);
-	error = sound_GetError();
-
-	if (error != AL_NO_ERROR)
+	// Wait for the decoder thread to let go of our decoder
+	wzMutexLock(streamMutex);
+	while (stream->decoding)
 	{
-		// FIXME: We should really handle these errors.
+		wzMutexUnlock(streamMutex);
+		wzYieldCurrentThread();
+		wzMutexLock(streamMutex);
 	}
+	wzMutexUnlock(streamMutex);
 
-	// Retrieve the amount of buffers which were processed
-	alGetSourcei(stream->source, AL_BUFFERS_PROCESSED, &buffer_count);
-	error = sound_GetError();
-	if (error != AL_NO_ERROR)
-	{
-		/* FIXME: We're leaking memory and resources here when bailing
-		 * out. But not doing so could cause stack overflows as a
-		 * result of the below alloca() call (due to buffer_count not
-		 * being properly initialised.
-		 */
-		debug(LOG_SOUND, "alGetSourcei(AL_BUFFERS_PROCESSED) failed; bailing out...");
-		return;
-	}
+	// Stop the OpenAL source from playing, and detach all of its buffers
+	alSourceStop(stream->source);
+	sound_GetError();
+	alSourcei(stream->source, AL_BUFFER, AL_NONE);
+	sound_GetError();
 
-	// Detach all buffers and retrieve their ID numbers
-	if (buffer_count > 0)
-	{
-		if (buffer_count <= (1024 / sizeof(ALuint))) // See CMakeLists.txt for value of -Walloca-larger-than=<N>
-		{
-			buffers = (ALuint *)alloca(buffer_count * sizeof(ALuint));
-		}
-		else
-		{
-			// Too many buffers - don't allocate on the stack!
-			buffers = (ALuint *)malloc(buffer_count * sizeof(ALuint));
-			freeBuffers = true;
-		}
-		alSourceUnqueueBuffers(stream->source, buffer_count, buffers);
-		sound_GetError();
+	// Destroy all of our buffers, whether they were queued or not
+	alDeleteBuffers(stream->bufferCount, stream->buffers);
+	sound_GetError();
 
-		// Destroy all of these buffers
-		alDeleteBuffers(buffer_count, buffers);
-		sound_GetError();
-		if(freeBuffers)
-		{
-			free(buffers);
-		}
-		buffers = nullptr;
-	}
-	else
+	// Free decoded data which never got played
+	for (unsigned int i = 0; i < stream->decodedCount; ++i)
 	{
-		// alGetSourcei(AL_BUFFERS_PROCESSED) returned a count <= 0?
-		debug(LOG_SOUND, "alGetSourcei(AL_BUFFERS_PROCESSED) returned count: %d", buffer_count);
+		free(stream->decoded[(stream->decodedFirst + i) % STREAM_DECODE_AHEAD]);
 	}
 
 	// Destroy the OpenAL source
@@ -1197,6 +1362,7 @@ static void sound_UpdateStreams()
 		if (!sound_UpdateStream(stream))
 		{
 			// First remove our current stream from the linked list
+			wzMutexLock(streamMutex);
 			if (previous)
 			{
 				// Make the previous item skip over the current to the next item
@@ -1208,6 +1374,7 @@ static void sound_UpdateStreams()
 				// next item the list-head.
 				active_streams = next;
 			}
+			wzMutexUnlock(streamMutex);
 
 			// Now actually destroy the current stream
 			sound_DestroyStream(stream);
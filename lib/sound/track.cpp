@@ -27,7 +27,6 @@
 //*
 //
 // defines
-#define MAX_TRACKS	( 600 )
 
 //*
 //
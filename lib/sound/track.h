@@ -38,6 +38,8 @@
 
 #define	AUDIO_VOL_MAX			100L
 
+#define MAX_TRACKS	( 600 )
+
 /* typedefs
  */
 
@@ -37,6 +37,10 @@ public:
 	void highlight(W_CONTEXT *psContext) override;
 	void highlightLost() override;
 	void display(int xOffset, int yOffset) override;
+	bool isAnimated() const override
+	{
+		return true;  // Bar graphs are usually updated by changing their fields directly.
+	}
 
 	void setTip(std::string string) override;
 
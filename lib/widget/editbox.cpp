@@ -597,6 +597,12 @@ void W_EDITBOX::setBoxColours(PIELIGHT first, PIELIGHT second, PIELIGHT backgrou
 	boxColourBackground = background;
 }
 
+/* The cursor blinks while editing */
+bool W_EDITBOX::isAnimated() const
+{
+	return (state & WEDBS_MASK) == WEDBS_INSERT || WIDGET::isAnimated();
+}
+
 void W_EDITBOX::display(int xOffset, int yOffset)
 {
 	int x0 = x() + xOffset;
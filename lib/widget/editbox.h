@@ -54,6 +54,7 @@ public:
 	void focusLost() override;
 	void run(W_CONTEXT *psContext) override;
 	void display(int xOffset, int yOffset) override;
+	bool isAnimated() const override;
 
 	void setState(unsigned state) override;
 	WzString getString() const override;
@@ -145,6 +145,7 @@ void W_CLICKFORM::released(W_CONTEXT *, WIDGET_KEY key)
 void W_CLICKFORM::highlight(W_CONTEXT *psContext)
 {
 	state |= WBUT_HIGHLIGHT;
+	dirty = true;
 
 	// If there is a tip string start the tool tip.
 	if (!pTip.empty())
@@ -111,6 +111,10 @@ WzString W_LABEL::getString() const
 
 void W_LABEL::setString(WzString string)
 {
+	if (aText == string)
+	{
+		return;  // Nothing to do.
+	}
 	aText = string;
 	dirty = true;
 }
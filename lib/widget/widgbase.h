@@ -47,6 +47,7 @@ class W_LABEL;
 class W_SLIDER;
 class StateButton;
 class ListWidget;
+class ScreenLayer;
 
 /* The display function prototype */
 typedef void (*WIDGET_DISPLAY)(WIDGET *psWidget, UDWORD xOffset, UDWORD yOffset);
@@ -144,9 +145,25 @@ public:
 
 	virtual void screenSizeDidChange(int oldWidth, int oldHeight, int newWidth, int newHeight); // used to handle screen resizing
 
+	/// Whether the widget may look different from one frame to the next without being marked dirty. Such widgets
+	/// (and their children) are not cached in the layer of a cached parent, but drawn on top of it every frame.
+	virtual bool isAnimated() const
+	{
+		return displayFunction != nullptr;
+	}
+
 	void show(bool doShow = true)
 	{
-		style = (style & ~WIDG_HIDDEN) | (!doShow * WIDG_HIDDEN);
+		UDWORD newStyle = (style & ~WIDG_HIDDEN) | (!doShow * WIDG_HIDDEN);
+		if (newStyle != style)
+		{
+			style = newStyle;
+			dirty = true;
+			if (parentWidget != nullptr)
+			{
+				parentWidget->dirty = true;
+			}
+		}
 	}
 	void hide()
 	{
@@ -214,6 +231,10 @@ public:
 
 	void setCustomHitTest(const WIDGET_HITTEST_FUNC& newCustomHitTestFunc);
 
+	/// Keep a copy of what this widget and its children look like, and only draw them again if one of them is
+	/// dirty. Children must not draw outside of this widget.
+	void setLayerCached(bool cached);
+
 	UDWORD                  id;                     ///< The user set ID number for the widget. This is returned when e.g. a button is pressed.
 	WIDGET_TYPE             type;                   ///< The widget type
 	UDWORD                  style;                  ///< The style of the widget
@@ -234,12 +255,24 @@ public:
 	void processCallbacksRecursive(W_CONTEXT *psContext);
 	void displayRecursive(int xOffset, int yOffset);  ///< Display this widget, and all visible children.
 private:
+	enum DisplayPass
+	{
+		DISPLAY_ALL,       ///< Display everything.
+		DISPLAY_STATIC,    ///< Display everything except animated widgets, into the layer of a cached parent.
+		DISPLAY_ANIMATED,  ///< Display only the animated widgets, on top of the layer of a cached parent.
+	};
+	void displayTree(int xOffset, int yOffset, DisplayPass pass);
+	void displayLayer(int xOffset, int yOffset);
+	bool layerDirty();
 
 	WIDGET                 *parentWidget;           ///< Parent widget.
 	std::vector<WIDGET *>   childWidgets;           ///< Child widgets. Will be deleted if we are deleted.
 
 	WzRect                  dim;
 
+	ScreenLayer            *layer;                  ///< Cached drawing of this widget and its children, if enabled.
+	bool                    layerAnimated;          ///< Whether the widget was animated when the layer of a cached parent was drawn.
+
 	WIDGET(WIDGET const &) = delete;
 	WIDGET &operator =(WIDGET const &) = delete;
 
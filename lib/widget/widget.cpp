@@ -131,6 +131,8 @@ WIDGET::WIDGET(W_INIT const *init, WIDGET_TYPE type)
 	, customHitTest(init->customHitTest)
 	, parentWidget(nullptr)
 	, dim(init->x, init->y, init->width, init->height)
+	, layer(nullptr)
+	, layerAnimated(false)
 	, dirty(true)
 {
 	/* Initialize and set the pUserData if necessary */
@@ -158,6 +160,8 @@ WIDGET::WIDGET(WIDGET *parent, WIDGET_TYPE type)
 	, customHitTest(nullptr)
 	, parentWidget(nullptr)
 	, dim(0, 0, 1, 1)
+	, layer(nullptr)
+	, layerAnimated(false)
 	, dirty(true)
 {
 	parent->attach(this);
@@ -182,6 +186,7 @@ WIDGET::~WIDGET()
 		childWidgets[n]->parentWidget = nullptr;  // Detach in advance, slightly faster than detach(), and doesn't change our list.
 		delete childWidgets[n];
 	}
+	delete layer;
 }
 
 void WIDGET::deleteLater()
@@ -253,6 +258,7 @@ void WIDGET::attach(WIDGET *widget)
 	widget->parentWidget = this;
 	widget->setScreenPointer(screenPointer);
 	childWidgets.push_back(widget);
+	dirty = true;
 }
 
 void WIDGET::detach(WIDGET *widget)
@@ -262,10 +268,24 @@ void WIDGET::detach(WIDGET *widget)
 	widget->parentWidget = nullptr;
 	widget->setScreenPointer(nullptr);
 	childWidgets.erase(std::find(childWidgets.begin(), childWidgets.end(), widget));
+	dirty = true;
 
 	widgetLost(widget);
 }
 
+void WIDGET::setLayerCached(bool cached)
+{
+	if (!cached)
+	{
+		delete layer;
+		layer = nullptr;
+	}
+	else if (layer == nullptr)
+	{
+		layer = new ScreenLayer;
+	}
+}
+
 void WIDGET::setScreenPointer(W_SCREEN *screen)
 {
 	if (screenPointer == screen)
@@ -880,7 +900,39 @@ void W_SCREEN::setReturn(WIDGET *psWidget)
 
 void WIDGET::displayRecursive(int xOffset, int yOffset)
 {
-	if (debugBoundingBoxesOnly)
+	if (layer != nullptr && !debugBoundingBoxesOnly && !isAnimated())
+	{
+		displayLayer(xOffset, yOffset);
+		return;
+	}
+	displayTree(xOffset, yOffset, DISPLAY_ALL);
+}
+
+void WIDGET::displayTree(int xOffset, int yOffset, DisplayPass pass)
+{
+	if (pass != DISPLAY_ALL && isAnimated())
+	{
+		// Animated widgets are left out of the layer, and drawn with their children on top of it.
+		layerAnimated = true;
+		if (pass == DISPLAY_ANIMATED)
+		{
+			displayTree(xOffset, yOffset, DISPLAY_ALL);
+		}
+		return;
+	}
+
+	if (pass == DISPLAY_STATIC)
+	{
+		// Cleared before drawing, so that display() can ask to be drawn again next frame.
+		dirty = false;
+		layerAnimated = false;
+	}
+
+	if (pass == DISPLAY_ANIMATED)
+	{
+		// Already in the layer.
+	}
+	else if (debugBoundingBoxesOnly)
 	{
 		// Display bounding boxes.
 		PIELIGHT col;
@@ -928,8 +980,66 @@ void WIDGET::displayRecursive(int xOffset, int yOffset)
 			continue;
 		}
 
-		psCurr->displayRecursive(xOffset, yOffset);
+		if (pass == DISPLAY_ALL)
+		{
+			psCurr->displayRecursive(xOffset, yOffset);
+		}
+		else
+		{
+			psCurr->displayTree(xOffset, yOffset, pass);
+		}
+	}
+}
+
+/** Whether anything in the layer of this widget has to be drawn again. */
+bool WIDGET::layerDirty()
+{
+	if (isAnimated() != layerAnimated)
+	{
+		return true;
+	}
+	if (layerAnimated)
+	{
+		return false;  // Not in the layer.
+	}
+	if (dirty)
+	{
+		return true;
+	}
+	if (type == WIDG_FORM && ((W_FORM *)this)->disableChildren)
+	{
+		return false;
+	}
+	for (WIDGET *psCurr : childWidgets)
+	{
+		if (psCurr->visible() && psCurr->layerDirty())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Display this widget and its children from the layer, drawing the layer again first if needed. */
+void WIDGET::displayLayer(int xOffset, int yOffset)
+{
+	const int layerX = xOffset + x();
+	const int layerY = yOffset + y();
+
+	if (!layer->matches(layerX, layerY, width(), height()) || layerDirty())
+	{
+		if (!layer->begin(layerX, layerY, width(), height()))
+		{
+			// Not supported, so don't try again.
+			setLayerCached(false);
+			displayTree(xOffset, yOffset, DISPLAY_ALL);
+			return;
+		}
+		displayTree(xOffset, yOffset, DISPLAY_STATIC);
+		layer->end();
 	}
+	layer->draw();
+	displayTree(xOffset, yOffset, DISPLAY_ANIMATED);
 }
 
 /* Display the screen's widgets in their current state
@@ -25,6 +25,7 @@
  */
 
 #include "lib/framework/frame.h"
+#include "lib/framework/jobsystem.h"
 
 #include "action.h"
 #include "cmddroid.h"
@@ -37,6 +38,8 @@
 #include "objmem.h"
 #include "order.h"
 
+#include <unordered_map>
+
 /* Weights used for target selection code,
  * target distance is used as 'common currency'
  */
@@ -160,6 +163,7 @@ bool aiInitialise()
 /* Shutdown the AI system */
 bool aiShutdown()
 {
+	aiDiscardTargetSearches();
 	return true;
 }
 
@@ -524,6 +528,179 @@ static SDWORD targetAttackWeight(BASE_OBJECT *psTarget, BASE_OBJECT *psAttacker,
 }
 
 
+/// Grid query done in advance by aiPrepareTargetSearches(), only valid for the same droid, position and range.
+struct PreparedTargetSearch
+{
+	DROID *psDroid;
+	uint32_t id;
+	Vector2i pos;
+	int range;
+	GridList objects;  ///< Not yet filtered by distance, see gridQueryConcurrent().
+};
+
+static std::vector<PreparedTargetSearch> preparedTargetSearches;
+static unsigned numPreparedTargetSearches = 0;
+static std::unordered_map<DROID const *, unsigned> preparedTargetSearchIndex;
+
+static bool aiDroidMaySearchTargets(DROID *psDroid)
+{
+	return !isDead(psDroid) && psDroid->numWeaps > 0 && psDroid->asWeaps[0].nStat != 0 && !vtolEmpty(psDroid);
+}
+
+/// Decides whether the droid looks for a new target when idle, and whether it may switch away from the one it has.
+static void aiDroidTargetIntent(DROID *psDroid, bool &lookForTarget, bool &updateTarget)
+{
+	lookForTarget = false;
+	updateTarget = false;
+
+	// look for a target if doing nothing
+	if (orderState(psDroid, DORDER_NONE) ||
+	    orderState(psDroid, DORDER_GUARD) ||
+	    orderState(psDroid, DORDER_HOLD))
+	{
+		lookForTarget = true;
+	}
+	// but do not choose another target if doing anything while guarding
+	// exception for sensors, to allow re-targetting when target is doomed
+	if (orderState(psDroid, DORDER_GUARD) && psDroid->action != DACTION_NONE && psDroid->droidType != DROID_SENSOR)
+	{
+		lookForTarget = false;
+	}
+	// don't look for a target if sulking
+	if (psDroid->action == DACTION_SULK)
+	{
+		lookForTarget = false;
+	}
+
+	/* Only try to update target if already have some target */
+	if (psDroid->action == DACTION_ATTACK ||
+	    psDroid->action == DACTION_MOVEFIRE ||
+	    psDroid->action == DACTION_MOVETOATTACK ||
+	    psDroid->action == DACTION_ROTATETOATTACK)
+	{
+		updateTarget = true;
+	}
+	if ((orderState(psDroid, DORDER_OBSERVE) || orderState(psDroid, DORDER_ATTACKTARGET)) &&
+	    psDroid->order.psObj && psDroid->order.psObj->died)
+	{
+		lookForTarget = true;
+		updateTarget = false;
+	}
+
+	/* Don't update target if we are sent to attack and reached attack destination (attacking our target) */
+	if (orderState(psDroid, DORDER_ATTACK) && psDroid->psActionTarget[0] == psDroid->order.psObj)
+	{
+		updateTarget = false;
+	}
+
+	// don't look for a target if there are any queued orders
+	if (psDroid->listSize > 0)
+	{
+		lookForTarget = false;
+		updateTarget = false;
+	}
+
+	// don't allow units to start attacking if they will switch to guarding the commander
+	if (hasCommander(psDroid))
+	{
+		lookForTarget = false;
+		updateTarget = false;
+	}
+
+	if (bMultiPlayer && isVtolDroid(psDroid) && isHumanPlayer(psDroid->player))
+	{
+		lookForTarget = false;
+		updateTarget = false;
+	}
+
+	// CB and VTOL CB droids can't autotarget.
+	if (psDroid->droidType == DROID_SENSOR && !standardSensorDroid(psDroid))
+	{
+		lookForTarget = false;
+		updateTarget = false;
+	}
+
+	// do not attack if the attack level is wrong
+	if (secondaryGetState(psDroid, DSO_ATTACK_LEVEL) != DSS_ALEV_ALWAYS)
+	{
+		lookForTarget = false;
+	}
+}
+
+/// True on the ticks where an attacking droid looks for a better target than the one it has.
+static bool aiDroidTargetUpdateDue(DROID *psDroid)
+{
+	return psDroid->numWeaps > 0 && !hasCommander(psDroid)
+	       && (psDroid->id + gameTime) / TARGET_UPD_SKIP_FRAMES != (psDroid->id + gameTime - deltaGameTime) / TARGET_UPD_SKIP_FRAMES;
+}
+
+static int aiTargetSearchRange(DROID *psDroid, int weapon_slot, int extraRange)
+{
+	// Range was previously 9*TILE_UNITS. Increasing this doesn't seem to help much, though. Not sure why.
+	return std::min(aiDroidRange(psDroid, weapon_slot) + extraRange, objSensorRange(psDroid) + 6 * TILE_UNITS);
+}
+
+void aiPrepareTargetSearches()
+{
+	// Decide which searches to make in a fixed order, so only the grid queries themselves run in parallel.
+	aiDiscardTargetSearches();
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		for (DROID *psDroid = apsDroidLists[player]; psDroid != nullptr; psDroid = psDroid->psNext)
+		{
+			if (!aiDroidMaySearchTargets(psDroid) || psDroid->sMove.Status != MOVEINACTIVE)
+			{
+				continue;  // Moving droids will be somewhere else by the time they search.
+			}
+			bool lookForTarget, updateTarget;
+			aiDroidTargetIntent(psDroid, lookForTarget, updateTarget);
+			bool searchesNow = lookForTarget ? !updateTarget : updateTarget && aiDroidTargetUpdateDue(psDroid);  // Same as in aiUpdateDroid().
+			if (!searchesNow)
+			{
+				continue;
+			}
+			if (numPreparedTargetSearches == preparedTargetSearches.size())
+			{
+				preparedTargetSearches.emplace_back();  // Keep old entries, to reuse their allocations.
+			}
+			PreparedTargetSearch &search = preparedTargetSearches[numPreparedTargetSearches];
+			search.psDroid = psDroid;
+			search.id = psDroid->id;
+			search.pos = psDroid->pos.xy();
+			search.range = aiTargetSearchRange(psDroid, 0, 0);
+			preparedTargetSearchIndex[psDroid] = numPreparedTargetSearches;
+			++numPreparedTargetSearches;
+		}
+	}
+
+	jobParallelFor(numPreparedTargetSearches, [](unsigned n) {
+		PreparedTargetSearch &search = preparedTargetSearches[n];
+		gridQueryConcurrent(search.objects, search.pos.x, search.pos.y, search.range);
+	});
+}
+
+void aiDiscardTargetSearches()
+{
+	numPreparedTargetSearches = 0;
+	preparedTargetSearchIndex.clear();
+}
+
+/// Returns the prepared gridQueryConcurrent(psDroid->pos.x, psDroid->pos.y, range), or nullptr if there isn't one.
+static GridList const *aiFindPreparedTargetSearch(DROID const *psDroid, int range)
+{
+	auto it = preparedTargetSearchIndex.find(psDroid);
+	if (it == preparedTargetSearchIndex.end())
+	{
+		return nullptr;
+	}
+	PreparedTargetSearch const &search = preparedTargetSearches[it->second];
+	if (search.id != psDroid->id || search.pos != psDroid->pos.xy() || search.range != range)
+	{
+		return nullptr;  // Droid moved since, or wants a different range, so need a fresh query.
+	}
+	return &search.objects;
+}
+
 // Find the best nearest target for a droid.
 // If extraRange is higher than zero, then this is the range it accepts for movement to target.
 // Returns integer representing target priority, -1 if failed
@@ -562,11 +739,20 @@ int aiBestNearestTarget(DROID *psDroid, BASE_OBJECT **ppsObj, int weapon_slot, i
 
 	electronic = electronicDroid(psDroid);
 
-	// Range was previously 9*TILE_UNITS. Increasing this doesn't seem to help much, though. Not sure why.
-	int droidRange = std::min(aiDroidRange(psDroid, weapon_slot) + extraRange, objSensorRange(psDroid) + 6 * TILE_UNITS);
+	int droidRange = aiTargetSearchRange(psDroid, weapon_slot, extraRange);
 
+	// The grid doesn't change until the next gridReset(), but the objects in it may have moved since the search was
+	// prepared, so check their distances now, like gridStartIterate() does, to get the same objects in the same order.
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, droidRange);
+	GridList const *prepared = aiFindPreparedTargetSearch(psDroid, droidRange);
+	if (prepared != nullptr)
+	{
+		gridFilterRadius(gridList, *prepared, psDroid->pos.x, psDroid->pos.y, droidRange);
+	}
+	else
+	{
+		gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, droidRange);
+	}
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *friendlyObj = nullptr;
@@ -1081,85 +1267,10 @@ void aiUpdateDroid(DROID *psDroid)
 		return;
 	}
 
-	lookForTarget = false;
-	updateTarget = false;
-
-	// look for a target if doing nothing
-	if (orderState(psDroid, DORDER_NONE) ||
-	    orderState(psDroid, DORDER_GUARD) ||
-	    orderState(psDroid, DORDER_HOLD))
-	{
-		lookForTarget = true;
-	}
-	// but do not choose another target if doing anything while guarding
-	// exception for sensors, to allow re-targetting when target is doomed
-	if (orderState(psDroid, DORDER_GUARD) && psDroid->action != DACTION_NONE && psDroid->droidType != DROID_SENSOR)
-	{
-		lookForTarget = false;
-	}
-	// don't look for a target if sulking
-	if (psDroid->action == DACTION_SULK)
-	{
-		lookForTarget = false;
-	}
-
-	/* Only try to update target if already have some target */
-	if (psDroid->action == DACTION_ATTACK ||
-	    psDroid->action == DACTION_MOVEFIRE ||
-	    psDroid->action == DACTION_MOVETOATTACK ||
-	    psDroid->action == DACTION_ROTATETOATTACK)
-	{
-		updateTarget = true;
-	}
-	if ((orderState(psDroid, DORDER_OBSERVE) || orderState(psDroid, DORDER_ATTACKTARGET)) &&
-	    psDroid->order.psObj && psDroid->order.psObj->died)
-	{
-		lookForTarget = true;
-		updateTarget = false;
-	}
-
-	/* Don't update target if we are sent to attack and reached attack destination (attacking our target) */
-	if (orderState(psDroid, DORDER_ATTACK) && psDroid->psActionTarget[0] == psDroid->order.psObj)
-	{
-		updateTarget = false;
-	}
-
-	// don't look for a target if there are any queued orders
-	if (psDroid->listSize > 0)
-	{
-		lookForTarget = false;
-		updateTarget = false;
-	}
-
-	// don't allow units to start attacking if they will switch to guarding the commander
-	if (hasCommander(psDroid))
-	{
-		lookForTarget = false;
-		updateTarget = false;
-	}
-
-	if (bMultiPlayer && isVtolDroid(psDroid) && isHumanPlayer(psDroid->player))
-	{
-		lookForTarget = false;
-		updateTarget = false;
-	}
-
-	// CB and VTOL CB droids can't autotarget.
-	if (psDroid->droidType == DROID_SENSOR && !standardSensorDroid(psDroid))
-	{
-		lookForTarget = false;
-		updateTarget = false;
-	}
-
-	// do not attack if the attack level is wrong
-	if (secondaryGetState(psDroid, DSO_ATTACK_LEVEL) != DSS_ALEV_ALWAYS)
-	{
-		lookForTarget = false;
-	}
+	aiDroidTargetIntent(psDroid, lookForTarget, updateTarget);
 
 	/* For commanders and non-assigned non-commanders: look for a better target once in a while */
-	if (!lookForTarget && updateTarget && psDroid->numWeaps > 0 && !hasCommander(psDroid)
-	    && (psDroid->id + gameTime) / TARGET_UPD_SKIP_FRAMES != (psDroid->id + gameTime - deltaGameTime) / TARGET_UPD_SKIP_FRAMES)
+	if (!lookForTarget && updateTarget && aiDroidTargetUpdateDue(psDroid))
 	{
 		for (unsigned i = 0; i < psDroid->numWeaps; ++i)
 		{
@@ -63,6 +63,12 @@ bool aiShutdown();
 /* Do the AI for a droid */
 void aiUpdateDroid(DROID *psDroid);
 
+/* Find the objects near each droid which might look for a target this update, using all threads. Call after gridReset(). */
+void aiPrepareTargetSearches();
+
+/* Forget the prepared searches, once the objects they were made for have been updated. */
+void aiDiscardTargetSearches();
+
 // Find the nearest best target for a droid
 // returns integer representing quality of choice, -1 if failed
 int aiBestNearestTarget(DROID *psDroid, BASE_OBJECT **ppsObj, int weapon_slot, int extraRange = 0);
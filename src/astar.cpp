@@ -127,10 +127,20 @@ struct PathBlockingMap
 	}
 
 	PathBlockingType type;
-	std::vector<bool> map;
-	std::vector<bool> dangerMap;	// using threatBits
+	std::vector<uint64_t> map;          ///< One bit per tile, set if blocking.
+	std::vector<uint64_t> dangerMap;    ///< One bit per tile, using threatBits. Empty if not needed.
 };
 
+static inline bool fpathTestBit(std::vector<uint64_t> const &bits, unsigned i)
+{
+	return (bits[i / 64] >> (i % 64)) & 1;
+}
+
+static inline void fpathFlipBit(std::vector<uint64_t> &bits, unsigned i)
+{
+	bits[i / 64] ^= uint64_t(1) << (i % 64);
+}
+
 struct PathNonblockingArea
 {
 	PathNonblockingArea() {}
@@ -165,11 +175,11 @@ struct PathfindContext
 			return false;  // The path is actually blocked here by a structure, but ignore it since it's where we want to go (or where we came from).
 		}
 		// Not sure whether the out-of-bounds check is needed, can only happen if pathfinding is started on a blocking tile (or off the map).
-		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map[x + y * mapWidth];
+		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || fpathTestBit(blockingMap->map, x + y * mapWidth);
 	}
 	bool isDangerous(int x, int y) const
 	{
-		return !blockingMap->dangerMap.empty() && blockingMap->dangerMap[x + y * mapWidth];
+		return !blockingMap->dangerMap.empty() && fpathTestBit(blockingMap->dangerMap, x + y * mapWidth);
 	}
 	bool matches(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_) const
 	{
@@ -213,10 +223,25 @@ struct PathfindContext
 /// Last recently used list of contexts.
 static std::list<PathfindContext> fpathContexts;
 
-/// Lists of blocking maps from current tick.
-static std::vector<std::shared_ptr<PathBlockingMap>> fpathBlockingMaps;
-/// Game time for all blocking maps in fpathBlockingMaps.
-static uint32_t fpathCurrentGameTime;
+/// Blocking maps for one class of equivalent blocking types, kept between ticks and patched where the map changed.
+struct PathBlockingClass
+{
+	PathBlockingType type;              ///< Type the maps are made for, type.gameTime is when they were last brought up to date.
+	int width, height;
+	int scrollMinX, scrollMinY, scrollMaxX, scrollMaxY;
+	bool hasDanger;
+	std::vector<uint64_t> map;          ///< Same as PathBlockingMap::map.
+	std::vector<uint64_t> dangerMap;    ///< Same as PathBlockingMap::dangerMap.
+	std::vector<uint8_t> auxShadow;     ///< Copy of the aux map the maps were computed from.
+	std::vector<uint8_t> blockShadow;   ///< Copy of the block map the maps were computed from.
+	uint32_t checksumMap, checksumDangerMap;
+	std::shared_ptr<PathBlockingMap> snapshot;  ///< Read-only copy for the pathfinding thread, made once per tick.
+};
+
+/// All blocking classes used so far in this game.
+static std::vector<PathBlockingClass> fpathBlockingClasses;
+/// Checksum weight of each tile, blocking map tiles first, then danger map tiles.
+static std::vector<uint32_t> fpathChecksumFactors;
 
 // Convert a direction into an offset
 // dir 0 => x = 0, y = -1
@@ -235,7 +260,7 @@ static const Vector2i aDirOffset[] =
 void fpathHardTableReset()
 {
 	fpathContexts.clear();
-	fpathBlockingMaps.clear();
+	fpathBlockingClasses.clear();
 }
 
 /** Get the nearest entry in the open list
@@ -598,15 +623,98 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	return retval;
 }
 
-void fpathSetBlockingMap(PATHJOB *psJob)
+/// Recalculates tile i of the class' maps, updating the checksums of any bits which change.
+static void fpathUpdateBlockingTile(PathBlockingClass &blockClass, unsigned i)
+{
+	PathBlockingType const &type = blockClass.type;
+	unsigned numTiles = blockClass.width * blockClass.height;
+	int x = i % blockClass.width, y = i / blockClass.width;
+
+	if (fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType) != fpathTestBit(blockClass.map, i))
+	{
+		fpathFlipBit(blockClass.map, i);
+		blockClass.checksumMap ^= fpathChecksumFactors[i];
+	}
+	if (blockClass.hasDanger && ((auxTile(x, y, type.owner) & AUXBITS_THREAT) != 0) != fpathTestBit(blockClass.dangerMap, i))
+	{
+		fpathFlipBit(blockClass.dangerMap, i);
+		blockClass.checksumDangerMap ^= fpathChecksumFactors[numTiles + i];
+	}
+}
+
+/// Brings the class' maps up to date with the map, only looking at tiles where the inputs changed since the last update.
+static void fpathUpdateBlockingClass(PathBlockingClass &blockClass, PathBlockingType const &type)
 {
-	if (fpathCurrentGameTime != gameTime)
+	unsigned numTiles = mapWidth * mapHeight;
+	unsigned numWords = (numTiles + 63) / 64;
+	bool hasDanger = !isHumanPlayer(type.owner) && type.moveType == FMT_MOVE;
+	uint8_t const *aux = psAuxMap[type.owner];
+	uint8_t const *block = psBlockMap[MAX(0, type.owner - MAX_PLAYERS)];  // Same slot as used by fpathBaseBlockingTile.
+
+	if (fpathChecksumFactors.size() != 2 * numTiles)
 	{
-		// New tick, remove maps which are no longer needed.
-		fpathCurrentGameTime = gameTime;
-		fpathBlockingMaps.clear();
+		fpathChecksumFactors.resize(2 * numTiles);
+		uint32_t factor = 0;
+		for (uint32_t &f : fpathChecksumFactors)
+		{
+			f = factor = 3 * factor + 1;
+		}
 	}
 
+	bool rebuild = blockClass.map.size() != numWords || blockClass.width != mapWidth || blockClass.height != mapHeight
+	               || blockClass.scrollMinX != scrollMinX || blockClass.scrollMinY != scrollMinY || blockClass.scrollMaxX != scrollMaxX || blockClass.scrollMaxY != scrollMaxY
+	               || blockClass.hasDanger != hasDanger
+	               || prop2bits(blockClass.type.propulsion) != prop2bits(type.propulsion) || blockClass.type.owner != type.owner || blockClass.type.moveType != type.moveType;
+	blockClass.type = type;
+
+	if (rebuild)
+	{
+		blockClass.width = mapWidth;
+		blockClass.height = mapHeight;
+		blockClass.scrollMinX = scrollMinX;
+		blockClass.scrollMinY = scrollMinY;
+		blockClass.scrollMaxX = scrollMaxX;
+		blockClass.scrollMaxY = scrollMaxY;
+		blockClass.hasDanger = hasDanger;
+		blockClass.map.assign(numWords, 0);
+		blockClass.dangerMap.assign(hasDanger ? numWords : 0, 0);
+		blockClass.checksumMap = 0;
+		blockClass.checksumDangerMap = 0;
+		blockClass.auxShadow.assign(aux, aux + numTiles);
+		blockClass.blockShadow.assign(block, block + numTiles);
+		for (unsigned i = 0; i < numTiles; ++i)
+		{
+			fpathUpdateBlockingTile(blockClass, i);
+		}
+		return;
+	}
+
+	// Compare the inputs 8 tiles at a time, and only recalculate the tiles in words which changed.
+	uint8_t *auxShadow = &blockClass.auxShadow[0];
+	uint8_t *blockShadow = &blockClass.blockShadow[0];
+	for (unsigned base = 0; base < numTiles; base += 8)
+	{
+		unsigned count = std::min(8u, numTiles - base);
+		uint64_t auxOld = 0, auxNew = 0, blockOld = 0, blockNew = 0;
+		memcpy(&auxOld, auxShadow + base, count);
+		memcpy(&auxNew, aux + base, count);
+		memcpy(&blockOld, blockShadow + base, count);
+		memcpy(&blockNew, block + base, count);
+		if (auxOld == auxNew && blockOld == blockNew)
+		{
+			continue;
+		}
+		memcpy(auxShadow + base, aux + base, count);
+		memcpy(blockShadow + base, block + base, count);
+		for (unsigned i = base; i < base + count; ++i)
+		{
+			fpathUpdateBlockingTile(blockClass, i);
+		}
+	}
+}
+
+void fpathSetBlockingMap(PATHJOB *psJob)
+{
 	// Figure out which map we are looking for.
 	PathBlockingType type;
 	type.gameTime = gameTime;
@@ -614,46 +722,38 @@ void fpathSetBlockingMap(PATHJOB *psJob)
 	type.owner = psJob->owner;
 	type.moveType = psJob->moveType;
 
-	// Find the map.
-	auto i = std::find_if(fpathBlockingMaps.begin(), fpathBlockingMaps.end(), [&](std::shared_ptr<PathBlockingMap> const &ptr) {
-		return *ptr == type;
+	// Find the class of equivalent maps.
+	auto i = std::find_if(fpathBlockingClasses.begin(), fpathBlockingClasses.end(), [&](PathBlockingClass const &blockClass) {
+		return fpathIsEquivalentBlocking(blockClass.type.propulsion, blockClass.type.owner, blockClass.type.moveType,
+		                                 type.propulsion,            type.owner,            type.moveType);
 	});
-	if (i == fpathBlockingMaps.end())
+	if (i == fpathBlockingClasses.end())
 	{
-		// Didn't find the map, so i does not point to a map.
-		PathBlockingMap *blockMap = new PathBlockingMap();
-		fpathBlockingMaps.emplace_back(blockMap);
+		fpathBlockingClasses.emplace_back();
+		i = fpathBlockingClasses.end() - 1;
+		i->type = type;
+		i->width = i->height = 0;  // Forces a full rebuild.
+	}
+	PathBlockingClass &blockClass = *i;
+
+	if (blockClass.snapshot == nullptr || blockClass.snapshot->type.gameTime != gameTime)
+	{
+		// First use this tick, so bring the maps up to date. The first type asking in a tick decides the owner, as equivalent types may still differ in that.
+		fpathUpdateBlockingClass(blockClass, type);
 
-		// blockMap now points to an empty map with no data. Fill the map.
+		// The pathfinding thread may still be using the previous snapshot, so make a new one.
+		PathBlockingMap *blockMap = new PathBlockingMap();
 		blockMap->type = type;
-		std::vector<bool> &map = blockMap->map;
-		map.resize(mapWidth * mapHeight);
-		uint32_t checksumMap = 0, checksumDangerMap = 0, factor = 0;
-		for (int y = 0; y < mapHeight; ++y)
-			for (int x = 0; x < mapWidth; ++x)
-			{
-				map[x + y * mapWidth] = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
-				checksumMap ^= map[x + y * mapWidth] * (factor = 3 * factor + 1);
-			}
-		if (!isHumanPlayer(type.owner) && type.moveType == FMT_MOVE)
-		{
-			std::vector<bool> &dangerMap = blockMap->dangerMap;
-			dangerMap.resize(mapWidth * mapHeight);
-			for (int y = 0; y < mapHeight; ++y)
-				for (int x = 0; x < mapWidth; ++x)
-				{
-					dangerMap[x + y * mapWidth] = auxTile(x, y, type.owner) & AUXBITS_THREAT;
-					checksumDangerMap ^= dangerMap[x + y * mapWidth] * (factor = 3 * factor + 1);
-				}
-		}
-		syncDebug("blockingMap(%d,%d,%d,%d) = %08X %08X", gameTime, psJob->propulsion, psJob->owner, psJob->moveType, checksumMap, checksumDangerMap);
+		blockMap->map = blockClass.map;
+		blockMap->dangerMap = blockClass.dangerMap;
+		blockClass.snapshot.reset(blockMap);
 
-		psJob->blockingMap = fpathBlockingMaps.back();
+		syncDebug("blockingMap(%d,%d,%d,%d) = %08X %08X", gameTime, psJob->propulsion, psJob->owner, psJob->moveType, blockClass.checksumMap, blockClass.checksumDangerMap);
 	}
 	else
 	{
 		syncDebug("blockingMap(%d,%d,%d,%d) = cached", gameTime, psJob->propulsion, psJob->owner, psJob->moveType);
-
-		psJob->blockingMap = *i;
 	}
+
+	psJob->blockingMap = blockClass.snapshot;
 }
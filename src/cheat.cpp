@@ -79,6 +79,8 @@ static CHEAT_ENTRY cheatCodes[] =
 	{"showfps", kf_ToggleFPS},	//displays your average FPS
 	{"showsamples", kf_ToggleSamples}, //displays the # of Sound samples in Queue & List
 	{"showorders", kf_ToggleOrders}, //displays unit order/action state.
+	{"showtickprofile", kf_ToggleTickProfile}, //displays CPU time per subsystem of the game update.
+	{"shownetlatency", kf_ToggleNetLatency}, //displays game message latency, round trip times and jitter.
 	{"pause", kf_TogglePauseMode}, // Pause the game.
 	{"power info", kf_PowerInfo},
 	{"reload me", kf_Reload},	// reload selected weapons immediately
@@ -39,6 +39,8 @@
 #include "main.h"
 #include "modding.h"
 #include "multiplay.h"
+#include "tickprofiler.h"
+#include "statehash.h"
 #include "version.h"
 #include "warzoneconfig.h"
 #include "wrappers.h"
@@ -79,6 +81,8 @@ typedef struct _poptContext
 static bool wz_autogame = false;
 static std::string wz_saveandquit;
 static std::string wz_test;
+static std::string wz_replay;
+static unsigned wz_replay_speed = 1;
 
 static void poptPrintHelp(poptContext ctx, FILE *output)
 {
@@ -247,6 +251,10 @@ typedef enum
 	CLI_AUTOGAME,
 	CLI_SAVEANDQUIT,
 	CLI_SKIRMISH,
+	CLI_PROFILETICKS,
+	CLI_REPLAY,
+	CLI_REPLAYSPEED,
+	CLI_STATEHASHES,
 } CLI_OPTIONS;
 
 static const struct poptOption *getOptionsTable()
@@ -282,6 +290,10 @@ static const struct poptOption *getOptionsTable()
 		{ "autogame", POPT_ARG_NONE, CLI_AUTOGAME,   N_("Run games automatically for testing"), nullptr },
 		{ "saveandquit", POPT_ARG_STRING, CLI_SAVEANDQUIT, N_("Immediately save game and quit"), N_("save name") },
 		{ "skirmish", POPT_ARG_STRING, CLI_SKIRMISH,   N_("Start skirmish game with given settings file"), N_("test") },
+		{ "profile-ticks", POPT_ARG_STRING, CLI_PROFILETICKS, N_("Write the CPU time of each game update to a trace file"), N_("file") },
+		{ "replay", POPT_ARG_STRING, CLI_REPLAY,     N_("Play back a recorded multiplayer game"), N_("file") },
+		{ "replay-speed", POPT_ARG_STRING, CLI_REPLAYSPEED, N_("Run replay playback faster by the given factor"), N_("factor") },
+		{ "state-hashes", POPT_ARG_STRING, CLI_STATEHASHES, N_("Write hashes of the game state after each game update to a file"), N_("file") },
 		// Terminating entry
 		{ nullptr, 0, 0,              nullptr,                                    nullptr },
 	};
@@ -648,6 +660,42 @@ bool ParseCommandLine(int argc, const char * const *argv)
 			}
 			wz_test = token;
 			break;
+
+		case CLI_PROFILETICKS:
+			token = poptGetOptArg(poptCon);
+			if (token == nullptr)
+			{
+				qFatal("Missing trace file name");
+			}
+			tickProfileSetTraceFile(token);
+			break;
+
+		case CLI_REPLAY:
+			hostlaunch = 3;
+			token = poptGetOptArg(poptCon);
+			if (token == nullptr)
+			{
+				qFatal("Missing replay file name");
+			}
+			wz_replay = token;
+			break;
+
+		case CLI_REPLAYSPEED:
+			token = poptGetOptArg(poptCon);
+			if (token == nullptr || sscanf(token, "%u", &wz_replay_speed) != 1 || wz_replay_speed == 0)
+			{
+				qFatal("Bad replay speed");
+			}
+			break;
+
+		case CLI_STATEHASHES:
+			token = poptGetOptArg(poptCon);
+			if (token == nullptr)
+			{
+				qFatal("Missing state hash file name");
+			}
+			stateHashSetFile(token);
+			break;
 		};
 	}
 
@@ -668,3 +716,13 @@ const std::string &wz_skirmish_test()
 {
 	return wz_test;
 }
+
+const std::string &wz_replay_file()
+{
+	return wz_replay;
+}
+
+unsigned wz_replay_speed_factor()
+{
+	return wz_replay_speed;
+}
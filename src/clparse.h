@@ -31,5 +31,7 @@ bool ParseCommandLineEarly(int argc, const char * const *argv);
 bool autogame_enabled();
 const std::string &saveandquit_enabled();
 const std::string &wz_skirmish_test();
+const std::string &wz_replay_file();
+unsigned wz_replay_speed_factor();
 
 #endif // __INCLUDED_SRC_CLPARSE_H__
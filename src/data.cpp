@@ -815,6 +815,21 @@ static const RES_TYPE_MIN_FILE FileResourceTypes[] =
 	{"RESCH", bufferRESCHLoad, dataRESCHRelease},                  //research stats files
 };
 
+struct RES_TYPE_MIN_PRELOAD
+{
+	const char *aType;                      ///< points to the string defining the type (e.g. SCRIPT)
+	RES_PRELOAD preload;                    ///< thread-safe routine run ahead of the load routine
+	RES_DISCARD discard;                    ///< routine to drop what the preload routine prepared but the load routine didn't use
+};
+
+// Image decoding is the slowest part of loading, and the only part free of global state
+static const RES_TYPE_MIN_PRELOAD PreloadResourceTypes[] =
+{
+	{"IMGPAGE", iV_preloadImage_PNG, iV_discardPreloadedImages},
+	{"TERTILES", texPreload, iV_discardPreloadedImages},
+	{"IMG", iV_PreloadImageFile, iV_discardPreloadedImages},
+};
+
 /* Pass all the data loading functions to the framework library */
 bool dataInitLoadFuncs()
 {
@@ -853,5 +868,13 @@ bool dataInitLoadFuncs()
 		}
 	}
 
+	for (const RES_TYPE_MIN_PRELOAD &preloadType : PreloadResourceTypes)
+	{
+		if (!resAddPreload(preloadType.aType, preloadType.preload, preloadType.discard))
+		{
+			return false;
+		}
+	}
+
 	return true;
 }
@@ -83,6 +83,7 @@
 #include "cmddroid.h"
 #include "terrain.h"
 #include "warzoneconfig.h"
+#include "tickprofiler.h"
 
 /********************  Prototypes  ********************/
 
@@ -136,6 +137,10 @@ static WzText txtShowSamples_Act;
 static WzText txtShowOrders;
 // show Droid visible/draw counts text
 static WzText droidText;
+// show tick profile text
+static WzText txtTickProfile[TPP_COUNT + 1];
+// show network latency text
+static WzText txtNetLatency[MAX_PLAYERS + 1];
 
 
 /********************  Variables  ********************/
@@ -237,6 +242,14 @@ bool showORDERS = false;
   * default OFF, turn ON by flipping it here
   */
 bool showDROIDcounts = false;
+/**  Show the CPU time taken by each part of the game state update
+ *  default OFF, turn ON via console command 'showtickprofile'
+ */
+bool showTICKPROFILE = false;
+/**  Show the latency added to game messages, and the round trip time and jitter to each player
+ *  default OFF, turn ON via console command 'shownetlatency'
+ */
+bool showNETLATENCY = false;
 
 /** When we have a connection issue, we will flash a message on screen
 */
@@ -827,6 +840,43 @@ void draw3DScene()
 		height = txtShowOrders.height();
 		txtShowOrders.render(0, pie_GetVideoBufferHeight() - height, WZCOL_TEXT_BRIGHT);
 	}
+	if (showTICKPROFILE)
+	{
+		const unsigned numTicks = 50;  // 5 seconds of game time.
+		int y = pie_GetVideoBufferHeight() / 4;
+		for (int i = 0; i <= TPP_COUNT; ++i)
+		{
+			TICK_PROFILE_POINT pp = (TICK_PROFILE_POINT)i;
+			char line[128];
+			ssprintf(line, "%s: %u us (max %u us)", pp == TPP_COUNT ? "gameStateUpdate" : tickProfileName(pp), tickProfileAverage(pp, numTicks), tickProfileMaximum(pp, numTicks));
+			txtTickProfile[i].setText(line, font_regular);
+			y += txtTickProfile[i].height();
+			txtTickProfile[i].render(10, y, pp == TPP_COUNT ? WZCOL_TEXT_BRIGHT : WZCOL_TEXT_MEDIUM);
+		}
+	}
+	if (showNETLATENCY && bMultiPlayer)
+	{
+		int y = pie_GetVideoBufferHeight() / 4;
+		char line[128];
+		ssprintf(line, "Latency: %u ms (wanted %u ms), stalls: %u/s, %u total", NETgetStatistic(NetStatisticLatency, true), NETgetStatistic(NetStatisticLatency, false),
+		         NETgetStatistic(NetStatisticStalls, false), NETgetStatistic(NetStatisticStalls, false, true));
+		txtNetLatency[MAX_PLAYERS].setText(line, font_regular);
+		y += txtNetLatency[MAX_PLAYERS].height();
+		txtNetLatency[MAX_PLAYERS].render(10, y, WZCOL_TEXT_BRIGHT);
+		for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+		{
+			if (!NetPlay.players[player].allocated || player == selectedPlayer)
+			{
+				continue;
+			}
+			ssprintf(line, "%s: round trip %u ms (95%% %u ms), jitter %u ms (95%% %u ms)", getPlayerName(player),
+			         NETgetStatistic(NetStatisticRoundTrip, false, false, player), NETgetStatistic(NetStatisticRoundTrip, false, true, player),
+			         NETgetStatistic(NetStatisticJitter, false, false, player), NETgetStatistic(NetStatisticJitter, false, true, player));
+			txtNetLatency[player].setText(line, font_regular);
+			y += txtNetLatency[player].height();
+			txtNetLatency[player].render(10, y, WZCOL_TEXT_MEDIUM);
+		}
+	}
 	if (showDROIDcounts)
 	{
 		int visibleDroids = 0;
@@ -56,6 +56,8 @@ struct iView
 extern bool showFPS;
 extern bool showSAMPLES;
 extern bool showORDERS;
+extern bool showTICKPROFILE;
+extern bool showNETLATENCY;
 
 float getViewDistance();
 void setViewDistance(float dist);
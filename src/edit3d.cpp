@@ -68,6 +68,7 @@ void raiseTile(int tile3dX, int tile3dY)
 		{
 			adjustTileHeight(mapTile(i, j), TILE_RAISE);
 			markTileDirty(i, j);
+			visTerrainChanged(i, j);
 		}
 	}
 }
@@ -87,6 +88,7 @@ void lowerTile(int tile3dX, int tile3dY)
 		{
 			adjustTileHeight(mapTile(i, j), TILE_LOWER);
 			markTileDirty(i, j);
+			visTerrainChanged(i, j);
 		}
 	}
 }
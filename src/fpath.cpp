@@ -24,14 +24,14 @@
  *
  */
 
-#include <future>
+#include <memory>
 #include <unordered_map>
 
 #include "lib/framework/frame.h"
 #include "lib/framework/crc.h"
 #include "lib/netplay/netplay.h"
 
-#include "lib/framework/wzapp.h"
+#include "lib/framework/jobsystem.h"
 
 #include "objects.h"
 #include "map.h"
@@ -40,9 +40,6 @@
 
 #include "fpath.h"
 
-// If the path finding system is shutdown or not
-static volatile bool fpathQuit = false;
-
 /* Beware: Enabling this will cause significant slow-down. */
 #undef DEBUG_MAP
 
@@ -56,89 +53,24 @@ struct PATHRESULT
 
 
 // threading stuff
-static WZ_THREAD        *fpathThread = nullptr;
-static WZ_MUTEX         *fpathMutex = nullptr;
-static WZ_SEMAPHORE     *fpathSemaphore = nullptr;
-using packagedPathJob = wz::packaged_task<PATHRESULT()>;
-static std::list<packagedPathJob>    pathJobs;
-static std::unordered_map<uint32_t, wz::future<PATHRESULT>> pathResults;
-
-static bool             waitingForResult = false;
-static uint32_t         waitingForResultId;
-static WZ_SEMAPHORE     *waitingForResultSemaphore = nullptr;
+static std::unordered_map<uint32_t, JobFuture<PATHRESULT>> pathResults;
+static JobHandle        lastPathJob;  ///< Each path job runs after the previous one, as the A* contexts are shared.
 
 static PATHRESULT fpathExecute(PATHJOB psJob);
 
 
-/** This runs in a separate thread */
-static int fpathThreadFunc(void *)
-{
-	wzMutexLock(fpathMutex);
-
-	while (!fpathQuit)
-	{
-		if (pathJobs.empty())
-		{
-			ASSERT(!waitingForResult, "Waiting for a result (id %u) that doesn't exist.", waitingForResultId);
-			wzMutexUnlock(fpathMutex);
-			wzSemaphoreWait(fpathSemaphore);  // Go to sleep until needed.
-			wzMutexLock(fpathMutex);
-			continue;
-		}
-
-		// Copy the first job from the queue.
-		packagedPathJob job = std::move(pathJobs.front());
-		pathJobs.pop_front();
-
-		wzMutexUnlock(fpathMutex);
-		job();
-		wzMutexLock(fpathMutex);
-
-		waitingForResult = false;
-		objTrace(waitingForResultId, "These are the droids you are looking for.");
-		wzSemaphorePost(waitingForResultSemaphore);
-	}
-	wzMutexUnlock(fpathMutex);
-	return 0;
-}
-
-
 // initialise the findpath module
 bool fpathInitialise()
 {
-	// The path system is up
-	fpathQuit = false;
-
-	if (!fpathThread)
-	{
-		fpathMutex = wzMutexCreate();
-		fpathSemaphore = wzSemaphoreCreate(0);
-		waitingForResultSemaphore = wzSemaphoreCreate(0);
-		fpathThread = wzThreadCreate(fpathThreadFunc, nullptr);
-		wzThreadStart(fpathThread);
-	}
-
 	return true;
 }
 
 
 void fpathShutdown()
 {
-	if (fpathThread)
-	{
-		// Signal the path finding thread to quit
-		fpathQuit = true;
-		wzSemaphorePost(fpathSemaphore);  // Wake up thread.
-
-		wzThreadJoin(fpathThread);
-		fpathThread = nullptr;
-		wzMutexDestroy(fpathMutex);
-		fpathMutex = nullptr;
-		wzSemaphoreDestroy(fpathSemaphore);
-		fpathSemaphore = nullptr;
-		wzSemaphoreDestroy(waitingForResultSemaphore);
-		waitingForResultSemaphore = nullptr;
-	}
+	// Let any queued jobs finish, since they use the blocking maps
+	lastPathJob.wait();
+	lastPathJob = JobHandle();
 	fpathHardTableReset();
 }
 
@@ -190,7 +122,7 @@ bool fpathIsEquivalentBlocking(PROPULSION_TYPE propulsion1, int player1, FPATH_M
 	return true;
 }
 
-static uint8_t prop2bits(PROPULSION_TYPE propulsion)
+uint8_t prop2bits(PROPULSION_TYPE propulsion)
 {
 	uint8_t bits;
 
@@ -388,21 +320,16 @@ queuePathfinding:
 	// job or result for each droid in the system at any time.
 	fpathRemoveDroidData(id);
 
-	packagedPathJob task([job]() { return fpathExecute(job); });
-	pathResults[id] = task.get_future();
-
 	// Add to end of list
-	wzMutexLock(fpathMutex);
-	bool isFirstJob = pathJobs.empty();
-	pathJobs.push_back(std::move(task));
-	wzMutexUnlock(fpathMutex);
-
-	if (isFirstJob)
-	{
-		wzSemaphorePost(fpathSemaphore);  // Wake up processing thread.
-	}
-
-	objTrace(id, "Queued up a path-finding request to (%d, %d), at least %d items earlier in queue", tX, tY, isFirstJob);
+	bool isFirstJob = lastPathJob.finished();
+	JobFuture<PATHRESULT> &future = pathResults[id];
+	future.result = std::make_shared<PATHRESULT>();
+	std::shared_ptr<PATHRESULT> result = future.result;
+	future.job = lastPathJob = jobSubmitAfter({lastPathJob}, [job, result]() {
+		*result = fpathExecute(job);
+	});
+
+	objTrace(id, "Queued up a path-finding request to (%d, %d), %s", tX, tY, isFirstJob ? "with no earlier requests pending" : "behind earlier requests");
 	syncDebug("fpathRoute(..., %d, %d, %d, %d, %d, %d, %d, %d, %d) = FPR_WAIT", id, startX, startY, tX, tY, propulsionType, droidType, moveType, owner);
 	return FPR_WAIT;	// wait while polling result queue
 }
@@ -452,7 +379,7 @@ FPATH_RETVAL fpathDroidRoute(DROID *psDroid, SDWORD tX, SDWORD tY, FPATH_MOVETYP
 	                  psDroid->droidType, moveType, psDroid->player, acceptNearest, dstStructure);
 }
 
-// Run only from path thread
+// Run only from path jobs
 PATHRESULT fpathExecute(PATHJOB job)
 {
 	PATHRESULT result;
@@ -499,26 +426,28 @@ PATHRESULT fpathExecute(PATHJOB job)
 	return result;
 }
 
-/** Find the length of the job queue. Function is thread-safe. */
+/** Find the length of the job queue. */
 static int fpathJobQueueLength()
 {
 	int count = 0;
 
-	wzMutexLock(fpathMutex);
-	count = pathJobs.size();  // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
-	wzMutexUnlock(fpathMutex);
+	for (auto const &result : pathResults)
+	{
+		count += !result.second.finished();
+	}
 	return count;
 }
 
 
-/** Find the length of the result queue, excepting future results. Function is thread-safe. */
+/** Find the length of the result queue, excepting future results. */
 static int fpathResultQueueLength()
 {
 	int count = 0;
 
-	wzMutexLock(fpathMutex);
-	count = pathResults.size();  // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
-	wzMutexUnlock(fpathMutex);
+	for (auto const &result : pathResults)
+	{
+		count += result.second.finished();
+	}
 	return count;
 }
 
@@ -539,10 +468,7 @@ void fpathTest(int x, int y, int x2, int y2)
 	(void)fpathJobQueueLength();
 
 	/* Check initial state */
-	assert(fpathThread != nullptr);
-	assert(fpathMutex != nullptr);
-	assert(fpathSemaphore != nullptr);
-	assert(pathJobs.empty());
+	assert(lastPathJob.finished());
 	assert(pathResults.empty());
 	fpathRemoveDroidData(0);	// should not crash
 
@@ -561,10 +487,7 @@ void fpathTest(int x, int y, int x2, int y2)
 	assert(fpathJobQueueLength() == 1 || fpathResultQueueLength() == 1);
 	fpathRemoveDroidData(2);	// should not crash, nor remove our path
 	assert(fpathJobQueueLength() == 1 || fpathResultQueueLength() == 1);
-	while (fpathResultQueueLength() == 0)
-	{
-		wzYieldCurrentThread();
-	}
+	lastPathJob.wait();
 	assert(fpathJobQueueLength() == 0);
 	assert(fpathResultQueueLength() == 1);
 	r = fpathSimpleRoute(&sMove, 1, x, y, x2, y2);
@@ -581,10 +504,8 @@ void fpathTest(int x, int y, int x2, int y2)
 		r = fpathSimpleRoute(&sMove, i, x, y, x2, y2);
 		assert(r == FPR_WAIT);
 	}
-	while (fpathResultQueueLength() != 100)
-	{
-		wzYieldCurrentThread();
-	}
+	lastPathJob.wait();
+	assert(fpathResultQueueLength() == 100);
 	assert(fpathJobQueueLength() == 0);
 	for (i = 1; i <= 100; i++)
 	{
@@ -608,7 +529,6 @@ void fpathTest(int x, int y, int x2, int y2)
 	{
 		fpathRemoveDroidData(i);
 	}
-	//assert(pathJobs.empty()); // can now be marked .deleted as well
 	assert(pathResults.empty());
 	(void)r;  // Squelch unused-but-set warning.
 }
@@ -63,7 +63,7 @@ enum FPATH_RETVAL
 {
 	FPR_OK,         ///< found a route
 	FPR_FAILED,     ///< failed to find a route
-	FPR_WAIT,       ///< route is being calculated by the path-finding thread
+	FPR_WAIT,       ///< route is being calculated by a path-finding job
 };
 
 /** Initialise the path-finding module.
@@ -80,6 +80,9 @@ void fpathUpdate();
  */
 FPATH_RETVAL fpathDroidRoute(DROID *psDroid, SDWORD targetX, SDWORD targetY, FPATH_MOVETYPE moveType);
 
+/// Returns the blocking bits of the map tiles which block the propulsion, the only thing fpathBaseBlockingTile looks at the propulsion for.
+uint8_t prop2bits(PROPULSION_TYPE propulsion);
+
 /// Returns true iff the parameters have equivalent behaviour in fpathBaseBlockingTile.
 bool fpathIsEquivalentBlocking(PROPULSION_TYPE propulsion1, int player1, FPATH_MOVETYPE moveType1,
                                PROPULSION_TYPE propulsion2, int player2, FPATH_MOVETYPE moveType2);
@@ -6216,6 +6216,7 @@ bool loadSaveResearch(const char *pFileName)
 			psPlRes = &asPlayerResList[plr][statInc];
 			// Copy the research status
 			psPlRes->ResearchStatus = (researched & RESBITS);
+			researchStatusChanged(psPlRes);
 			if (possible != 0)
 			{
 				MakeResearchPossible(psPlRes);
@@ -27,6 +27,7 @@
 #include "lib/framework/frame.h"
 
 #include "map.h"
+#include "terrain.h"
 #include "wrappers.h"
 
 #include "gateway.h"
@@ -55,12 +56,14 @@ static SDWORD gwMapHeight()
 static void gwSetGatewayFlag(SDWORD x, SDWORD y)
 {
 	mapTile((UDWORD)x, (UDWORD)y)->tileInfoBits |= BITS_GATEWAY;
+	markLightmapDirty(x, y);
 }
 
 // clear the gateway flag on a tile
 static void gwClearGatewayFlag(SDWORD x, SDWORD y)
 {
 	mapTile((UDWORD)x, (UDWORD)y)->tileInfoBits &= ~BITS_GATEWAY;
+	markLightmapDirty(x, y);
 }
 
 
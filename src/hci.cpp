@@ -3610,6 +3610,7 @@ static bool intAddStats(BASE_STATS **ppsStatsList, UDWORD numStats,
 	/* Create the basic form */
 	IntFormAnimated *statForm = new IntFormAnimated(parent, false);
 	statForm->id = IDSTAT_FORM;
+	statForm->setLayerCached(true);  // The buttons hold 3D models, which are expensive to draw every frame.
 	statForm->setCalcLayout(LAMBDA_CALCLAYOUT_SIMPLE({
 		psWidget->setGeometry(STAT_X, STAT_Y, STAT_WIDTH, STAT_HEIGHT);
 	}));
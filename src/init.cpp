@@ -38,6 +38,7 @@
 #include "lib/ivis_opengl/tex.h"
 #include "lib/ivis_opengl/imd.h"
 #include "lib/netplay/netplay.h"
+#include "lib/netplay/netreplay.h"
 #include "lib/script/script.h"
 #include "lib/sound/audio_id.h"
 #include "lib/sound/cdaudio.h"
@@ -68,6 +69,8 @@
 #include "lighting.h"
 #include "loop.h"
 #include "mapgrid.h"
+#include "tickprofiler.h"
+#include "statehash.h"
 #include "mechanics.h"
 #include "miscimd.h"
 #include "mission.h"
@@ -75,6 +78,7 @@
 #include "multiint.h"
 #include "multigifts.h"
 #include "multiplay.h"
+#include "multireplay.h"
 #include "projectile.h"
 #include "order.h"
 #include "radar.h"
@@ -95,6 +99,9 @@
 #include "template.h"
 
 #include <algorithm>
+#include <map>
+
+#include <3rdparty/json/json.hpp>
 
 static void initMiscVars();
 
@@ -467,10 +474,131 @@ bool rebuildSearchPath(searchPathMode mode, bool force, const char *current_map)
 	return true;
 }
 
+#define MAP_INDEX_FILE		"mapindex.json"	///< Cache of what buildMapList() found in each map archive, in the write directory.
+#define MAP_INDEX_VERSION	1
+
+/// What is known about a map archive. Only valid while the archive has the same size and modification time.
+struct MapIndexEntry
+{
+	int64_t size = -1;
+	int64_t modTime = -1;
+	bool checked = false;           ///< listMapFiles() has filled in mapPack.
+	bool mapPack = false;           ///< Contains more than one map, so listMapFiles() rejects it.
+	bool scanned = false;           ///< buildMapList() has filled in levFiles and isMapMod.
+	bool isMapMod = false;
+	std::vector<std::pair<std::string, std::string>> levFiles;  ///< Name and contents of each .addon.lev and .xplayers.lev file.
+	bool used = false;              ///< Still exists, so should be saved.
+};
+
+static std::map<std::string, MapIndexEntry> mapIndex;  ///< Keyed by archive name, such as "maps/2c-Startup.wz".
+static bool mapIndexDirty = false;  ///< Whether the index needs saving.
+
+static void mapIndexLoad()
+{
+	mapIndex.clear();
+	mapIndexDirty = true;  // Until proven otherwise.
+
+	char *pBuffer;
+	UDWORD size;
+	if (!PHYSFS_exists(MAP_INDEX_FILE) || !loadFile(MAP_INDEX_FILE, &pBuffer, &size))
+	{
+		return;
+	}
+	nlohmann::json root;
+	try {
+		root = nlohmann::json::parse(pBuffer, pBuffer + size);
+		if (root.value("version", 0) != MAP_INDEX_VERSION)
+		{
+			debug(LOG_WZ, "Ignoring %s from another version", MAP_INDEX_FILE);
+			free(pBuffer);
+			return;
+		}
+		for (auto const &map : root.at("maps"))
+		{
+			MapIndexEntry entry;
+			entry.size = map.at("size").get<int64_t>();
+			entry.modTime = map.at("modTime").get<int64_t>();
+			entry.checked = true;
+			entry.mapPack = map.at("mapPack").get<bool>();
+			entry.scanned = map.at("scanned").get<bool>();
+			entry.isMapMod = map.at("isMapMod").get<bool>();
+			for (auto const &lev : map.at("levFiles"))
+			{
+				entry.levFiles.emplace_back(lev.at("name").get<std::string>(), lev.at("contents").get<std::string>());
+			}
+			mapIndex[map.at("archive").get<std::string>()] = std::move(entry);
+		}
+		mapIndexDirty = false;
+	}
+	catch (const std::exception &e) {
+		debug(LOG_WARNING, "Ignoring broken %s: %s", MAP_INDEX_FILE, e.what());
+		mapIndex.clear();
+	}
+	free(pBuffer);
+}
+
+static void mapIndexSave()
+{
+	for (auto const &it : mapIndex)
+	{
+		mapIndexDirty = mapIndexDirty || !it.second.used || !it.second.checked;
+	}
+	if (!mapIndexDirty)
+	{
+		return;
+	}
+
+	nlohmann::json maps = nlohmann::json::array();
+	for (auto const &it : mapIndex)
+	{
+		MapIndexEntry const &entry = it.second;
+		if (!entry.used || !entry.checked)
+		{
+			continue;  // Archive was deleted or couldn't be mounted, forget about it.
+		}
+		nlohmann::json levFiles = nlohmann::json::array();
+		for (auto const &lev : entry.levFiles)
+		{
+			levFiles.push_back({{"name", lev.first}, {"contents", lev.second}});
+		}
+		maps.push_back({{"archive", it.first}, {"size", entry.size}, {"modTime", entry.modTime}, {"mapPack", entry.mapPack},
+		                {"scanned", entry.scanned}, {"isMapMod", entry.isMapMod}, {"levFiles", levFiles}});
+	}
+	nlohmann::json root = {{"version", MAP_INDEX_VERSION}, {"maps", maps}};
+	std::string jsonString = root.dump();
+	saveFile(MAP_INDEX_FILE, jsonString.c_str(), jsonString.size());
+	mapIndexDirty = false;
+}
+
+/// Returns the index entry for the archive, cleared if the archive changed since it was indexed.
+static MapIndexEntry &mapIndexLookup(std::string const &realFileName)
+{
+	int64_t size = -1;
+	PHYSFS_file *fileHandle = PHYSFS_openRead(realFileName.c_str());
+	if (fileHandle != nullptr)
+	{
+		size = PHYSFS_fileLength(fileHandle);
+		PHYSFS_close(fileHandle);
+	}
+	int64_t modTime = WZ_PHYSFS_getLastModTime(realFileName.c_str());
+
+	MapIndexEntry &entry = mapIndex[realFileName];
+	if (entry.size != size || entry.modTime != modTime || size < 0)
+	{
+		entry = MapIndexEntry();
+		entry.size = size;
+		entry.modTime = modTime;
+		mapIndexDirty = true;
+	}
+	entry.used = true;
+	return entry;
+}
+
 typedef std::vector<std::string> MapFileList;
 static MapFileList listMapFiles()
 {
 	MapFileList ret, filtered, oldSearchPath;
+	std::vector<bool> known;  ///< Whether the map pack check of ret[i] is already in the index.
 
 	char **subdirlist = PHYSFS_enumerateFiles("maps");
 
@@ -484,8 +612,23 @@ static MapFileList listMapFiles()
 
 		std::string realFileName = std::string("maps/") + *i;
 		ret.push_back(realFileName);
+		known.push_back(mapIndexLookup(realFileName).checked);
 	}
 	PHYSFS_freeList(subdirlist);
+
+	if (std::find(known.begin(), known.end(), false) == known.end())
+	{
+		// Nothing new, so there's no need to touch the search path.
+		for (const auto &realFileName : ret)
+		{
+			if (!mapIndex[realFileName].mapPack)
+			{
+				filtered.push_back(realFileName);
+			}
+		}
+		return filtered;
+	}
+
 	// save our current search path(s)
 	debug(LOG_WZ, "Map search paths:");
 	char **searchPath = PHYSFS_getSearchPath();
@@ -497,8 +640,18 @@ static MapFileList listMapFiles()
 	}
 	PHYSFS_freeList(searchPath);
 
-	for (const auto &realFileName : ret)
+	for (size_t n = 0; n < ret.size(); ++n)
 	{
+		const std::string &realFileName = ret[n];
+		MapIndexEntry &entry = mapIndex[realFileName];
+		if (known[n])
+		{
+			if (!entry.mapPack)
+			{
+				filtered.push_back(realFileName);
+			}
+			continue;
+		}
 		std::string realFilePathAndName = PHYSFS_getWriteDir() + realFileName;
 		if (PHYSFS_mount(realFilePathAndName.c_str(), NULL, PHYSFS_APPEND))
 		{
@@ -524,6 +677,8 @@ static MapFileList listMapFiles()
 				}
 			}
 			PHYSFS_freeList(filelist);
+			entry.checked = true;
+			entry.mapPack = unsafe >= 2;
 			if (unsafe < 2)
 			{
 				filtered.push_back(realFileName);
@@ -633,28 +788,53 @@ bool buildMapList()
 	}
 	loadLevFile("addon.lev", mod_multiplay, false, nullptr);
 	WZ_Maps.clear();
+	mapIndexLoad();
 	MapFileList realFileNames = listMapFiles();
 	for (auto &realFileName : realFileNames)
 	{
 		bool mapmod = false;
 		struct WZmaps CurrentMap;
+		MapIndexEntry &entry = mapIndex[realFileName];
+
+		if (entry.scanned)
+		{
+			// Archive unchanged since it was indexed, so no need to open it.
+			for (auto const &lev : entry.levFiles)
+			{
+				debug(LOG_WZ, "Loading lev file: \"%s\" from \"%s\", cached\n", lev.first.c_str(), realFileName.c_str());
+				if (!levParse(lev.second.data(), lev.second.size(), mod_multiplay, true, realFileName.c_str()))
+				{
+					debug(LOG_ERROR, "Parse error in %s\n", lev.first.c_str());
+				}
+			}
+			CurrentMap.MapName = realFileName;
+			CurrentMap.isMapMod = entry.isMapMod;
+			WZ_Maps.push_back(CurrentMap);
+			continue;
+		}
+
 		std::string realFilePathAndName = PHYSFS_getRealDir(realFileName.c_str()) + realFileName;
 
 		PHYSFS_mount(realFilePathAndName.c_str(), NULL, PHYSFS_APPEND);
 
+		entry.levFiles.clear();
 		char **filelist = PHYSFS_enumerateFiles("");
 		for (char **file = filelist; *file != nullptr; ++file)
 		{
 			std::string checkfile = *file;
 			size_t len = strlen(*file);
-			if (len > 10 && !strcasecmp(*file + (len - 10), ".addon.lev"))  // Do not add addon.lev again
-			{
-				loadLevFile(*file, mod_multiplay, true, realFileName.c_str());
-			}
-			// add support for X player maps using a new name to prevent conflicts.
-			if (len > 13 && !strcasecmp(*file + (len - 13), ".xplayers.lev"))
+			// Do not add addon.lev again, and add support for X player maps using a new name to prevent conflicts.
+			if ((len > 10 && !strcasecmp(*file + (len - 10), ".addon.lev")) || (len > 13 && !strcasecmp(*file + (len - 13), ".xplayers.lev")))
 			{
 				loadLevFile(*file, mod_multiplay, true, realFileName.c_str());
+
+				char *pBuffer;
+				UDWORD size;
+				if (loadFile(*file, &pBuffer, &size))
+				{
+					entry.levFiles.emplace_back(*file, std::string(pBuffer, size));
+					free(pBuffer);
+				}
 			}
 		}
 		PHYSFS_freeList(filelist);
@@ -670,10 +850,15 @@ bool buildMapList()
 			mapmod = CheckInMap(realFilePathAndName.c_str(), "WZMap", "WZMap/multiplay");
 		}
 
+		entry.isMapMod = mapmod;
+		entry.scanned = true;
+		mapIndexDirty = true;
+
 		CurrentMap.MapName = realFileName;
 		CurrentMap.isMapMod = mapmod;
 		WZ_Maps.push_back(CurrentMap);
 	}
+	mapIndexSave();
 
 	return true;
 }
@@ -765,6 +950,8 @@ void systemShutdown()
 	widgShutDown();
 	fpathShutdown();
 	mapShutdown();
+	tickProfileShutdown();
+	stateHashShutdown();
 	debug(LOG_MAIN, "shutting down everything else");
 	pal_ShutDown();		// currently unused stub
 	frameShutDown();	// close screen / SDL / resources / cursors / trig
@@ -1104,12 +1291,12 @@ bool stageTwoInitialise()
 	// Setup game queues.
 	// Don't ask why this doesn't go in stage three. In fact, don't even ask me what stage one/two/three is supposed to mean, it seems about as descriptive as stage doStuff, stage doMoreStuff and stage doEvenMoreStuff...
 	debug(LOG_MAIN, "Init game queues, I am %d.", selectedPlayer);
-	sendQueuedDroidInfo();  // Discard any pending orders which could later get flushed into the game queue.
+	resetQueuedDroidInfo();  // Discard any pending orders which could later get flushed into the game queue, and the selections remembered from the last game.
 	for (i = 0; i < MAX_PLAYERS; ++i)
 	{
 		NETinitQueue(NETgameQueue(i));
 
-		if (!myResponsibility(i))
+		if (!myResponsibility(i) || NETisReplay())
 		{
 			NETsetNoSendOverNetwork(NETgameQueue(i));
 		}
@@ -1218,6 +1405,7 @@ bool stageThreeInitialise()
 	{
 		if (!fromSave)
 		{
+			multiReplaySaveStart();  // Before multiGameInit() and the scripts change any of the settings.
 			multiGameInit();
 		}
 		initTemplates();
@@ -1303,6 +1491,9 @@ bool stageThreeShutDown()
 
 	hostlaunch = 0;
 
+	multiReplaySaveStop();
+	multiReplayLoadStop();
+
 	removeSpotters();
 
 	// There is an asymmetry in scripts initialization and destruction, due
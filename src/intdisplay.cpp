@@ -709,6 +709,10 @@ void IntFancyButton::initDisplay()
 
 void IntFancyButton::doneDisplay()
 {
+	if (model.rate != 0)
+	{
+		dirty = true;  // Still rotating.
+	}
 }
 
 void IntFancyButton::displayIfHighlight(int xOffset, int yOffset)
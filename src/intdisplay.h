@@ -157,6 +157,10 @@ public:
 	IntObjectButton(WIDGET *parent);
 
 	virtual void display(int xOffset, int yOffset);
+	bool isAnimated() const override
+	{
+		return true;  // Shows the current state of the object.
+	}
 
 	void setObject(BASE_OBJECT *object)
 	{
@@ -205,6 +209,7 @@ public:
 	void setStats(BASE_STATS *stats)
 	{
 		Stat = stats;
+		dirty = true;
 	}
 	void setStatsAndTip(BASE_STATS *stats)
 	{
@@ -223,6 +228,10 @@ public:
 	IntFormAnimated(WIDGET *parent, bool openAnimate = true);
 
 	virtual void display(int xOffset, int yOffset);
+	bool isAnimated() const override
+	{
+		return currentAction != 2 || W_FORM::isAnimated();
+	}
 
 	void closeAnimateDelete();              ///< Animates the form closing, and deletes itself when done.
 
@@ -288,6 +297,10 @@ public:
 	IntTransportButton(WIDGET *parent);
 
 	virtual void display(int xOffset, int yOffset);
+	bool isAnimated() const override
+	{
+		return true;  // Shows the current state of the droid.
+	}
 
 	void setObject(DROID *object)
 	{
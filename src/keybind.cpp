@@ -635,6 +635,18 @@ void kf_ToggleOrders()	// Displays orders & action of currently selected unit.
 	CONPRINTF("Unit Order/Action displayed is %s", showORDERS ? "Enabled" : "Disabled");
 }
 
+void kf_ToggleTickProfile()	// Displays the CPU time taken by each part of the game state update.
+{
+	showTICKPROFILE = !showTICKPROFILE;
+	CONPRINTF("Tick profile displayed is %s", showTICKPROFILE ? "Enabled" : "Disabled");
+}
+
+void kf_ToggleNetLatency()	// Displays the game message latency, and the round trip time and jitter to each player.
+{
+	showNETLATENCY = !showNETLATENCY;
+	CONPRINTF("Network latency displayed is %s", showNETLATENCY ? "Enabled" : "Disabled");
+}
+
 /* Writes out the frame rate */
 void	kf_FrameRate()
 {
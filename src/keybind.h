@@ -38,6 +38,8 @@ void kf_BuildInfo();
 void kf_ToggleFPS();			//FPS counter NOT same as kf_Framerate! -Q
 void kf_ToggleSamples();		// Displays # of sound samples in Queue/list.
 void kf_ToggleOrders();		//displays unit's Order/action state.
+void kf_ToggleTickProfile();	// Displays the CPU time of each part of the game update.
+void kf_ToggleNetLatency();	// Displays the game message latency and the jitter of each player.
 void kf_FrameRate();
 void kf_ShowNumObjects();
 void kf_ToggleRadar();
@@ -34,6 +34,7 @@
 #include "lib/framework/physfs_ext.h"
 #include "lib/framework/rational.h"
 #include "lib/gamelib/gtime.h"
+#include "lib/netplay/netreplay.h"
 #include "lib/exceptionhandler/dumpinfo.h"
 #include "clparse.h"
 #include "init.h"
@@ -1049,11 +1050,15 @@ bool levLoadData(char const *name, Sha256 const *hash, char *pSaveName, GAME_TYP
 	if (autogame_enabled())
 	{
 		gameTimeSetMod(Rational(500));
-		if (hostlaunch != 2) // tests will specify the AI manually
+		if (hostlaunch != 2 && !NETisReplay()) // tests will specify the AI manually, and replays already hold its decisions
 		{
 			jsAutogameSpecific("multiplay/skirmish/semperfi.js", selectedPlayer);
 		}
 	}
+	else if (NETisReplay() && wz_replay_speed_factor() != 1)
+	{
+		gameTimeSetMod(Rational((int)wz_replay_speed_factor()));
+	}
 
 	return true;
 }
@@ -76,6 +76,9 @@
 #include "warcam.h"
 #include "lighting.h"
 #include "mapgrid.h"
+#include "ai.h"
+#include "tickprofiler.h"
+#include "statehash.h"
 #include "edit3d.h"
 #include "fpath.h"
 #include "scriptextern.h"
@@ -522,6 +525,8 @@ void countUpdate(bool synch)
 
 static void gameStateUpdate()
 {
+	tickProfileStartTick();
+
 	syncDebug("map = \"%s\", pseudorandom 32-bit integer = 0x%08X, allocated = %d %d %d %d %d %d %d %d %d %d, position = %d %d %d %d %d %d %d %d %d %d", game.map, gameRandU32(),
 	          NetPlay.players[0].allocated, NetPlay.players[1].allocated, NetPlay.players[2].allocated, NetPlay.players[3].allocated, NetPlay.players[4].allocated, NetPlay.players[5].allocated, NetPlay.players[6].allocated, NetPlay.players[7].allocated, NetPlay.players[8].allocated, NetPlay.players[9].allocated,
 	          NetPlay.players[0].position, NetPlay.players[1].position, NetPlay.players[2].position, NetPlay.players[3].position, NetPlay.players[4].position, NetPlay.players[5].position, NetPlay.players[6].position, NetPlay.players[7].position, NetPlay.players[8].position, NetPlay.players[9].position
@@ -544,6 +549,8 @@ static void gameStateUpdate()
 
 	if (!paused && !scriptPaused())
 	{
+		TickProfileScope profile(TPP_SCRIPTS);
+
 		/* Update the event system */
 		if (!bInTutorial)
 		{
@@ -560,47 +567,78 @@ static void gameStateUpdate()
 	handleAbandonedStructures();
 
 	// Update the visibility change stuff
-	visUpdateLevel();
+	{
+		TickProfileScope profile(TPP_VISIBILITY_LEVEL);
+		visUpdateLevel();
+	}
 
 	// Put all droids/structures/features into the grid.
-	gridReset();
+	{
+		TickProfileScope profile(TPP_GRID_RESET);
+		gridReset();
+	}
 
 	// Check which objects are visible.
-	processVisibility();
+	{
+		TickProfileScope profile(TPP_VISIBILITY);
+		processVisibility();
+	}
 
 	// Update the map.
-	mapUpdate();
+	{
+		TickProfileScope profile(TPP_MAP);
+		mapUpdate();
+	}
 
 	//update the findpath system
-	fpathUpdate();
+	{
+		TickProfileScope profile(TPP_PATHFINDING);
+		fpathUpdate();
+	}
 
 	// update the command droids
 	cmdDroidUpdate();
 
 	fireWaitingCallbacks(); //Now is the good time to fire waiting callbacks (since interpreter is off now)
 
+	// Do the read-only part of the droid AI for all players at once, the results are used by the updates below.
+	{
+		TickProfileScope profile(TPP_AI_PREPARE);
+		aiPrepareTargetSearches();
+	}
+
 	for (unsigned i = 0; i < MAX_PLAYERS; i++)
 	{
 		//update the current power available for a player
-		updatePlayerPower(i);
+		{
+			TickProfileScope profile(TPP_POWER);
+			updatePlayerPower(i);
+		}
 
 		DROID *psNext;
-		for (DROID *psCurr = apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
 		{
-			// Copy the next pointer - not 100% sure if the droid could get destroyed but this covers us anyway
-			psNext = psCurr->psNext;
-			droidUpdate(psCurr);
+			TickProfileScope profile(TPP_DROIDS);
+			for (DROID *psCurr = apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
+			{
+				// Copy the next pointer - not 100% sure if the droid could get destroyed but this covers us anyway
+				psNext = psCurr->psNext;
+				droidUpdate(psCurr);
+			}
 		}
 
-		for (DROID *psCurr = mission.apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
 		{
-			/* Copy the next pointer - not 100% sure if the droid could
-			get destroyed but this covers us anyway */
-			psNext = psCurr->psNext;
-			missionDroidUpdate(psCurr);
+			TickProfileScope profile(TPP_MISSION_DROIDS);
+			for (DROID *psCurr = mission.apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
+			{
+				/* Copy the next pointer - not 100% sure if the droid could
+				get destroyed but this covers us anyway */
+				psNext = psCurr->psNext;
+				missionDroidUpdate(psCurr);
+			}
 		}
 
 		// FIXME: These for-loops are code duplicationo
+		TickProfileScope profile(TPP_STRUCTURES);
 		STRUCTURE *psNBuilding;
 		for (STRUCTURE *psCBuilding = apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
 		{
@@ -616,22 +654,33 @@ static void gameStateUpdate()
 		}
 	}
 
+	aiDiscardTargetSearches();
+
 	missionTimerUpdate();
 
-	proj_UpdateAll();
+	{
+		TickProfileScope profile(TPP_PROJECTILES);
+		proj_UpdateAll();
+	}
 
-	FEATURE *psNFeat;
-	for (FEATURE *psCFeat = apsFeatureLists[0]; psCFeat; psCFeat = psNFeat)
 	{
-		psNFeat = psCFeat->psNext;
-		featureUpdate(psCFeat);
+		TickProfileScope profile(TPP_FEATURES);
+		FEATURE *psNFeat;
+		for (FEATURE *psCFeat = apsFeatureLists[0]; psCFeat; psCFeat = psNFeat)
+		{
+			psNFeat = psCFeat->psNext;
+			featureUpdate(psCFeat);
+		}
 	}
 
 	// Clean up dead droid pointers in UI.
 	hciUpdate();
 
 	// Free dead droid memory.
-	objmemUpdate();
+	{
+		TickProfileScope profile(TPP_OBJMEM);
+		objmemUpdate();
+	}
 
 	// Must end update, since we may or may not have ticked, and some message queue processing code may vary depending on whether it's in an update.
 	gameTimeUpdateEnd();
@@ -639,6 +688,10 @@ static void gameStateUpdate()
 	// Must be at the end of gameStateUpdate, since countUpdate is also called randomly (unsynchronised) between gameStateUpdate calls, but should have no effect if we already called it, and recvMessage requires consistent counts on all clients.
 	countUpdate(true);
 
+	tickProfileEndTick();
+
+	stateHashTick();
+
 	static int i = 0;
 	if (i++ % 10 == 0) // trigger every second
 	{
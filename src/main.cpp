@@ -1168,6 +1168,8 @@ int realmain(int argc, char *argv[])
 
 	PHYSFS_mkdir("music");	// custom music overriding default music and music mods
 
+	PHYSFS_mkdir("replay");	// recorded multiplayer games
+
 	make_dir(SaveGamePath, "savegames", nullptr); 	// save games
 	PHYSFS_mkdir("savegames/campaign");		// campaign save games
 	PHYSFS_mkdir("savegames/skirmish");		// skirmish save games
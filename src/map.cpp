@@ -49,13 +49,11 @@
 #include "fpath.h"
 #include "levels.h"
 #include "scriptfuncs.h"
-#include "lib/framework/wzapp.h"
+#include "lib/framework/jobsystem.h"
 
 #define GAME_TICKS_FOR_DANGER (GAME_TICKS_PER_SEC * 2)
 
-static WZ_THREAD *dangerThread = nullptr;
-static WZ_SEMAPHORE *dangerSemaphore = nullptr;
-static WZ_SEMAPHORE *dangerDoneSemaphore = nullptr;
+static JobHandle dangerJob;  ///< Flood fill of the danger map of lastDangerPlayer.
 struct floodtile
 {
 	uint8_t x;
@@ -784,7 +782,7 @@ bool mapLoad(char *filename, bool preview)
 	ASSERT(psMapTiles == nullptr, "Map has not been cleared before calling mapLoad()!");
 
 	/* Allocate the memory for the map */
-	psMapTiles = (MAPTILE *)calloc(width * height, sizeof(MAPTILE));
+	psMapTiles = (MAPTILE *)calloc(width * height, sizeof(MAPTILE) + sizeof(MAPTILE_VISION));  // Tiles followed by the vision layer, see mapTileVision().
 	ASSERT(psMapTiles != nullptr, "Out of memory");
 
 	mapWidth = width;
@@ -820,9 +818,7 @@ bool mapLoad(char *filename, bool preview)
 		psMapTiles[i].height = height * ELEVATION_SCALE;
 
 		// Visibility stuff
-		memset(psMapTiles[i].watchers, 0, sizeof(psMapTiles[i].watchers));
-		memset(psMapTiles[i].sensors, 0, sizeof(psMapTiles[i].sensors));
-		memset(psMapTiles[i].jammers, 0, sizeof(psMapTiles[i].jammers));
+		memset(mapTileVision(&psMapTiles[i]), 0, sizeof(MAPTILE_VISION));
 		psMapTiles[i].sensorBits = 0;
 		psMapTiles[i].jammerBits = 0;
 		psMapTiles[i].tileExploredBits = 0;
@@ -917,6 +913,7 @@ bool mapLoad(char *filename, bool preview)
 	/* Set continents. This should ideally be done in advance by the map editor. */
 	mapFloodFillContinents();
 ok:
+	visMapChanged();
 	PHYSFS_close(fp);
 	return true;
 
@@ -1026,18 +1023,8 @@ bool mapShutdown()
 {
 	int x;
 
-	if (dangerThread)
-	{
-		wzSemaphoreWait(dangerDoneSemaphore);
-		lastDangerPlayer = -1;
-		wzSemaphorePost(dangerSemaphore);
-		wzThreadJoin(dangerThread);
-		wzSemaphoreDestroy(dangerSemaphore);
-		wzSemaphoreDestroy(dangerDoneSemaphore);
-		dangerThread = nullptr;
-		dangerSemaphore = nullptr;
-		dangerDoneSemaphore = nullptr;
-	}
+	dangerJob.wait();
+	dangerJob = JobHandle();
 
 	free(psMapTiles);
 	delete[] mapDecals;
@@ -1857,16 +1844,12 @@ static int dangerFloodFill(int player)
 	return 0;
 }
 
-// This function runs in a separate thread!
-static int dangerThreadFunc(WZ_DECL_UNUSED void *data)
+// The job runs on a worker thread!
+static void dangerStartFloodFill(int player)
 {
-	while (lastDangerPlayer != -1)
-	{
-		dangerFloodFill(lastDangerPlayer);	// Do the actual work
-		wzSemaphorePost(dangerDoneSemaphore);   // Signal that we are done
-		wzSemaphoreWait(dangerSemaphore);	// Go to sleep until needed.
-	}
-	return 0;
+	dangerJob = jobSubmit([player]() {
+		dangerFloodFill(player);
+	});
 }
 
 static inline void threatUpdateTarget(int player, BASE_OBJECT *psObj, bool ground, bool air)
@@ -1969,8 +1952,8 @@ void mapInit()
 	lastDangerUpdate = 0;
 	lastDangerPlayer = -1;
 
-	// Start danger thread (not used for campaign for now - mission map swaps too icky)
-	ASSERT(dangerSemaphore == nullptr && dangerThread == nullptr, "Map data not cleaned up before starting!");
+	// Start danger job (not used for campaign for now - mission map swaps too icky)
+	ASSERT(!dangerJob.valid(), "Map data not cleaned up before starting!");
 	if (game.type == SKIRMISH)
 	{
 		for (player = 0; player < MAX_PLAYERS; player++)
@@ -1981,10 +1964,7 @@ void mapInit()
 			auxMapRestore(player, AUX_DANGERMAP, AUXBITS_DANGER | AUXBITS_THREAT | AUXBITS_AATHREAT);
 		}
 		lastDangerPlayer = 0;
-		dangerSemaphore = wzSemaphoreCreate(0);
-		dangerDoneSemaphore = wzSemaphoreCreate(0);
-		dangerThread = wzThreadCreate(dangerThreadFunc, nullptr);
-		wzThreadStart(dangerThread);
+		dangerStartFloodFill(lastDangerPlayer);
 	}
 }
 
@@ -2013,12 +1993,12 @@ void mapUpdate()
 		lastDangerUpdate = gameTime;
 
 		// Lock if previous job not done yet
-		wzSemaphoreWait(dangerDoneSemaphore);
+		dangerJob.wait();
 
 		auxMapRestore(lastDangerPlayer, AUX_DANGERMAP, AUXBITS_THREAT | AUXBITS_AATHREAT | AUXBITS_DANGER);
 		lastDangerPlayer = (lastDangerPlayer + 1) % game.maxPlayers;
 		auxMapStore(lastDangerPlayer, AUX_DANGERMAP);
 		threatUpdate(lastDangerPlayer);
-		wzSemaphorePost(dangerSemaphore);
+		dangerStartFloodFill(lastDangerPlayer);
 	}
 }
@@ -31,6 +31,7 @@
 #include "multiplay.h"
 #include "display.h"
 #include "ai.h"
+#include "visibility.h"
 
 /* The different types of terrain as far as the game is concerned */
 enum TYPE_OF_TERRAIN
@@ -91,27 +92,32 @@ struct GROUND_TYPE
 	float textureSize;
 };
 
-/* Information stored with each tile */
+/* Information stored with each tile. Fields used by pathfinding, visibility and the map queries come first, so they share a cache line. */
 struct MAPTILE
 {
+	BASE_OBJECT		*psObject;		// Any object sitting on the location (e.g. building)
+	int32_t                 height;                 ///< The height at the top left of the tile
+	uint16_t		texture;		// Which graphics texture is on this tile
 	uint8_t			tileInfoBits;
+	uint8_t			ground;			///< The ground type used for the terrain renderer
 	PlayerMask              tileExploredBits;
 	PlayerMask              sensorBits;             ///< bit per player, who can see tile with sensor
-	uint8_t			illumination;	// How bright is this tile?
-	uint8_t			watchers[MAX_PLAYERS];		// player sees through fog of war here with this many objects
-	uint16_t		texture;		// Which graphics texture is on this tile
-	int32_t                 height;                 ///< The height at the top left of the tile
-	float                   level;                  ///< The visibility level of the top left of the tile, for this client.
-	BASE_OBJECT		*psObject;		// Any object sitting on the location (e.g. building)
-	PIELIGHT		colour;
+	PlayerMask		jammerBits;             ///< bit per player, who is jamming tile
 	uint16_t		limitedContinent;	///< For land or sea limited propulsion types
 	uint16_t		hoverContinent;		///< For hover type propulsions
-	uint8_t			ground;			///< The ground type used for the terrain renderer
 	uint16_t                fireEndTime;            ///< The (uint16_t)(gameTime / GAME_TICKS_PER_UPDATE) that BITS_ON_FIRE should be cleared.
+	uint8_t			illumination;	// How bright is this tile?
+	float                   level;                  ///< The visibility level of the top left of the tile, for this client.
+	PIELIGHT		colour;
 	int32_t                 waterLevel;             ///< At what height is the water for this tile
-	PlayerMask		jammerBits;             ///< bit per player, who is jamming tile
-	uint8_t                 sensors[MAX_PLAYERS];   ///< player sees this tile with this many radar sensors
-	uint8_t                 jammers[MAX_PLAYERS];   ///< player jams the tile with this many objects
+};
+
+/* Per player vision counters of each tile. Only the visibility code needs them, so they are kept out of MAPTILE. */
+struct MAPTILE_VISION
+{
+	uint8_t			watchers[MAX_PLAYERS];	///< player sees through fog of war here with this many objects
+	uint8_t			sensors[MAX_PLAYERS];	///< player sees this tile with this many radar sensors
+	uint8_t			jammers[MAX_PLAYERS];	///< player jams the tile with this many objects
 };
 
 /* The size and contents of the map */
@@ -444,6 +450,13 @@ static inline WZ_DECL_PURE MAPTILE *mapTile(Vector2i const &v)
 	return mapTile(v.x, v.y);
 }
 
+/** Return a pointer to the vision counters of a tile returned by mapTile().
+ *  The vision layer is allocated directly after psMapTiles, so that code swapping psMapTiles and the map size (see mission.cpp) swaps it too. */
+static inline WZ_DECL_PURE MAPTILE_VISION *mapTileVision(MAPTILE const *psTile)
+{
+	return reinterpret_cast<MAPTILE_VISION *>(psMapTiles + mapWidth * mapHeight) + (psTile - psMapTiles);
+}
+
 /** Return a pointer to the tile structure at x,y in world coordinates */
 static inline WZ_DECL_PURE MAPTILE *worldTile(int32_t x, int32_t y)
 {
@@ -493,6 +506,7 @@ static inline void setTileHeight(int32_t x, int32_t y, int32_t height)
 
 	psMapTiles[x + (y * mapWidth)].height = height;
 	markTileDirty(x, y);
+	visTerrainChanged(x, y);
 }
 
 /* Return whether a tile coordinate is on the map */
@@ -35,6 +35,7 @@
 static PointTree *gridPointTree = nullptr;  // A quad-tree-like object.
 static PointTree::Filter *gridFiltersUnseen;
 static PointTree::Filter *gridFiltersDroidsByPlayer;
+static unsigned gridGeneration = 0;         ///< Incremented by gridReset(), so GridNeighbourhood can tell whether it is out of date.
 
 // initialise the grid system
 bool gridInitialise()
@@ -73,6 +74,7 @@ void gridReset()
 	}
 
 	gridPointTree->sort();
+	gridGeneration = std::max(gridGeneration + 1, 1u);
 
 	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
 	{
@@ -166,6 +168,80 @@ GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius)
 	return gridStartIterateFiltered(x, y, radius, nullptr, ConditionTrue());
 }
 
+void gridQueryConcurrent(GridList &gridList, int32_t x, int32_t y, uint32_t radius)
+{
+	PointTree::ResultVector results;
+	gridPointTree->query(results, x, y, radius);
+	gridList.resize(results.size());
+	for (unsigned n = 0; n < gridList.size(); ++n)
+	{
+		gridList[n] = static_cast<BASE_OBJECT *>(results[n]);
+	}
+}
+
+void gridFilterRadius(GridList &gridList, GridList const &queried, int32_t x, int32_t y, uint32_t radius)
+{
+	// Same test as gridStartIterate, which also looks at the objects' current positions, not the ones in the grid.
+	gridList.clear();
+	for (BASE_OBJECT *obj : queried)
+	{
+		if (isInRadius(obj->pos.x - x, obj->pos.y - y, radius))
+		{
+			gridList.push_back(obj);
+		}
+	}
+}
+
+void GridNeighbourhood::query(int32_t x, int32_t y, uint32_t radius)
+{
+	static_assert(sizeof(void *) == sizeof(BASE_OBJECT *), "Point tree results are stored as object pointers.");
+	PointTree::ResultVector results;
+	PointTree::PositionVector positions;
+	gridPointTree->query(results, positions, x, y, radius);
+
+	centreX = x;
+	centreY = y;
+	queryRadius = radius;
+	generation = gridGeneration;
+	objects.resize(results.size());
+	gridX.resize(results.size());
+	gridY.resize(results.size());
+	for (unsigned n = 0; n < results.size(); ++n)
+	{
+		objects[n] = static_cast<BASE_OBJECT *>(results[n]);
+		gridX[n] = positions[n].first;
+		gridY[n] = positions[n].second;
+	}
+}
+
+bool GridNeighbourhood::covers(int32_t x, int32_t y, uint32_t radius) const
+{
+	return generation == gridGeneration && generation != 0 && x == centreX && y == centreY && radius <= queryRadius;
+}
+
+GridList const &GridNeighbourhood::narrow(int32_t x, int32_t y, uint32_t radius)
+{
+	ASSERT(covers(x, y, radius), "Neighbourhood of (%d, %d, %u) doesn't cover (%d, %d, %u).", centreX, centreY, queryRadius, x, y, radius);
+
+	// Same tests as gridStartIterate: the point tree returns the objects whose grid positions are in the square, in
+	// the order they are sorted in the tree, and those are then filtered by their current distance. The square for a
+	// smaller radius is inside the square for the queried radius, so narrowing gives the same objects in the same order.
+	int32_t minX = x - radius;
+	int32_t maxX = x + radius;
+	int32_t minY = y - radius;
+	int32_t maxY = y + radius;
+	narrowed.clear();
+	for (unsigned n = 0; n < objects.size(); ++n)
+	{
+		BASE_OBJECT *obj = objects[n];
+		if (gridX[n] >= minX && gridX[n] <= maxX && gridY[n] >= minY && gridY[n] <= maxY && isInRadius(obj->pos.x - x, obj->pos.y - y, radius))
+		{
+			narrowed.push_back(obj);
+		}
+	}
+	return narrowed;
+}
+
 GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
 {
 	return gridStartIterateFilteredArea(x, y, x2, y2, ConditionTrue());
@@ -40,6 +40,34 @@ void gridReset();
 /// Find all objects within radius.
 GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius);
 
+/// Find all objects whose grid positions are in the square around (x, y), writing them to gridList, without checking their
+/// current distance yet, since they may move before the result is used. gridFilterRadius() then gives what gridStartIterate() would.
+/// Doesn't touch any shared state, so may be called from several threads at once, as long as gridReset() isn't called meanwhile.
+void gridQueryConcurrent(GridList &gridList, int32_t x, int32_t y, uint32_t radius);
+/// Writes the objects of a gridQueryConcurrent() result which are currently within radius of (x, y) to gridList.
+void gridFilterRadius(GridList &gridList, GridList const &queried, int32_t x, int32_t y, uint32_t radius);
+
+/// Objects found by a single grid query, which can then be narrowed to any smaller radius around the same point without querying the grid again.
+/// Only valid until the next gridReset().
+class GridNeighbourhood
+{
+public:
+	/// Finds the objects within radius of (x, y). Doesn't touch any shared state, like gridQueryConcurrent().
+	void query(int32_t x, int32_t y, uint32_t radius);
+	/// True if narrow(x, y, radius) can be used, because the grid hasn't been reset since query() was called with the same point and at least the same radius.
+	bool covers(int32_t x, int32_t y, uint32_t radius) const;
+	/// Returns exactly the objects gridStartIterate(x, y, radius) would, in the same order. Requires covers(x, y, radius).
+	GridList const &narrow(int32_t x, int32_t y, uint32_t radius);
+
+private:
+	int32_t centreX = 0, centreY = 0;
+	uint32_t queryRadius = 0;
+	unsigned generation = 0;           ///< Value of the grid generation when queried, 0 if never queried.
+	GridList objects;                  ///< Objects in the queried square, by position when the grid was reset.
+	std::vector<int32_t> gridX, gridY; ///< Positions of objects when the grid was reset, which is what the square is tested against.
+	GridList narrowed;
+};
+
 /// Find all objects within radius.
 GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2);
 
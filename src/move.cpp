@@ -587,6 +587,20 @@ static SDWORD moveObjRadius(const BASE_OBJECT *psObj)
 }
 
 
+/// Objects near the droid being moved, shared by moveGetObstacleVector, moveCheckSquished and moveCalcDroidSlide,
+/// so the grid is only searched once per droid per tick.
+static GridNeighbourhood moveNeighbourhood;
+
+/// Returns exactly what gridStartIterate(psDroid->pos.x, psDroid->pos.y, radius) would.
+static GridList const &moveGetNeighbours(DROID *psDroid, uint32_t radius)
+{
+	if (!moveNeighbourhood.covers(psDroid->pos.x, psDroid->pos.y, radius))
+	{
+		moveNeighbourhood.query(psDroid->pos.x, psDroid->pos.y, std::max<uint32_t>(radius, OBJ_MAXRADIUS));
+	}
+	return moveNeighbourhood.narrow(psDroid->pos.x, psDroid->pos.y, radius);
+}
+
 // see if a Droid has run over a person
 static void moveCheckSquished(DROID *psDroid, int32_t emx, int32_t emy)
 {
@@ -596,7 +610,7 @@ static void moveCheckSquished(DROID *psDroid, int32_t emx, int32_t emy)
 	const int32_t   my = gameTimeAdjustedAverage(emy, EXTRA_PRECISION);
 
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, OBJ_MAXRADIUS);
+	gridList = moveGetNeighbours(psDroid, OBJ_MAXRADIUS);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psObj = *gi;
@@ -1039,7 +1053,7 @@ static void moveCalcDroidSlide(DROID *psDroid, int *pmx, int *pmy)
 	droidR = moveObjRadius((BASE_OBJECT *)psDroid);
 	BASE_OBJECT *psObst = nullptr;
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, OBJ_MAXRADIUS);
+	gridList = moveGetNeighbours(psDroid, OBJ_MAXRADIUS);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psObj = *gi;
@@ -1155,7 +1169,7 @@ static Vector2i moveGetObstacleVector(DROID *psDroid, Vector2i dest)
 
 	// scan the neighbours for obstacles
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, AVOID_DIST);
+	gridList = moveGetNeighbours(psDroid, AVOID_DIST);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		if (*gi == psDroid)
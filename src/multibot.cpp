@@ -176,6 +176,68 @@ struct QueuedDroidInfo
 
 static std::vector<QueuedDroidInfo> queuedOrders;
 
+#define DROID_SET_CACHE_SIZE 16  ///< Number of droid selections each player's game queue remembers.
+#define DROID_SET_MIN_CACHED 4   ///< Smaller selections are cheaper to send again than to remember.
+#define DROIDINFO_MAX_BYTES (MaxMsgSize / 2)  ///< GAME_DROIDINFO messages are kept below this, orders which don't fit go in the next one.
+#define DROIDINFO_ORDER_BYTES 64                ///< More than an order, its selection reference and droid count can encode to.
+#define DROIDINFO_ID_BYTES 5                    ///< Most an encoded droid ID delta can take.
+
+/// The droid selections most recently given orders, most recently used first. The sender and every receiver of a
+/// game queue update their copies in the same order, so an order can refer to a selection by its position instead
+/// of listing all the droid IDs again, which is what happens when a large army is ordered around repeatedly.
+class DroidSetCache
+{
+public:
+	void clear()
+	{
+		sets.clear();
+	}
+
+	size_t size() const
+	{
+		return sets.size();
+	}
+
+	/// Returns the position of the selection, or -1 if it isn't remembered.
+	int find(std::vector<uint32_t> const &ids) const
+	{
+		for (unsigned n = 0; n < sets.size(); ++n)
+		{
+			if (sets[n] == ids)
+			{
+				return n;
+			}
+		}
+		return -1;
+	}
+
+	/// Moves the selection at the given position to the front, and returns it.
+	std::vector<uint32_t> const &use(unsigned index)
+	{
+		std::rotate(sets.begin(), sets.begin() + index, sets.begin() + index + 1);
+		return sets.front();
+	}
+
+	void add(std::vector<uint32_t> const &ids)
+	{
+		if (ids.size() < DROID_SET_MIN_CACHED)
+		{
+			return;
+		}
+		if (sets.size() >= DROID_SET_CACHE_SIZE)
+		{
+			sets.pop_back();
+		}
+		sets.insert(sets.begin(), ids);
+	}
+
+private:
+	std::vector<std::vector<uint32_t>> sets;
+};
+
+static DroidSetCache sentDroidSets;                   ///< What the receivers of our game queue remember.
+static DroidSetCache receivedDroidSets[MAX_PLAYERS];  ///< What each player's game queue told us to remember.
+
 
 // ////////////////////////////////////////////////////////////////////////////
 // Local Prototypes
@@ -489,7 +551,10 @@ static void NETQueuedDroidInfo(QueuedDroidInfo *info)
 		}
 		if (info->order == DORDER_LINEBUILD)
 		{
-			NETauto(&info->pos2);
+			// Lines are short, so the end relative to the start encodes to less bytes.
+			Vector2i delta = info->pos2 - info->pos;
+			NETauto(&delta);
+			info->pos2 = info->pos + delta;
 		}
 		if (info->order == DORDER_BUILDMODULE)
 		{
@@ -507,32 +572,85 @@ static void NETQueuedDroidInfo(QueuedDroidInfo *info)
 // Actually send the droid info.
 void sendQueuedDroidInfo()
 {
+	if (queuedOrders.empty())
+	{
+		return;
+	}
+
 	// Sort queued orders, to group the same order to multiple droids.
 	std::sort(queuedOrders.begin(), queuedOrders.end());
 
-	std::vector<QueuedDroidInfo>::iterator eqBegin, eqEnd;
-	for (eqBegin = queuedOrders.begin(); eqBegin != queuedOrders.end(); eqBegin = eqEnd)
+	// Find the ranges of orders which differ only by the droid ID.
+	std::vector<std::vector<QueuedDroidInfo>::iterator> groupBegins;
+	for (auto eq = queuedOrders.begin(); eq != queuedOrders.end(); ++eq)
 	{
-		// Find end of range of orders which differ only by the droid ID.
-		for (eqEnd = eqBegin + 1; eqEnd != queuedOrders.end() && eqEnd->orderCompare(*eqBegin) == 0; ++eqEnd)
-		{}
+		if (groupBegins.empty() || eq->orderCompare(*groupBegins.back()) != 0)
+		{
+			groupBegins.push_back(eq);
+		}
+	}
+	groupBegins.push_back(queuedOrders.end());
 
-		NETbeginEncode(NETgameQueue(selectedPlayer), GAME_DROIDINFO);
-		NETQueuedDroidInfo(&*eqBegin);
+	// Split up selections too big to fit in a message.
+	const size_t maxGroupDroids = (DROIDINFO_MAX_BYTES - DROIDINFO_ORDER_BYTES) / DROIDINFO_ID_BYTES;
+	std::vector<std::pair<QueuedDroidInfo *, std::vector<uint32_t>>> groups;
+	for (unsigned group = 0; group + 1 < groupBegins.size(); ++group)
+	{
+		for (auto eq = groupBegins[group]; eq != groupBegins[group + 1]; ++eq)
+		{
+			if (eq == groupBegins[group] || groups.back().second.size() >= maxGroupDroids)
+			{
+				groups.emplace_back(&*eq, std::vector<uint32_t>());
+			}
+			groups.back().second.push_back(eq->droidId);
+		}
+	}
 
-		uint32_t num = eqEnd - eqBegin;
-		NETuint32_t(&num);
+	// Send all the orders given since the last call in as few messages as fit them, rather than one message per group.
+	for (size_t groupsBegin = 0, groupsEnd = 0; groupsBegin < groups.size(); groupsBegin = groupsEnd)
+	{
+		size_t maxBytes = 0;
+		for (groupsEnd = groupsBegin; groupsEnd < groups.size(); ++groupsEnd)
+		{
+			size_t groupBytes = DROIDINFO_ORDER_BYTES + groups[groupsEnd].second.size() * DROIDINFO_ID_BYTES;
+			if (groupsEnd > groupsBegin && maxBytes + groupBytes > DROIDINFO_MAX_BYTES)
+			{
+				break;
+			}
+			maxBytes += groupBytes;
+		}
 
-		uint32_t prevDroidId = 0;
-		for (unsigned n = 0; n < num; ++n)
+		NETbeginEncode(NETgameQueue(selectedPlayer), GAME_DROIDINFO);
+		uint32_t numGroups = groupsEnd - groupsBegin;
+		NETuint32_t(&numGroups);
+		for (size_t group = groupsBegin; group < groupsEnd; ++group)
 		{
-			uint32_t droidId = (eqBegin + n)->droidId;
+			NETQueuedDroidInfo(groups[group].first);
+			std::vector<uint32_t> const &droidIds = groups[group].second;
+
+			// 0 means the droid IDs follow, otherwise refers to a selection sent before.
+			int setIndex = sentDroidSets.find(droidIds);
+			uint32_t setRef = setIndex + 1;
+			NETuint32_t(&setRef);
+			if (setIndex >= 0)
+			{
+				sentDroidSets.use(setIndex);
+				continue;
+			}
 
-			// Encode deltas between droid IDs, since the deltas are smaller than the actual droid IDs, and will encode to less bytes on average.
-			uint32_t deltaDroidId = droidId - prevDroidId;
-			NETuint32_t(&deltaDroidId);
+			uint32_t num = droidIds.size();
+			NETuint32_t(&num);
+
+			uint32_t prevDroidId = 0;
+			for (uint32_t droidId : droidIds)
+			{
+				// Encode deltas between droid IDs, since the deltas are smaller than the actual droid IDs, and will encode to less bytes on average.
+				uint32_t deltaDroidId = droidId - prevDroidId;
+				NETuint32_t(&deltaDroidId);
 
-			prevDroidId = droidId;
+				prevDroidId = droidId;
+			}
+			sentDroidSets.add(droidIds);
 		}
 		NETend();
 	}
@@ -541,6 +659,16 @@ void sendQueuedDroidInfo()
 	queuedOrders.clear();
 }
 
+void resetQueuedDroidInfo()
+{
+	queuedOrders.clear();
+	sentDroidSets.clear();
+	for (auto &sets : receivedDroidSets)
+	{
+		sets.clear();
+	}
+}
+
 DROID_ORDER_DATA infoToOrderData(QueuedDroidInfo const &info, STRUCTURE_STATS const *psStats)
 {
 	DROID_ORDER_DATA sOrder;
@@ -613,13 +741,69 @@ void sendDroidInfo(DROID *psDroid, DroidOrder const &order, bool add)
 
 // ////////////////////////////////////////////////////////////////////////////
 // receive droid information form other players.
+
+/// Finds the droids with the given sorted IDs in one pass over the player's droid list, instead of one pass per droid.
+static std::vector<DROID *> droidIdsToDroids(std::vector<uint32_t> const &ids, unsigned player)
+{
+	std::vector<DROID *> droids(ids.size(), nullptr);
+	if (player >= MAX_PLAYERS)
+	{
+		return droids;
+	}
+	for (DROID *psDroid = apsDroidLists[player]; psDroid != nullptr; psDroid = psDroid->psNext)
+	{
+		// The same droid may have been given the same order twice, so fill in all the matching IDs.
+		auto range = std::equal_range(ids.begin(), ids.end(), psDroid->id);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			droids[it - ids.begin()] = psDroid;
+		}
+	}
+	return droids;
+}
+
 bool recvDroidInfo(NETQUEUE queue)
 {
+	DroidSetCache &droidSets = receivedDroidSets[queue.index];
+
 	NETbeginDecode(queue, GAME_DROIDINFO);
+	uint32_t numGroups = 0;
+	NETuint32_t(&numGroups);
+	for (unsigned group = 0; group < numGroups; ++group)
 	{
 		QueuedDroidInfo info;
 		NETQueuedDroidInfo(&info);
 
+		uint32_t setRef = 0;
+		NETuint32_t(&setRef);
+		std::vector<uint32_t> droidIds;
+		if (setRef == 0)
+		{
+			uint32_t num = 0;
+			NETuint32_t(&num);
+
+			uint32_t droidId = 0;
+			for (unsigned n = 0; n < num; ++n)
+			{
+				// Get the next droid ID which is being given this order.
+				uint32_t deltaDroidId = 0;
+				NETuint32_t(&deltaDroidId);
+				droidId += deltaDroidId;
+				droidIds.push_back(droidId);
+			}
+			droidSets.add(droidIds);
+		}
+		else if (setRef <= droidSets.size())
+		{
+			droidIds = droidSets.use(setRef - 1);
+		}
+		else
+		{
+			debug(LOG_ERROR, "Packet from %d refers to unknown droid selection %u.", queue.index, setRef);
+			syncDebug("Unknown selection %u", setRef);
+			break;  // Can't make sense of the rest of the message.
+		}
+
 		STRUCTURE_STATS *psStats = nullptr;
 		if (info.subType == LocOrder && (info.order == DORDER_BUILD || info.order == DORDER_LINEBUILD))
 		{
@@ -643,17 +827,12 @@ bool recvDroidInfo(NETQUEUE queue)
 
 		DROID_ORDER_DATA sOrder = infoToOrderData(info, psStats);
 
-		uint32_t num = 0;
-		NETuint32_t(&num);
-
-		for (unsigned n = 0; n < num; ++n)
+		std::vector<DROID *> droids = droidIdsToDroids(droidIds, info.player);
+		for (unsigned n = 0; n < droidIds.size(); ++n)
 		{
-			// Get the next droid ID which is being given this order.
-			uint32_t deltaDroidId = 0;
-			NETuint32_t(&deltaDroidId);
-			info.droidId += deltaDroidId;
+			info.droidId = droidIds[n];
 
-			DROID *psDroid = IdToDroid(info.droidId, info.player);
+			DROID *psDroid = droids[n];
 			if (!psDroid)
 			{
 				debug(LOG_NEVER, "Packet from %d refers to non-existent droid %u, [%s : p%d]",
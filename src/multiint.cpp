@@ -58,6 +58,7 @@
 
 #include "lib/gamelib/gtime.h"
 #include "lib/netplay/netplay.h"
+#include "lib/netplay/netreplay.h"
 #include "lib/script/script.h"
 #include "lib/widget/editbox.h"
 #include "lib/widget/button.h"
@@ -95,6 +96,7 @@
 #include "random.h"
 
 #include "multiplay.h"
+#include "multireplay.h"
 #include "multiint.h"
 #include "multijoin.h"
 #include "multistat.h"
@@ -450,7 +452,8 @@ void loadMultiScripts()
 		}
 		// The i == selectedPlayer hack is to enable autogames
 		if (bMultiPlayer && game.type == SKIRMISH && (!NetPlay.players[i].allocated || i == selectedPlayer)
-		    && (NetPlay.players[i].ai >= 0 || hostlaunch == 2) && myResponsibility(i))
+		    && (NetPlay.players[i].ai >= 0 || hostlaunch == 2) && myResponsibility(i)
+		    && !NETisReplay())  // When playing back a replay, the AI decisions are in the recorded messages.
 		{
 			if (PHYSFS_exists(ininame.toUtf8().c_str())) // challenge file may override AI
 			{
@@ -487,7 +490,7 @@ void loadMultiScripts()
 	}
 
 	// Load scavengers
-	if (game.scavengers && myResponsibility(scavengerPlayer()))
+	if (game.scavengers && myResponsibility(scavengerPlayer()) && !NETisReplay())
 	{
 		debug(LOG_SAVE, "Loading scavenger AI for player %d", scavengerPlayer());
 		loadPlayerScript("multiplay/script/scavfact.js", scavengerPlayer(), DIFFICULTY_EASY);
@@ -4164,6 +4167,19 @@ bool startMultiOptions(bool bReenter)
 		}
 	}
 
+	if (hostlaunch == 3 && !bReenter)
+	{
+		processMultiopWidgets(MULTIOP_HOST);
+		if (!multiReplayLoadStart(wz_replay_file()))
+		{
+			debug(LOG_ERROR, "Failed to load replay %s", wz_replay_file().c_str());
+			hostlaunch = 0;
+			return true;  // Stay in the lobby.
+		}
+		startMultiplayerGame();
+		multiReplayLoadAfterStart();
+	}
+
 	return true;
 }
 
@@ -1685,12 +1685,14 @@ void sendMap()
 		{
 			int done = 0;
 			file_startTime = std::chrono::high_resolution_clock::now();
+			uint32_t prevPos;
 			do
 			{
+				prevPos = file.pos;
 				done = NETsendFile(file, i);
 				file_currentDuration = std::chrono::duration_cast<microDuration>(std::chrono::high_resolution_clock::now() - file_startTime);
 			}
-			while (done < 100 && (file_currentDuration.count() < maxMicroSecondsPerFile));
+			while (done < 100 && file.pos != prevPos && (file_currentDuration.count() < maxMicroSecondsPerFile));  // Stop early if the player's connection is backed up.
 			if (done == 100)
 			{
 				netPlayersUpdated = true;  // Remove download icon from player.
@@ -0,0 +1,212 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Game settings stored in replays.
+ *
+ *  These are the options the host sends in NET_OPTIONS, the players and the random seed from NET_FIREUP, which
+ *  together with the recorded game messages determine everything that happens in the game.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/netplay/netplay.h"
+#include "lib/netplay/netreplay.h"
+
+#include "multireplay.h"
+#include "ai.h"
+#include "component.h"
+#include "levels.h"
+#include "multiplay.h"
+#include "random.h"
+#include "version.h"
+
+static uint32_t replaySeed = 0;
+static std::vector<MULTISTRUCTLIMITS> replayLimits;
+static uint8_t replayLimitFlags = 0;
+
+bool multiReplaySaveStart()
+{
+	if (NETisReplay())
+	{
+		return false;  // Don't record a replay of a replay.
+	}
+
+	nlohmann::json settings = nlohmann::json::object();
+	settings["version"] = version_getVersionString();
+	settings["randomSeed"] = gameRandSeed();
+	settings["selectedPlayer"] = selectedPlayer;
+
+	nlohmann::json gameSettings = nlohmann::json::object();
+	gameSettings["type"] = game.type;
+	gameSettings["map"] = game.map;
+	gameSettings["hash"] = game.hash.toString();
+	gameSettings["maxPlayers"] = game.maxPlayers;
+	gameSettings["name"] = game.name;
+	gameSettings["power"] = game.power;
+	gameSettings["base"] = game.base;
+	gameSettings["alliance"] = game.alliance;
+	gameSettings["scavengers"] = game.scavengers;
+	gameSettings["isMapMod"] = game.isMapMod;
+	gameSettings["techLevel"] = game.techLevel;
+	nlohmann::json skDiff = nlohmann::json::array();
+	for (unsigned i = 0; i < MAX_PLAYERS; ++i)
+	{
+		skDiff.push_back(game.skDiff[i]);
+	}
+	gameSettings["skDiff"] = skDiff;
+	settings["game"] = gameSettings;
+
+	nlohmann::json players = nlohmann::json::array();
+	for (unsigned i = 0; i < MAX_PLAYERS; ++i)
+	{
+		PLAYER const &p = NetPlay.players[i];
+		nlohmann::json player = nlohmann::json::object();
+		player["name"] = p.name;
+		player["position"] = p.position;
+		player["colour"] = p.colour;
+		player["team"] = p.team;
+		player["ai"] = p.ai;
+		player["difficulty"] = p.difficulty;
+		player["allocated"] = p.allocated;
+		players.push_back(player);
+	}
+	settings["players"] = players;
+
+	nlohmann::json allianceRows = nlohmann::json::array();
+	for (unsigned i = 0; i < MAX_PLAYER_SLOTS; ++i)
+	{
+		nlohmann::json row = nlohmann::json::array();
+		for (unsigned j = 0; j < MAX_PLAYER_SLOTS; ++j)
+		{
+			row.push_back(alliances[i][j]);
+		}
+		allianceRows.push_back(row);
+	}
+	settings["alliances"] = allianceRows;
+
+	nlohmann::json limits = nlohmann::json::array();
+	for (unsigned i = 0; i < ingame.numStructureLimits; ++i)
+	{
+		limits.push_back({ingame.pStructureLimits[i].id, ingame.pStructureLimits[i].limit});
+	}
+	settings["structureLimits"] = limits;
+	settings["limitFlags"] = ingame.flags;
+
+	return NETreplaySaveStart(settings);
+}
+
+bool multiReplaySaveStop()
+{
+	return NETreplaySaveStop();
+}
+
+bool multiReplayLoadStart(const std::string &filename)
+{
+	nlohmann::json settings;
+	if (!NETreplayLoadStart(filename, settings))
+	{
+		return false;
+	}
+
+	try
+	{
+		debug(LOG_INFO, "Replay %s was recorded with version %s.", filename.c_str(), settings.at("version").get<std::string>().c_str());
+
+		nlohmann::json const &gameSettings = settings.at("game");
+		game.type = gameSettings.at("type").get<uint8_t>();
+		sstrcpy(game.map, gameSettings.at("map").get<std::string>().c_str());
+		game.hash.fromString(gameSettings.at("hash").get<std::string>());
+		game.maxPlayers = gameSettings.at("maxPlayers").get<uint8_t>();
+		sstrcpy(game.name, gameSettings.at("name").get<std::string>().c_str());
+		game.power = gameSettings.at("power").get<uint32_t>();
+		game.base = gameSettings.at("base").get<uint8_t>();
+		game.alliance = gameSettings.at("alliance").get<uint8_t>();
+		game.scavengers = gameSettings.at("scavengers").get<bool>();
+		game.isMapMod = gameSettings.at("isMapMod").get<bool>();
+		game.techLevel = gameSettings.at("techLevel").get<uint32_t>();
+		for (unsigned i = 0; i < MAX_PLAYERS; ++i)
+		{
+			game.skDiff[i] = gameSettings.at("skDiff").at(i).get<uint8_t>();
+		}
+
+		for (unsigned i = 0; i < MAX_PLAYERS; ++i)
+		{
+			nlohmann::json const &player = settings.at("players").at(i);
+			PLAYER &p = NetPlay.players[i];
+			sstrcpy(p.name, player.at("name").get<std::string>().c_str());
+			p.position = player.at("position").get<int32_t>();
+			setPlayerColour(i, player.at("colour").get<int32_t>());
+			p.team = player.at("team").get<int32_t>();
+			p.ai = player.at("ai").get<int8_t>();
+			p.difficulty = player.at("difficulty").get<int8_t>();
+			p.allocated = player.at("allocated").get<bool>();
+		}
+
+		for (unsigned i = 0; i < MAX_PLAYER_SLOTS; ++i)
+		{
+			for (unsigned j = 0; j < MAX_PLAYER_SLOTS; ++j)
+			{
+				alliances[i][j] = settings.at("alliances").at(i).at(j).get<uint8_t>();
+			}
+		}
+
+		replayLimits.clear();
+		for (auto const &limit : settings.at("structureLimits"))
+		{
+			replayLimits.push_back({limit.at(0).get<uint32_t>(), limit.at(1).get<uint32_t>()});
+		}
+		replayLimitFlags = settings.at("limitFlags").get<uint8_t>();
+		replaySeed = settings.at("randomSeed").get<uint32_t>();
+		selectedPlayer = realSelectedPlayer = settings.at("selectedPlayer").get<uint32_t>();
+	}
+	catch (const std::exception &e)
+	{
+		debug(LOG_ERROR, "Replay %s has bad settings: %s", filename.c_str(), e.what());
+		NETreplayLoadStop();
+		return false;
+	}
+
+	if (levFindDataSet(game.map, &game.hash) == nullptr)
+	{
+		debug(LOG_ERROR, "Replay %s needs map %s with hash %s, which we don't have.", filename.c_str(), game.map, game.hash.toString().c_str());
+		NETreplayLoadStop();
+		return false;
+	}
+
+	return true;
+}
+
+void multiReplayLoadAfterStart()
+{
+	gameSRand(replaySeed);
+
+	free(ingame.pStructureLimits);
+	ingame.pStructureLimits = nullptr;
+	ingame.numStructureLimits = replayLimits.size();
+	if (!replayLimits.empty())
+	{
+		ingame.pStructureLimits = (MULTISTRUCTLIMITS *)malloc(replayLimits.size() * sizeof(MULTISTRUCTLIMITS));
+		memcpy(ingame.pStructureLimits, &replayLimits[0], replayLimits.size() * sizeof(MULTISTRUCTLIMITS));
+	}
+	ingame.flags = replayLimitFlags;
+}
+
+bool multiReplayLoadStop()
+{
+	return NETreplayLoadStop();
+}
@@ -0,0 +1,40 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Game settings stored in replays, see lib/netplay/netreplay.h.
+ */
+
+#ifndef __INCLUDED_SRC_MULTIREPLAY_H__
+#define __INCLUDED_SRC_MULTIREPLAY_H__
+
+#include <string>
+
+/// Starts recording the game which is being started, unless playing back a replay.
+bool multiReplaySaveStart();
+/// Finishes recording the game, if recording.
+bool multiReplaySaveStop();
+
+/// Opens a replay for playback, and sets up the game options and players it was recorded with.
+bool multiReplayLoadStart(const std::string &filename);
+/// Restores the things startMultiplayerGame() picks afresh, which are the random seed and the structure limits.
+void multiReplayLoadAfterStart();
+/// Stops playback, if playing back.
+bool multiReplayLoadStop();
+
+#endif // __INCLUDED_SRC_MULTIREPLAY_H__
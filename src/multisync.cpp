@@ -225,6 +225,7 @@ bool recvPing(NETQUEUE queue)
 
 		// Work out how long it took them to respond
 		ingame.PingTimes[sender] = (realTime - PingSend[sender]) / 2;
+		recordPlayerRoundTrip(sender, realTime - PingSend[sender]);
 
 		// Note that we have received it
 		PingSend[sender] = 0;
@@ -50,6 +50,18 @@ static uint64_t expand(uint32_t x)
 	return r;
 }
 
+// Inverse of expand, takes bit pattern ?a?b ?c?d ?e?f ?g?h to abcd efgh
+static uint32_t compact(uint64_t r)
+{
+	r &= 0x5555555555555555ULL;
+	r = (r | r >> 1)  & 0x3333333333333333ULL;
+	r = (r | r >> 2)  & 0x0F0F0F0F0F0F0F0FULL;
+	r = (r | r >> 4)  & 0x00FF00FF00FF00FFULL;
+	r = (r | r >> 8)  & 0x0000FFFF0000FFFFULL;
+	r = (r | r >> 16) & 0x00000000FFFFFFFFULL;
+	return r;
+}
+
 // Returns v with highest set bit and all higher bits set, and all following bits 0. Example: 0000 0110 1001 1100 -> 1111 1100 0000 0000.
 static uint32_t findSplit(uint32_t v)
 {
@@ -61,16 +73,30 @@ static uint32_t findSplit(uint32_t v)
 	return ~(v >> 1);
 }
 
+// Spreads x over the odd bits, after adding 0x80000000u to make its range unsigned.
 static uint64_t expandX(int32_t x)
 {
 	return expand(x + 0x80000000u) << 1;
 }
 
+// Spreads y over the even bits, after adding 0x80000000u to make its range unsigned.
 static uint64_t expandY(int32_t y)
 {
 	return expand(y + 0x80000000u);
 }
 
+// Inverse of expandX, extracts x from the odd bits.
+static int32_t compactX(uint64_t r)
+{
+	return compact(r >> 1) - 0x80000000u;
+}
+
+// Inverse of expandY, extracts y from the even bits.
+static int32_t compactY(uint64_t r)
+{
+	return compact(r) - 0x80000000u;
+}
+
 // Interleaves x and y, but after adding 0x80000000u to both, to make their ranges unsigned.
 static uint64_t interleave(int32_t x, int32_t y)
 {
@@ -129,7 +155,7 @@ static unsigned current(std::vector<unsigned> &filterData, unsigned i)
 }
 
 template<bool IsFiltered>
-PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo)
+void PointTree::queryMaybeFilter(Filter &filter, ResultVector &results, IndexVector *indices, PositionVector *positions, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo) const
 {
 	uint64_t minX = expandX(minXo);
 	uint64_t maxX = expandX(maxXo);
@@ -225,10 +251,14 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 		--numRanges;
 	}
 
-	lastQueryResults.clear();
+	results.clear();
 	if (IsFiltered)
 	{
-		lastFilteredQueryIndices.clear();
+		indices->clear();
+	}
+	if (positions != nullptr)
+	{
+		positions->clear();
 	}
 	for (int r = 0; r != numRanges; ++r)
 	{
@@ -242,10 +272,14 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 			uint64_t py = points[i].first & 0x5555555555555555ULL;
 			if (px >= minX && px <= maxX && py >= minY && py <= maxY)  // Only add point if it's at least in the desired square.
 			{
-				lastQueryResults.push_back(points[i].second);
+				results.push_back(points[i].second);
 				if (IsFiltered)
 				{
-					lastFilteredQueryIndices.push_back(i);
+					indices->push_back(i);
+				}
+				if (positions != nullptr)
+				{
+					positions->emplace_back(compactX(points[i].first), compactY(points[i].first));
 				}
 #ifdef DUMP_IMAGE
 				if (doDump)
@@ -266,14 +300,13 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 		fclose(f);
 	}
 #endif //DUMP_IMAGE
-
-	return lastQueryResults;
 }
 
 PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
 {
 	Filter unused;
-	return queryMaybeFilter<false>(unused, x, y, x2, y2);
+	queryMaybeFilter<false>(unused, lastQueryResults, nullptr, nullptr, x, y, x2, y2);
+	return lastQueryResults;
 }
 
 PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t radius)
@@ -283,7 +316,18 @@ PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t radius)
 	int32_t maxXo = x + radius;
 	int32_t minYo = y - radius;
 	int32_t maxYo = y + radius;
-	return queryMaybeFilter<false>(unused, minXo, minYo, maxXo, maxYo);
+	queryMaybeFilter<false>(unused, lastQueryResults, nullptr, nullptr, minXo, minYo, maxXo, maxYo);
+	return lastQueryResults;
+}
+
+void PointTree::query(ResultVector &results, int32_t x, int32_t y, uint32_t radius) const
+{
+	Filter unused;
+	int32_t minXo = x - radius;
+	int32_t maxXo = x + radius;
+	int32_t minYo = y - radius;
+	int32_t maxYo = y + radius;
+	queryMaybeFilter<false>(unused, results, nullptr, nullptr, minXo, minYo, maxXo, maxYo);
 }
 
 PointTree::ResultVector &PointTree::query(Filter &filter, int32_t x, int32_t y, uint32_t radius)
@@ -292,5 +336,16 @@ PointTree::ResultVector &PointTree::query(Filter &filter, int32_t x, int32_t y,
 	int32_t maxXo = x + radius;
 	int32_t minYo = y - radius;
 	int32_t maxYo = y + radius;
-	return queryMaybeFilter<true>(filter, minXo, minYo, maxXo, maxYo);
+	queryMaybeFilter<true>(filter, lastQueryResults, &lastFilteredQueryIndices, nullptr, minXo, minYo, maxXo, maxYo);
+	return lastQueryResults;
+}
+
+void PointTree::query(ResultVector &results, PositionVector &positions, int32_t x, int32_t y, uint32_t radius) const
+{
+	Filter unused;
+	int32_t minXo = x - radius;
+	int32_t maxXo = x + radius;
+	int32_t minYo = y - radius;
+	int32_t maxYo = y + radius;
+	queryMaybeFilter<false>(unused, results, nullptr, &positions, minXo, minYo, maxXo, maxYo);
 }
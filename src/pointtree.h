@@ -30,6 +30,7 @@ class PointTree
 public:
 	typedef std::vector<void *> ResultVector;
 	typedef std::vector<unsigned> IndexVector;
+	typedef std::vector<std::pair<int32_t, int32_t>> PositionVector;
 	class Filter  ///< Filters are invalidated when modifying the PointTree.
 	{
 	public:
@@ -65,6 +66,12 @@ public:
 	ResultVector &query(Filter &filter, int32_t x, int32_t y, uint32_t radius);
 	/// Returns all points which have not been filtered away within given rectangle. See function above on thread safety.
 	ResultVector &query(int32_t x, int32_t y, uint32_t x2, uint32_t y2);
+	/// Same as query(x, y, radius), but writes the points to results instead of lastQueryResults.
+	/// Thread safe, as long as the PointTree isn't modified at the same time.
+	void query(ResultVector &results, int32_t x, int32_t y, uint32_t radius) const;
+	/// Same as query(results, x, y, radius), but also writes the positions the points were inserted at to positions.
+	/// Thread safe, as long as the PointTree isn't modified at the same time.
+	void query(ResultVector &results, PositionVector &positions, int32_t x, int32_t y, uint32_t radius) const;
 
 	ResultVector lastQueryResults;
 	IndexVector lastFilteredQueryIndices;
@@ -74,7 +81,7 @@ private:
 	typedef std::vector<Point> Vector;
 
 	template<bool IsFiltered>
-	ResultVector &queryMaybeFilter(Filter &filter, int32_t minXo, int32_t maxXo, int32_t minYo, int32_t maxYo);
+	void queryMaybeFilter(Filter &filter, ResultVector &results, IndexVector *indices, PositionVector *positions, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo) const;
 
 	Vector points;
 };
@@ -59,6 +59,8 @@
 
 #include <algorithm>
 #include <functional>
+#include <memory>
+#include <type_traits>
 #ifndef GLM_ENABLE_EXPERIMENTAL
 	#define GLM_ENABLE_EXPERIMENTAL
 #endif
@@ -82,8 +84,94 @@ struct INTERVAL
 // used to create a specific ID for projectile objects to facilitate tracking them.
 static const UDWORD ProjectileTrackerID =	0xdead0000;
 
-/* The list of projectiles in play */
-static std::vector<PROJECTILE *> psProjectileList;
+/* Number of projectiles in each slab of the projectile pool */
+#define PROJECTILE_SLAB_SIZE 256
+
+/**
+ * Slab allocator for projectiles.
+ * Slabs are never moved or freed while the pool is in use, so PROJECTILE pointers stay valid until
+ * the projectile itself is freed. Freed slots are reused most-recently-freed first, which keeps the
+ * live projectiles packed into a few warm slabs instead of scattered over the heap.
+ */
+class ProjectilePool
+{
+public:
+	PROJECTILE *alloc(uint32_t id, unsigned player)
+	{
+		if (freeSlots.empty())
+		{
+			uint32_t base = static_cast<uint32_t>(slabs.size()) * PROJECTILE_SLAB_SIZE;
+			slabs.emplace_back(new Slot[PROJECTILE_SLAB_SIZE]);
+			for (uint32_t i = PROJECTILE_SLAB_SIZE; i-- > 0;)
+			{
+				freeSlots.push_back(base + i);
+			}
+		}
+		uint32_t index = freeSlots.back();
+		freeSlots.pop_back();
+
+		Slot &slot = slotAt(index);
+		PROJECTILE *psProj = new (&slot.storage) PROJECTILE(id, player);
+		slot.used = true;
+		psProj->poolIndex = index;
+		return psProj;
+	}
+
+	void free(uint32_t index)
+	{
+		Slot &slot = slotAt(index);
+		ASSERT_OR_RETURN(, slot.used, "Freeing unused projectile slot %u", index);
+		object(slot)->~PROJECTILE();
+		slot.used = false;
+		freeSlots.push_back(index);
+	}
+
+	/// Free all projectiles, keeping the slabs for the next game.
+	void clear()
+	{
+		freeSlots.clear();
+		for (uint32_t index = static_cast<uint32_t>(slabs.size()) * PROJECTILE_SLAB_SIZE; index-- > 0;)
+		{
+			Slot &slot = slotAt(index);
+			if (slot.used)
+			{
+				object(slot)->~PROJECTILE();
+				slot.used = false;
+			}
+			freeSlots.push_back(index);
+		}
+	}
+
+	PROJECTILE *at(uint32_t index)
+	{
+		return object(slotAt(index));
+	}
+
+private:
+	struct Slot
+	{
+		std::aligned_storage<sizeof(PROJECTILE), alignof(PROJECTILE)>::type storage;
+		bool used = false;
+	};
+
+	Slot &slotAt(uint32_t index)
+	{
+		return slabs[index / PROJECTILE_SLAB_SIZE][index % PROJECTILE_SLAB_SIZE];
+	}
+
+	static PROJECTILE *object(Slot &slot)
+	{
+		return reinterpret_cast<PROJECTILE *>(&slot.storage);
+	}
+
+	std::vector<std::unique_ptr<Slot[]>> slabs;
+	std::vector<uint32_t> freeSlots;
+};
+
+static ProjectilePool projectilePool;
+
+/* The list of projectiles in play, as pool slot indices, in the order they were fired */
+static std::vector<uint32_t> psProjectileList;
 
 /* The next projectile to give out in the proj_First / proj_Next methods */
 static ProjectileIterator psProjectileNext;
@@ -180,6 +268,7 @@ bool gfxVisible(PROJECTILE *psObj)
 bool
 proj_InitSystem()
 {
+	projectilePool.clear();
 	psProjectileList.clear();
 	psProjectileNext = psProjectileList.end();
 	for (int x = 0; x < MAX_PLAYERS; ++x)
@@ -196,6 +285,7 @@ proj_InitSystem()
 void
 proj_FreeAllProjectiles()
 {
+	projectilePool.clear();
 	psProjectileList.clear();
 	psProjectileNext = psProjectileList.end();
 }
@@ -217,7 +307,7 @@ PROJECTILE *
 proj_GetFirst()
 {
 	psProjectileNext = psProjectileList.begin();
-	return psProjectileNext != psProjectileList.end() ? *psProjectileNext : nullptr;
+	return psProjectileNext != psProjectileList.end() ? projectilePool.at(*psProjectileNext) : nullptr;
 }
 
 /***************************************************************************/
@@ -227,7 +317,7 @@ PROJECTILE *
 proj_GetNext()
 {
 	++psProjectileNext;
-	return psProjectileNext != psProjectileList.end() ? *psProjectileNext : nullptr;
+	return psProjectileNext != psProjectileList.end() ? projectilePool.at(*psProjectileNext) : nullptr;
 }
 
 /***************************************************************************/
@@ -413,7 +503,7 @@ bool proj_SendProjectileAngled(WEAPON *psWeap, SIMPLE_OBJECT *psAttacker, int pl
 	ASSERT_OR_RETURN(false, psStats != nullptr, "Invalid weapon stats");
 	ASSERT_OR_RETURN(false, psTarget == nullptr || !psTarget->died, "Aiming at dead target!");
 
-	PROJECTILE *psProj = new PROJECTILE(ProjectileTrackerID | (realTime >> 4), player);
+	PROJECTILE *psProj = projectilePool.alloc(ProjectileTrackerID | (realTime >> 4), player);
 
 	/* get muzzle offset */
 	if (psAttacker == nullptr)
@@ -532,7 +622,7 @@ bool proj_SendProjectileAngled(WEAPON *psWeap, SIMPLE_OBJECT *psAttacker, int pl
 	}
 
 	/* put the projectile object in the global list */
-	psProjectileList.push_back(psProj);
+	psProjectileList.push_back(psProj->poolIndex);
 
 	/* play firing audio */
 	// only play if either object is visible, i know it's a bit of a hack, but it avoids the problem
@@ -1325,13 +1415,24 @@ void PROJECTILE::update()
 // iterate through all projectiles and update their status
 void proj_UpdateAll()
 {
-	std::vector<PROJECTILE *> psProjectileListOld = psProjectileList;
+	static std::vector<uint32_t> psProjectileListOld;  // static to avoid allocations.
+	psProjectileListOld = psProjectileList;
 
 	// Update all projectiles. Penetrating projectiles may add to psProjectileList.
-	std::for_each(psProjectileListOld.begin(), psProjectileListOld.end(), std::mem_fun(&PROJECTILE::update));
+	for (uint32_t index : psProjectileListOld)
+	{
+		projectilePool.at(index)->update();
+	}
 
-	// Remove and free dead projectiles.
-	psProjectileList.erase(std::remove_if(psProjectileList.begin(), psProjectileList.end(), std::mem_fun(&PROJECTILE::deleteIfDead)), psProjectileList.end());
+	// Remove dead projectiles and return them to the pool, keeping the firing order of the rest.
+	psProjectileList.erase(std::remove_if(psProjectileList.begin(), psProjectileList.end(), [](uint32_t index) {
+		if (!projectilePool.at(index)->isDead())
+		{
+			return false;
+		}
+		projectilePool.free(index);
+		return true;
+	}), psProjectileList.end());
 }
 
 /***************************************************************************/
@@ -43,14 +43,9 @@ struct PROJECTILE : public SIMPLE_OBJECT
 	PROJECTILE(uint32_t id, unsigned player) : SIMPLE_OBJECT(OBJ_PROJECTILE, id, player) {}
 
 	void            update();
-	bool            deleteIfDead()
+	bool            isDead() const          ///< True once the projectile may be returned to the pool.
 	{
-		if (died == 0 || died >= gameTime - deltaGameTime)
-		{
-			return false;
-		}
-		delete this;
-		return true;
+		return died != 0 && died < gameTime - deltaGameTime;
 	}
 
 	UBYTE           state;                  ///< current projectile state
@@ -66,9 +61,10 @@ struct PROJECTILE : public SIMPLE_OBJECT
 	Spacetime       prevSpacetime;          ///< Location of projectile in previous tick.
 	UDWORD          expectedDamageCaused;   ///< Expected damage that this projectile will cause to the target.
 	int             partVisible;            ///< how much of target was visible on shooting (important for homing)
+	uint32_t        poolIndex;              ///< Pool slot holding this projectile.
 };
 
-typedef std::vector<PROJECTILE *>::const_iterator ProjectileIterator;
+typedef std::vector<uint32_t>::const_iterator ProjectileIterator;
 
 
 /// True iff object is a projectile.
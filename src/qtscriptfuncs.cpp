@@ -52,6 +52,7 @@
 #include "console.h"
 #include "design.h"
 #include "display3d.h"
+#include "terrain.h"
 #include "map.h"
 #include "mission.h"
 #include "move.h"
@@ -263,7 +264,11 @@ void clearMarks()
 		for (int y = 0; y < mapHeight; y++)
 		{
 			MAPTILE *psTile = mapTile(x, y);
-			psTile->tileInfoBits &= ~BITS_MARKED;
+			if (psTile->tileInfoBits & BITS_MARKED)
+			{
+				psTile->tileInfoBits &= ~BITS_MARKED;
+				markLightmapDirty(x, y);
+			}
 		}
 	}
 }
@@ -311,6 +316,7 @@ void showLabel(const QString &key, bool clear_old, bool jump_to)
 			{
 				MAPTILE *psTile = mapTile(x, y);
 				psTile->tileInfoBits |= BITS_MARKED;
+				markLightmapDirty(x, y);
 			}
 		}
 	}
@@ -328,6 +334,7 @@ void showLabel(const QString &key, bool clear_old, bool jump_to)
 				{
 					MAPTILE *psTile = mapTile(x, y);
 					psTile->tileInfoBits |= BITS_MARKED;
+					markLightmapDirty(x, y);
 				}
 			}
 		}
@@ -343,6 +350,7 @@ void showLabel(const QString &key, bool clear_old, bool jump_to)
 			}
 			MAPTILE *psTile = mapTile(map_coord(psObj->pos.x), map_coord(psObj->pos.y));
 			psTile->tileInfoBits |= BITS_MARKED;
+			markLightmapDirty(map_coord(psObj->pos.x), map_coord(psObj->pos.y));
 		}
 	}
 	else if (l.type == SCRIPT_GROUP)
@@ -362,6 +370,7 @@ void showLabel(const QString &key, bool clear_old, bool jump_to)
 					}
 					MAPTILE *psTile = mapTile(map_coord(psObj->pos.x), map_coord(psObj->pos.y));
 					psTile->tileInfoBits |= BITS_MARKED;
+					markLightmapDirty(map_coord(psObj->pos.x), map_coord(psObj->pos.y));
 				}
 			}
 		}
@@ -1669,7 +1678,7 @@ static QScriptValue js_enumResearch(QScriptContext *context, QScriptEngine *engi
 {
 	QList<RESEARCH *> reslist;
 	int player = engine->globalObject().property("me").toInt32();
-	for (int i = 0; i < asResearch.size(); i++)
+	for (UWORD i : researchCandidates(player))
 	{
 		RESEARCH *psResearch = &asResearch[i];
 		if (!IsResearchCompleted(&asPlayerResList[player][i]) && researchAvailable(i, player, ModeQueue))
@@ -4513,6 +4522,7 @@ static QScriptValue js_hackMarkTiles(QScriptContext *context, QScriptEngine *)
 			{
 				MAPTILE *psTile = mapTile(x, y);
 				psTile->tileInfoBits |= BITS_MARKED;
+				markLightmapDirty(x, y);
 			}
 		}
 	}
@@ -4522,6 +4532,7 @@ static QScriptValue js_hackMarkTiles(QScriptContext *context, QScriptEngine *)
 		int y = context->argument(1).toInt32();
 		MAPTILE *psTile = mapTile(x, y);
 		psTile->tileInfoBits |= BITS_MARKED;
+		markLightmapDirty(x, y);
 	}
 	else if (context->argumentCount() == 1) // label
 	{
@@ -4536,6 +4547,7 @@ static QScriptValue js_hackMarkTiles(QScriptContext *context, QScriptEngine *)
 				{
 					MAPTILE *psTile = mapTile(x, y);
 					psTile->tileInfoBits |= BITS_MARKED;
+					markLightmapDirty(x, y);
 				}
 			}
 		}
@@ -4549,6 +4561,7 @@ static QScriptValue js_hackMarkTiles(QScriptContext *context, QScriptEngine *)
 					{
 						MAPTILE *psTile = mapTile(x, y);
 						psTile->tileInfoBits |= BITS_MARKED;
+						markLightmapDirty(x, y);
 					}
 				}
 			}
@@ -18,6 +18,7 @@
 	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 */
 #include <string.h>
+#include <vector>
 
 #include "lib/framework/frame.h"
 #include "lib/framework/fixedpoint.h"
@@ -32,6 +33,7 @@
 #include "lib/gamelib/gtime.h"
 #include "advvis.h"
 #include "objects.h"
+#include "structure.h"
 #include "display3d.h"
 #include "map.h"
 #include "component.h"
@@ -115,8 +117,23 @@ static uint8_t RadarZoom;
 static UDWORD radarBufferSize = 0;
 static int frameSkip = 0;
 
+// The radar texture is composed of a cached tile layer with the object blips drawn over it. A tile is
+// only recoloured when one of the inputs to appliedRadarColour() changed, and only the rows of the
+// texture which actually changed since the last refresh are sent to the GPU.
+static std::vector<uint32_t> radarTiles;        ///< Tile layer, without any objects.
+static std::vector<uint64_t> radarTileKeys;     ///< Inputs used to colour each pixel of radarTiles.
+static std::vector<uint32_t> radarUploaded;     ///< Contents of the radar texture on the GPU.
+static std::vector<size_t> radarBlips;          ///< Pixels covered by objects at the last refresh.
+static std::vector<size_t> radarTouched;        ///< Pixels which may have changed during this refresh.
+static bool radarTilesValid = false;            ///< Whether radarTileKeys may be trusted at all.
+static bool radarUploadAll = true;              ///< Whether the texture contents are undefined.
+static RADAR_DRAW_MODE radarTilesMode = RADAR_MODE_DEFAULT;
+static bool radarTilesRevealed = false;
+static unsigned radarTilesPlayer = 0;
+
 static void DrawRadarTiles();
 static void DrawRadarObjects();
+static void UploadRadar();
 static void DrawRadarExtras(const glm::mat4 &modelViewProjectionMatrix);
 static void DrawNorth(const glm::mat4 &modelViewProjectionMatrix);
 static void setViewingWindow();
@@ -162,6 +179,12 @@ bool resizeRadar()
 	radarBufferSize = radarTexWidth * radarTexHeight * sizeof(UDWORD);
 	radarBuffer = (uint32_t *)malloc(radarBufferSize);
 	memset(radarBuffer, 0, radarBufferSize);
+	radarTiles.assign(radarTexWidth * radarTexHeight, 0);
+	radarTileKeys.assign(radarTexWidth * radarTexHeight, 0);
+	radarUploaded.assign(radarTexWidth * radarTexHeight, 0);
+	radarBlips.clear();
+	radarTilesValid = false;
+	radarUploadAll = true;
 	frameSkip = 0;
 	debug(LOG_WZ, "Setting radar zoom to %u", RadarZoom);
 	radarSize(RadarZoom);
@@ -175,6 +198,11 @@ bool ShutdownRadar()
 {
 	free(radarBuffer);
 	radarBuffer = nullptr;
+	radarTiles.clear();
+	radarTileKeys.clear();
+	radarUploaded.clear();
+	radarBlips.clear();
+	radarTilesValid = false;
 	frameSkip = 0;
 	return true;
 }
@@ -256,9 +284,10 @@ void drawRadar()
 
 	if (frameSkip <= 0)
 	{
+		radarTouched.clear();
 		DrawRadarTiles();
 		DrawRadarObjects();
-		pie_DownLoadRadar(radarBuffer);
+		UploadRadar();
 		frameSkip = RADAR_FRAME_SKIP;
 	}
 	frameSkip--;
@@ -374,27 +403,101 @@ static PIELIGHT appliedRadarColour(RADAR_DRAW_MODE radarDrawMode, MAPTILE *WTile
 	return WScr;
 }
 
-/** Draw the map tiles on the radar. */
+/** Everything about a tile that appliedRadarColour() looks at, packed so that it can be compared cheaply. */
+static inline uint64_t radarTileKey(MAPTILE *psTile)
+{
+	return (uint64_t)(uint32_t)psTile->height
+	       | (uint64_t)psTile->texture << 32
+	       | (uint64_t)psTile->illumination << 48
+	       | (uint64_t)(TEST_TILE_VISIBLE(selectedPlayer, psTile) != 0) << 56
+	       | (uint64_t)hasSensorOnTile(psTile, selectedPlayer) << 57;
+}
+
+/** Draw the map tiles on the radar, recolouring only the tiles which changed since the last refresh. */
 static void DrawRadarTiles()
 {
 	SDWORD	x, y;
 
-	for (x = scrollMinX; x < scrollMaxX; x++)
+	if (radarTilesMode != radarDrawMode || radarTilesRevealed != getRevealStatus() || radarTilesPlayer != selectedPlayer)
 	{
-		for (y = scrollMinY; y < scrollMaxY; y++)
+		radarTilesMode = radarDrawMode;
+		radarTilesRevealed = getRevealStatus();
+		radarTilesPlayer = selectedPlayer;
+		radarTilesValid = false;
+	}
+
+	for (y = scrollMinY; y < scrollMaxY; y++)
+	{
+		for (x = scrollMinX; x < scrollMaxX; x++)
 		{
 			MAPTILE	*psTile = mapTile(x, y);
 			size_t pos = radarTexWidth * (y - scrollMinY) + (x - scrollMinX);
+			uint64_t key = radarTileKey(psTile);
+			uint32_t colour;
 
-			ASSERT(pos * sizeof(*radarBuffer) < radarBufferSize, "Buffer overrun");
-			if (y == scrollMinY || x == scrollMinX || y == scrollMaxY - 1 || x == scrollMaxX - 1)
+			ASSERT(pos < radarTiles.size(), "Buffer overrun");
+			if (radarTilesValid && radarTileKeys[pos] == key)
 			{
-				radarBuffer[pos] = WZCOL_BLACK.rgba;
 				continue;
 			}
-			radarBuffer[pos] = appliedRadarColour(radarDrawMode, psTile).rgba;
+			radarTileKeys[pos] = key;
+			if (y == scrollMinY || x == scrollMinX || y == scrollMaxY - 1 || x == scrollMaxX - 1)
+			{
+				colour = WZCOL_BLACK.rgba;
+			}
+			else
+			{
+				colour = appliedRadarColour(radarDrawMode, psTile).rgba;
+			}
+			if (colour != radarTiles[pos])
+			{
+				radarTiles[pos] = colour;
+				radarBuffer[pos] = colour;
+				radarTouched.push_back(pos);
+			}
+		}
+	}
+	radarTilesValid = true;
+}
+
+/** Put an object blip on the radar, on top of the tile layer. */
+static inline void DrawRadarBlip(size_t pos, PIELIGHT colour)
+{
+	ASSERT_OR_RETURN(, pos < radarTiles.size(), "Buffer overrun");
+	radarBuffer[pos] = colour.rgba;
+	radarBlips.push_back(pos);
+	radarTouched.push_back(pos);
+}
+
+/** Send the rows of the radar which changed since the last refresh to the GPU. */
+static void UploadRadar()
+{
+	int minRow = radarTexHeight, maxRow = -1;
+
+	if (radarUploadAll)
+	{
+		minRow = 0;
+		maxRow = radarTexHeight - 1;
+		memcpy(radarUploaded.data(), radarBuffer, radarBufferSize);
+		radarUploadAll = false;
+	}
+	else
+	{
+		for (size_t pos : radarTouched)
+		{
+			if (radarBuffer[pos] != radarUploaded[pos])
+			{
+				int row = pos / radarTexWidth;
+				radarUploaded[pos] = radarBuffer[pos];
+				minRow = std::min(minRow, row);
+				maxRow = std::max(maxRow, row);
+			}
 		}
 	}
+	if (minRow <= maxRow)
+	{
+		pie_DownLoadRadar(radarBuffer + minRow * radarTexWidth, minRow, maxRow - minRow + 1);
+	}
 }
 
 /** Draw the droids and structure positions on the radar. */
@@ -403,7 +506,14 @@ static void DrawRadarObjects()
 	UBYTE				clan;
 	PIELIGHT			playerCol;
 	PIELIGHT			flashCol;
-	int				x, y;
+
+	/* Remove the blips of the last refresh */
+	for (size_t pos : radarBlips)
+	{
+		radarBuffer[pos] = radarTiles[pos];
+		radarTouched.push_back(pos);
+	}
+	radarBlips.clear();
 
 	/* Show droids on map - go through all players */
 	for (clan = 0; clan < MAX_PLAYERS; clan++)
@@ -448,66 +558,64 @@ static void DrawRadarObjects()
 				int	y = psDroid->pos.y / TILE_UNITS;
 				size_t	pos = (x - scrollMinX) + (y - scrollMinY) * radarTexWidth;
 
-				ASSERT(pos * sizeof(*radarBuffer) < radarBufferSize, "Buffer overrun");
 				if (clan == selectedPlayer && gameTime > HIT_NOTIFICATION && gameTime - psDroid->timeLastHit < HIT_NOTIFICATION)
 				{
-					radarBuffer[pos] = flashCol.rgba;
+					DrawRadarBlip(pos, flashCol);
 				}
 				else
 				{
-					radarBuffer[pos] = playerCol.rgba;
+					DrawRadarBlip(pos, playerCol);
 				}
 			}
 		}
 	}
 
-	/* Do the same for structures */
-	for (x = scrollMinX; x < scrollMaxX; x++)
+	/* Do the same for structures, covering the tiles of their footprint */
+	for (clan = 0; clan < MAX_PLAYERS; clan++)
 	{
-		for (y = scrollMinY; y < scrollMaxY; y++)
+		//see if have to draw enemy/ally color
+		if (bEnemyAllyRadarColor)
 		{
-			MAPTILE		*psTile = mapTile(x, y);
-			STRUCTURE	*psStruct;
-			size_t		pos = (x - scrollMinX) + (y - scrollMinY) * radarTexWidth;
-
-			ASSERT(pos * sizeof(*radarBuffer) < radarBufferSize, "Buffer overrun");
-			if (!TileHasStructure(psTile))
+			if (clan == selectedPlayer)
 			{
-				continue;
+				playerCol = colRadarMe;
 			}
-			psStruct = (STRUCTURE *)psTile->psObject;
-			clan = psStruct->player;
+			else
+			{
+				playerCol = (aiCheckAlliances(selectedPlayer, clan) ? colRadarAlly : colRadarEnemy);
+			}
+		}
+		else
+		{
+			//original 8-color mode
+			playerCol = clanColours[getPlayerColour(clan)];
+		}
+		flashCol = flashColours[getPlayerColour(clan)];
 
-			//see if have to draw enemy/ally color
-			if (bEnemyAllyRadarColor)
+		for (STRUCTURE *psStruct = apsStructLists[clan]; psStruct != nullptr; psStruct = psStruct->psNext)
+		{
+			if (!psStruct->visible[selectedPlayer]
+			    && !(bMultiPlayer && alliancesSharedVision(game.alliance)
+			         && aiCheckAlliances(selectedPlayer, psStruct->player)))
 			{
-				if (clan == selectedPlayer)
-				{
-					playerCol = colRadarMe;
-				}
-				else
-				{
-					playerCol = (aiCheckAlliances(selectedPlayer, clan) ? colRadarAlly : colRadarEnemy);
-				}
+				continue;
 			}
-			else
+			PIELIGHT col = playerCol;
+			if (clan == selectedPlayer && gameTime > HIT_NOTIFICATION && gameTime - psStruct->timeLastHit < HIT_NOTIFICATION)
 			{
-				//original 8-color mode
-				playerCol = clanColours[getPlayerColour(clan)];
+				col = flashCol;
 			}
-			flashCol = flashColours[getPlayerColour(clan)];
-
-			if (psStruct->visible[selectedPlayer]
-			    || (bMultiPlayer && alliancesSharedVision(game.alliance)
-			        && aiCheckAlliances(selectedPlayer, psStruct->player)))
+			StructureBounds b = getStructureBounds(psStruct);
+			int minX = std::max(b.map.x, scrollMinX), maxX = std::min(b.map.x + b.size.x, scrollMaxX);
+			int minY = std::max(b.map.y, scrollMinY), maxY = std::min(b.map.y + b.size.y, scrollMaxY);
+			for (int y = minY; y < maxY; y++)
 			{
-				if (clan == selectedPlayer && gameTime > HIT_NOTIFICATION && gameTime - psStruct->timeLastHit < HIT_NOTIFICATION)
-				{
-					radarBuffer[pos] = flashCol.rgba;
-				}
-				else
+				for (int x = minX; x < maxX; x++)
 				{
-					radarBuffer[pos] = playerCol.rgba;
+					if (mapTile(x, y)->psObject == psStruct)
+					{
+						DrawRadarBlip((x - scrollMinX) + (y - scrollMinY) * radarTexWidth, col);
+					}
 				}
 			}
 		}
@@ -655,6 +763,7 @@ bool CoordInRadar(int x, int y)
 
 void radarColour(UDWORD tileNumber, uint8_t r, uint8_t g, uint8_t b)
 {
+	radarTilesValid = false;
 	tileColours[tileNumber].byte.r = r;
 	tileColours[tileNumber].byte.g = g;
 	tileColours[tileNumber].byte.b = b;
@@ -19,8 +19,10 @@
 */
 #include "random.h"
 #include "lib/netplay/netplay.h"
+#include "lib/framework/crc.h"
 
 static MersenneTwister gamePseudorandomNumberGenerator;
+static uint32_t gamePseudorandomSeed = 42;  ///< Matches the default MersenneTwister seed.
 
 MersenneTwister::MersenneTwister(uint32_t seed)
 	: offset(624)
@@ -79,9 +81,36 @@ void MersenneTwister::generate()
 
 void gameSRand(uint32_t seed)
 {
+	gamePseudorandomSeed = seed;
 	gamePseudorandomNumberGenerator = MersenneTwister(seed);
 }
 
+uint32_t gameRandSeed()
+{
+	return gamePseudorandomSeed;
+}
+
+uint32_t MersenneTwister::stateCrc() const
+{
+	// Big-endian, so that clients on different platforms get the same CRC.
+	uint8_t bytes[4 * (1 + 624)];
+	uint8_t *b = bytes;
+	for (int n = -1; n < 624; ++n)
+	{
+		uint32_t v = n < 0 ? offset : state[n];
+		*b++ = v >> 24;
+		*b++ = v >> 16;
+		*b++ = v >> 8;
+		*b++ = v;
+	}
+	return crcSum(0, bytes, sizeof(bytes));
+}
+
+uint32_t gameRandStateCrc()
+{
+	return gamePseudorandomNumberGenerator.stateCrc();
+}
+
 uint32_t gameRandU32()
 {
 	return gamePseudorandomNumberGenerator.u32();
@@ -25,6 +25,7 @@
  */
 #include <string.h>
 #include <map>
+#include <set>
 
 #include "lib/framework/frame.h"
 #include "lib/netplay/netplay.h"
@@ -72,6 +73,17 @@ static bool checkResearchName(RESEARCH *psRes, UDWORD numStats);
 
 //flag that indicates whether the player can self repair
 static UBYTE bSelfRepair[MAX_PLAYERS];
+
+/// The topics researchAvailable() can return true for, kept up to date by researchStatusChanged().
+struct ResearchFrontier
+{
+	std::vector<UWORD> numPRCompleted;  ///< Per topic, how many entries of its pPRList are completed.
+	std::vector<bool> completed;        ///< Per topic, whether it counts as completed in numPRCompleted of its dependents.
+	std::set<UWORD> candidates;         ///< Sorted, so that lists come out in the same order as looping over all topics.
+};
+static ResearchFrontier researchFrontier[MAX_PLAYERS];
+static std::vector<std::vector<UWORD>> researchDependents;  ///< Per topic, the topics having it in their pPRList.
+static bool researchFrontierValid = false;  ///< Rebuilt on the next query after the research lists change size.
 static void replaceDroidComponent(DROID *pList, UDWORD oldType, UDWORD oldCompInc,
                                   UDWORD newCompInc);
 static void replaceStructureComponent(STRUCTURE *pList, UDWORD oldType, UDWORD oldCompInc,
@@ -84,6 +96,7 @@ static void replaceTransDroidComponents(DROID *psTransporter, UDWORD oldType,
 
 bool researchInitVars()
 {
+	researchFrontierValid = false;
 	psCBLastResearch = nullptr;
 	psCBLastResStructure = nullptr;
 	CBResFacilityOwner = -1;
@@ -345,10 +358,119 @@ bool loadResearch(WzConfig &ini)
 			}
 		}
 	}
+	researchFrontierValid = false;
 
 	return true;
 }
 
+/// Whether researchAvailable() might return true, in either mode. Only the cheap conditions, the rest is left to researchAvailable().
+static bool researchIsCandidate(int player, int topic)
+{
+	PLAYER_RESEARCH const *x = &asPlayerResList[player][topic];
+	if ((x->ResearchStatus & (CANCELLED_RESEARCH | CANCELLED_RESEARCH_PENDING)) != 0)
+	{
+		return true;
+	}
+	if (IsResearchCompleted(x))
+	{
+		return false;
+	}
+	return IsResearchPossible(x) || (!asResearch[topic].pPRList.empty() && researchFrontier[player].numPRCompleted[topic] == asResearch[topic].pPRList.size());
+}
+
+static void researchFrontierUpdate(int player, int topic)
+{
+	if (researchIsCandidate(player, topic))
+	{
+		researchFrontier[player].candidates.insert(topic);
+	}
+	else
+	{
+		researchFrontier[player].candidates.erase(topic);
+	}
+}
+
+static void researchFrontierBuild()
+{
+	researchDependents.assign(asResearch.size(), std::vector<UWORD>());
+	for (size_t topic = 0; topic < asResearch.size(); ++topic)
+	{
+		for (UWORD prerequisite : asResearch[topic].pPRList)
+		{
+			researchDependents[prerequisite].push_back(topic);
+		}
+	}
+	for (int player = 0; player < MAX_PLAYERS; ++player)
+	{
+		ResearchFrontier &frontier = researchFrontier[player];
+		frontier.numPRCompleted.assign(asResearch.size(), 0);
+		frontier.completed.assign(asResearch.size(), false);
+		frontier.candidates.clear();
+		ASSERT_OR_RETURN(, asPlayerResList[player].size() == asResearch.size(), "Research lists of player %d out of sync", player);
+		for (size_t topic = 0; topic < asResearch.size(); ++topic)
+		{
+			if (IsResearchCompleted(&asPlayerResList[player][topic]))
+			{
+				frontier.completed[topic] = true;
+				for (UWORD dependent : researchDependents[topic])
+				{
+					++frontier.numPRCompleted[dependent];
+				}
+			}
+		}
+		for (size_t topic = 0; topic < asResearch.size(); ++topic)
+		{
+			researchFrontierUpdate(player, topic);
+		}
+	}
+	researchFrontierValid = true;
+}
+
+void researchStatusChanged(PLAYER_RESEARCH const *x)
+{
+	if (!researchFrontierValid)
+	{
+		return;  // Will be rebuilt from scratch anyway.
+	}
+	std::less<PLAYER_RESEARCH const *> before;
+	for (int player = 0; player < MAX_PLAYERS; ++player)
+	{
+		std::vector<PLAYER_RESEARCH> const &list = asPlayerResList[player];
+		if (list.empty() || before(x, &list.front()) || before(&list.back(), x))
+		{
+			continue;
+		}
+		int topic = x - &list.front();
+		ResearchFrontier &frontier = researchFrontier[player];
+		if (topic >= (int)frontier.completed.size())
+		{
+			researchFrontierValid = false;  // Lists grew since the frontier was built.
+			return;
+		}
+		bool completed = IsResearchCompleted(x);
+		if (completed != frontier.completed[topic])
+		{
+			frontier.completed[topic] = completed;
+			for (UWORD dependent : researchDependents[topic])
+			{
+				frontier.numPRCompleted[dependent] += completed ? 1 : -1;
+				researchFrontierUpdate(player, dependent);
+			}
+		}
+		researchFrontierUpdate(player, topic);
+		return;
+	}
+}
+
+std::set<UWORD> const &researchCandidates(int player)
+{
+	if (!researchFrontierValid)
+	{
+		researchFrontierBuild();
+	}
+	return researchFrontier[player].candidates;
+}
+
 bool researchAvailable(int inc, int playerID, QUEUE_MODE mode)
 {
 	// Decide whether to use IsResearchCancelledPending/IsResearchStartedPending or IsResearchCancelled/IsResearchStarted.
@@ -461,21 +583,36 @@ There can only be 'limit' number of entries
 // NOTE by AJL may 99 - skirmish now has it's own version of this, skTopicAvail.
 UWORD fillResearchList(UWORD *plist, UDWORD playerID, UWORD topic, UWORD limit)
 {
-	UWORD				inc, count = 0;
+	UWORD count = 0;
+	bool topicListed = topic >= asResearch.size();  // Callers pass an impossible topic if there is none.
 
-	for (inc = 0; inc < asResearch.size(); inc++)
+	for (UWORD inc : researchCandidates(playerID))
 	{
-		// if the inc matches the 'topic' - automatically add to the list
+		// if the 'topic' comes first - automatically add to the list
+		if (!topicListed && topic < inc)
+		{
+			*plist++ = topic;
+			topicListed = true;
+			if (++count == limit)
+			{
+				return count;
+			}
+		}
 		if (inc == topic || researchAvailable(inc, playerID, ModeQueue))
 		{
+			topicListed = topicListed || inc == topic;
 			*plist++ = inc;
-			count++;
-			if (count == limit)
+			if (++count == limit)
 			{
 				return count;
 			}
 		}
 	}
+	if (!topicListed && count < limit)
+	{
+		*plist++ = topic;
+		count++;
+	}
 	return count;
 }
 
@@ -621,6 +758,7 @@ bool ResearchShutDown()
 /*This function is called when a game finishes*/
 void ResearchRelease()
 {
+	researchFrontierValid = false;
 	asResearch.clear();
 	for (auto &i : asPlayerResList)
 	{
@@ -24,6 +24,8 @@
 #ifndef __INCLUDED_SRC_RESEARCH_H__
 #define __INCLUDED_SRC_RESEARCH_H__
 
+#include <set>
+
 #include "lib/framework/wzconfig.h"
 
 #include "objectdef.h"
@@ -136,6 +138,8 @@ void CancelAllResearch(UDWORD pl);
 bool researchInitVars();
 
 bool researchAvailable(int inc, int playerID, QUEUE_MODE mode);
+/// Topics that researchAvailable() can be true for, in index order. Maintained as research completes, starts and gets cancelled or enabled, so much smaller than asResearch.
+std::set<UWORD> const &researchCandidates(int player);
 
 struct AllyResearch
 {
@@ -90,6 +90,9 @@ struct PLAYER_RESEARCH
 #define RESBITS_PENDING_ONLY (STARTED_RESEARCH_PENDING|CANCELLED_RESEARCH_PENDING)
 #define RESBITS_PENDING (RESBITS|RESBITS_PENDING_ONLY)
 
+/// Keeps the research frontier of researchCandidates() up to date. Called by the functions below, which are the only ones that should change the status.
+void researchStatusChanged(PLAYER_RESEARCH const *x);
+
 static inline bool IsResearchPossible(const PLAYER_RESEARCH *research)
 {
 	return research->possible;
@@ -98,6 +101,7 @@ static inline bool IsResearchPossible(const PLAYER_RESEARCH *research)
 static inline void MakeResearchPossible(PLAYER_RESEARCH *research)
 {
 	research->possible = true;
+	researchStatusChanged(research);
 }
 
 static inline bool IsResearchCompleted(PLAYER_RESEARCH const *x)
@@ -130,37 +134,44 @@ static inline void MakeResearchCompleted(PLAYER_RESEARCH *x)
 {
 	x->ResearchStatus &= ~RESBITS_PENDING;
 	x->ResearchStatus |= RESEARCHED;
+	researchStatusChanged(x);
 }
 static inline void MakeResearchCancelled(PLAYER_RESEARCH *x)
 {
 	x->ResearchStatus &= ~RESBITS_PENDING;
 	x->ResearchStatus |= CANCELLED_RESEARCH;
+	researchStatusChanged(x);
 }
 static inline void MakeResearchStarted(PLAYER_RESEARCH *x)
 {
 	x->ResearchStatus &= ~RESBITS_PENDING;
 	x->ResearchStatus |= STARTED_RESEARCH;
+	researchStatusChanged(x);
 }
 /// Pending means not yet synchronised, so only permitted to affect the UI, not the game state.
 static inline void MakeResearchCancelledPending(PLAYER_RESEARCH *x)
 {
 	x->ResearchStatus &= ~RESBITS_PENDING_ONLY;
 	x->ResearchStatus |= CANCELLED_RESEARCH_PENDING;
+	researchStatusChanged(x);
 }
 static inline void MakeResearchStartedPending(PLAYER_RESEARCH *x)
 {
 	x->ResearchStatus &= ~RESBITS_PENDING_ONLY;
 	x->ResearchStatus |= STARTED_RESEARCH_PENDING;
+	researchStatusChanged(x);
 }
 static inline void ResetPendingResearchStatus(PLAYER_RESEARCH *x)
 {
 	x->ResearchStatus &= ~RESBITS_PENDING_ONLY;
+	researchStatusChanged(x);
 }
 
 /// clear all bits in the status except for the possible bit
 static inline void ResetResearchStatus(PLAYER_RESEARCH *x)
 {
 	x->ResearchStatus &= ~RESBITS_PENDING;
+	researchStatusChanged(x);
 }
 
 #endif // __INCLUDED_RESEARCHDEF_H__
@@ -10011,6 +10011,7 @@ bool scrSetTileHeight()
 	psTile = mapTile(tileX, tileY);
 
 	psTile->height = (UBYTE)newHeight * ELEVATION_SCALE;
+	visTerrainChanged(tileX, tileY);
 
 	return true;
 }
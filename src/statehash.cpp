@@ -0,0 +1,229 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file statehash.cpp
+ *
+ * Per-tick hashes of the synchronised game state.
+ *
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/framework/crc.h"
+#include "lib/framework/jobsystem.h"
+#include "lib/framework/physfs_ext.h"
+#include "lib/gamelib/gtime.h"
+
+#include "statehash.h"
+#include "droid.h"
+#include "mission.h"
+#include "objmem.h"
+#include "power.h"
+#include "random.h"
+#include "research.h"
+#include "structure.h"
+
+#define STATE_HASH_MAGIC "WZSH"
+#define STATE_HASH_VERSION 1
+#define STATE_HASH_FLUSH 65536  ///< Bytes to collect before writing them out.
+
+static const char *stateHashNames[SHS_COUNT] =
+{
+	"droids",
+	"structures",
+	"features",
+	"power",
+	"research",
+	"random",
+};
+
+static std::string          hashFileName;
+static PHYSFS_file         *hashFile = nullptr;
+static bool                 hashFailed = false;
+static std::vector<uint8_t> hashBuffer;
+
+static void putUint32(std::vector<uint8_t> &buffer, uint32_t v)
+{
+	buffer.push_back(v >> 24);
+	buffer.push_back(v >> 16);
+	buffer.push_back(v >> 8);
+	buffer.push_back(v);
+}
+
+/// Hashes the values in big endian, so that clients on any platform give the same hash.
+template <size_t N>
+static uint32_t hashInts(uint32_t crc, int64_t const (&values)[N])
+{
+	uint8_t bytes[N * 8];
+	for (size_t i = 0; i < N; ++i)
+	{
+		for (int b = 0; b < 8; ++b)
+		{
+			bytes[i * 8 + b] = uint64_t(values[i]) >> (56 - b * 8);
+		}
+	}
+	return crcSum(crc, bytes, sizeof(bytes));
+}
+
+static uint32_t hashDroids(DROID const *psList, uint32_t crc)
+{
+	for (DROID const *psDroid = psList; psDroid != nullptr; psDroid = psDroid->psNext)
+	{
+		int64_t values[] = {psDroid->id, psDroid->pos.x, psDroid->pos.y, psDroid->pos.z, psDroid->rot.direction, psDroid->rot.pitch, psDroid->rot.roll,
+		                    psDroid->body, psDroid->experience, (int64_t)psDroid->action, (int64_t)psDroid->order.type, (int64_t)psDroid->sMove.Status, psDroid->died != 0};
+		crc = hashInts(crc, values);
+	}
+	return crc;
+}
+
+static uint32_t hashStructures(STRUCTURE const *psList, uint32_t crc)
+{
+	for (STRUCTURE const *psStruct = psList; psStruct != nullptr; psStruct = psStruct->psNext)
+	{
+		int64_t values[] = {psStruct->id, psStruct->pos.x, psStruct->pos.y, psStruct->pos.z, psStruct->rot.direction,
+		                    psStruct->body, (int64_t)psStruct->status, psStruct->currentBuildPts, psStruct->died != 0};
+		crc = hashInts(crc, values);
+	}
+	return crc;
+}
+
+/// Only reads the game state, so any number of these can run at once.
+static uint32_t stateHash(STATE_HASH_SUBSYSTEM subsystem, unsigned player)
+{
+	uint32_t crc = 0;
+
+	switch (subsystem)
+	{
+	case SHS_DROIDS:
+		crc = hashDroids(apsDroidLists[player], crc);
+		crc = hashDroids(mission.apsDroidLists[player], crc);
+		break;
+	case SHS_STRUCTURES:
+		crc = hashStructures(apsStructLists[player], crc);
+		crc = hashStructures(mission.apsStructLists[player], crc);
+		break;
+	case SHS_FEATURES:
+		for (FEATURE const *psFeat = player == 0 ? apsFeatureLists[0] : nullptr; psFeat != nullptr; psFeat = psFeat->psNext)
+		{
+			int64_t values[] = {psFeat->id, psFeat->pos.x, psFeat->pos.y, psFeat->pos.z, psFeat->body, psFeat->died != 0};
+			crc = hashInts(crc, values);
+		}
+		break;
+	case SHS_POWER:
+		{
+			int64_t values[] = {getPrecisePower(player), getQueuedPower(player), getExtractedPower(player), getWastedPower(player)};
+			crc = hashInts(crc, values);
+			break;
+		}
+	case SHS_RESEARCH:
+		for (PLAYER_RESEARCH const &research : asPlayerResList[player])
+		{
+			int64_t values[] = {research.currentPoints, research.ResearchStatus, research.possible};
+			crc = hashInts(crc, values);
+		}
+		break;
+	case SHS_RANDOM:
+		crc = player == 0 ? gameRandStateCrc() : 0;
+		break;
+	case SHS_COUNT:
+		break;
+	}
+
+	return crc;
+}
+
+static void stateHashWrite()
+{
+	if (hashBuffer.empty())
+	{
+		return;
+	}
+	if (WZ_PHYSFS_writeBytes(hashFile, &hashBuffer[0], hashBuffer.size()) != (PHYSFS_sint64)hashBuffer.size())
+	{
+		debug(LOG_ERROR, "Could not write to %s; PHYSFS error: %s", hashFileName.c_str(), WZ_PHYSFS_getLastError());
+		PHYSFS_close(hashFile);
+		hashFile = nullptr;
+		hashFailed = true;
+	}
+	hashBuffer.clear();
+}
+
+void stateHashTick()
+{
+	if (hashFileName.empty() || hashFailed)
+	{
+		return;
+	}
+
+	if (hashFile == nullptr)
+	{
+		hashFile = PHYSFS_openWrite(hashFileName.c_str());
+		if (hashFile == nullptr)
+		{
+			debug(LOG_ERROR, "%s could not be opened: %s", hashFileName.c_str(), WZ_PHYSFS_getLastError());
+			hashFailed = true;
+			return;
+		}
+		debug(LOG_INFO, "Writing state hashes to %s", hashFileName.c_str());
+		hashBuffer.assign(STATE_HASH_MAGIC, STATE_HASH_MAGIC + 4);
+		putUint32(hashBuffer, STATE_HASH_VERSION);
+		putUint32(hashBuffer, SHS_COUNT);
+		putUint32(hashBuffer, MAX_PLAYERS);
+		for (int i = 0; i < SHS_COUNT; ++i)
+		{
+			hashBuffer.insert(hashBuffer.end(), stateHashNames[i], stateHashNames[i] + strlen(stateHashNames[i]) + 1);
+		}
+	}
+
+	uint32_t hashes[SHS_COUNT * MAX_PLAYERS];
+	jobParallelFor(SHS_COUNT * MAX_PLAYERS, [&hashes](unsigned n) {
+		hashes[n] = stateHash(STATE_HASH_SUBSYSTEM(n / MAX_PLAYERS), n % MAX_PLAYERS);
+	});
+
+	putUint32(hashBuffer, gameTime);
+	for (uint32_t hash : hashes)
+	{
+		putUint32(hashBuffer, hash);
+	}
+
+	if (hashBuffer.size() >= STATE_HASH_FLUSH)
+	{
+		stateHashWrite();
+	}
+}
+
+void stateHashShutdown()
+{
+	if (hashFile != nullptr)
+	{
+		stateHashWrite();
+		if (hashFile != nullptr)
+		{
+			PHYSFS_close(hashFile);
+			hashFile = nullptr;
+		}
+	}
+	hashBuffer.clear();
+	hashFailed = false;
+}
+
+void stateHashSetFile(std::string const &filename)
+{
+	stateHashShutdown();
+	hashFileName = filename;
+}
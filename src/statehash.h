@@ -0,0 +1,55 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Per-tick hashes of the synchronised game state, split by subsystem and player.
+ *
+ *  Unlike the syncDebug() CRC, which only says that two clients did something differently somewhere, comparing
+ *  two clients' hash streams with tools/desync/desyncbisect says which tick, subsystem and player went wrong first.
+ *
+ *  The stream starts with the magic "WZSH", a 32-bit version, the number of subsystems and players, and the
+ *  NUL-terminated subsystem names. Then each tick is a 32-bit gameTime followed by one 32-bit hash per subsystem
+ *  and player, subsystem major. All integers are big endian.
+ */
+
+#ifndef __INCLUDED_SRC_STATEHASH_H__
+#define __INCLUDED_SRC_STATEHASH_H__
+
+#include <string>
+
+enum STATE_HASH_SUBSYSTEM
+{
+	SHS_DROIDS,
+	SHS_STRUCTURES,
+	SHS_FEATURES,     ///< Features have no owner, so only player 0 is used.
+	SHS_POWER,
+	SHS_RESEARCH,
+	SHS_RANDOM,       ///< The synchronised random number generator, only player 0 is used.
+	SHS_COUNT
+};
+
+/// Call at the end of each game state update, hashes the state and writes it to the file, if any.
+void stateHashTick();
+
+/// Closes the file, if any.
+void stateHashShutdown();
+
+/// Write the state hashes of all following ticks to the given file in the write directory. Empty to disable.
+void stateHashSetFile(std::string const &filename);
+
+#endif // __INCLUDED_SRC_STATEHASH_H__
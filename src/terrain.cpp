@@ -33,6 +33,7 @@
 
 #include "lib/framework/frame.h"
 #include "lib/framework/opengl.h"
+#include "lib/framework/math_ext.h"
 #include "lib/ivis_opengl/ivisdef.h"
 #include "lib/ivis_opengl/imd.h"
 #include "lib/ivis_opengl/piefunc.h"
@@ -100,6 +101,19 @@ static int lightmapHeight;
 static GLubyte *lightmapPixmap;
 /// Ticks per lightmap refresh
 static const unsigned int LIGHTMAP_REFRESH = 80;
+/// Tiles whose lightmap texel has to be recalculated at the next refresh
+static std::vector<int> lightmapDirtyTiles;
+/// Whether a tile is already in lightmapDirtyTiles
+static std::vector<uint8_t> lightmapDirtyFlags;
+/// Recalculate every texel at the next refresh
+static bool lightmapRefreshAll;
+/// State the lightmap was last calculated with, a change means everything must be recalculated
+static bool lightmapFogStatus;
+static bool lightmapShowGateways;
+/// Tiles around the edge of the visible area that were faded at the last refresh, only used without fog
+static int lightmapFadeX0, lightmapFadeY0, lightmapFadeX1, lightmapFadeY1;
+/// Camera position the fade was last calculated for
+static Vector2f lightmapFadeCentre;
 
 /// VBOs
 static gfx_api::buffer *geometryVBO = nullptr, *geometryIndexVBO = nullptr, *textureVBO = nullptr, *textureIndexVBO = nullptr, *decalVBO = nullptr;
@@ -214,7 +228,26 @@ void setTileColour(int x, int y, PIELIGHT colour)
 {
 	MAPTILE *psTile = mapTile(x, y);
 
-	psTile->colour = colour;
+	if (psTile->colour.rgba != colour.rgba)
+	{
+		psTile->colour = colour;
+		markLightmapDirty(x, y);
+	}
+}
+
+/// Make the lightmap texel of the tile be recalculated at the next refresh
+void markLightmapDirty(int x, int y)
+{
+	if (x < 0 || y < 0 || x >= mapWidth || y >= mapHeight)
+	{
+		return;
+	}
+	size_t i = x + y * mapWidth;
+	if (i < lightmapDirtyFlags.size() && !lightmapDirtyFlags[i])
+	{
+		lightmapDirtyFlags[i] = 1;
+		lightmapDirtyTiles.push_back(i);
+	}
 }
 
 // NOTE:  The current (max) texture size of a tile is 128x128.  We allow up to a user defined texture size
@@ -940,6 +973,10 @@ bool initTerrain()
 
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, lightmapWidth, lightmapHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, lightmapPixmap);
 
+	lightmapDirtyTiles.clear();
+	lightmapDirtyFlags.assign(mapWidth * mapHeight, 0);
+	lightmapRefreshAll = true;
+
 	terrainInitialised = true;
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);  // HACK Must unbind GL_ARRAY_BUFFER (in this function, at least), otherwise text rendering may mysteriously crash.
@@ -987,77 +1024,175 @@ void shutdownTerrain()
 	lightmap_tex_num = nullptr;
 	free(lightmapPixmap);
 	lightmapPixmap = nullptr;
+	lightmapDirtyTiles.clear();
+	lightmapDirtyFlags.clear();
 
 	terrainInitialised = false;
 }
 
-static void updateLightMap()
+/// Recalculate the lightmap texel of a single tile, returns whether it changed.
+static bool updateLightMapTile(int i, int j, float playerX, float playerY)
 {
-	for (int j = 0; j < mapHeight; ++j)
+	MAPTILE *psTile = mapTile(i, j);
+	PIELIGHT colour = psTile->colour;
+	GLubyte *texel = &lightmapPixmap[(i + j * lightmapWidth) * 3];
+
+	if (psTile->tileInfoBits & BITS_GATEWAY && showGateways)
+	{
+		colour.byte.g = 255;
+	}
+	if (psTile->tileInfoBits & BITS_MARKED)
+	{
+		int m = getModularScaledGraphicsTime(2048, 255);
+		colour.byte.r = MAX(m, 255 - m);
+	}
+
+	GLubyte r = colour.byte.r, g = colour.byte.g, b = colour.byte.b;
+
+	if (!lightmapFogStatus)
 	{
-		for (int i = 0; i < mapWidth; ++i)
+		// fade to black at the edges of the visible terrain area
+		const float distA = i - (playerX - visibleTiles.x / 2);
+		const float distB = (playerX + visibleTiles.x / 2) - i;
+		const float distC = j - (playerY - visibleTiles.y / 2);
+		const float distD = (playerY + visibleTiles.y / 2) - j;
+		float darken, distToEdge;
+
+		// calculate the distance to the closest edge of the visible map
+		// determine the smallest distance
+		distToEdge = distA;
+		if (distB < distToEdge)
+		{
+			distToEdge = distB;
+		}
+		if (distC < distToEdge)
 		{
-			MAPTILE *psTile = mapTile(i, j);
-			PIELIGHT colour = psTile->colour;
+			distToEdge = distC;
+		}
+		if (distD < distToEdge)
+		{
+			distToEdge = distD;
+		}
 
-			if (psTile->tileInfoBits & BITS_GATEWAY && showGateways)
-			{
-				colour.byte.g = 255;
-			}
-			if (psTile->tileInfoBits & BITS_MARKED)
-			{
-				int m = getModularScaledGraphicsTime(2048, 255);
-				colour.byte.r = MAX(m, 255 - m);
-			}
+		darken = (distToEdge) / 2.0f;
+		if (darken <= 0)
+		{
+			r = g = b = 0;
+		}
+		else if (darken < 1)
+		{
+			r *= darken;
+			g *= darken;
+			b *= darken;
+		}
+	}
 
-			lightmapPixmap[(i + j * lightmapWidth) * 3 + 0] = colour.byte.r;
-			lightmapPixmap[(i + j * lightmapWidth) * 3 + 1] = colour.byte.g;
-			lightmapPixmap[(i + j * lightmapWidth) * 3 + 2] = colour.byte.b;
+	if (texel[0] == r && texel[1] == g && texel[2] == b)
+	{
+		return false;
+	}
+	texel[0] = r;
+	texel[1] = g;
+	texel[2] = b;
+	return true;
+}
 
-			if (!pie_GetFogStatus())
+/**
+ * Recalculate the lightmap texels which may have changed since the last refresh. Those are the tiles whose colour,
+ * gateway or mark flags changed, the marked tiles since they pulse, and without fog the tiles around the visible
+ * area if the camera moved. Returns the range of rows that changed in *firstRow and *lastRow, which is empty if
+ * *firstRow > *lastRow.
+ */
+static void updateLightMap(int *firstRow, int *lastRow)
+{
+	const float playerX = map_coordf(player.p.x);
+	const float playerY = map_coordf(player.p.z);
+	int fadeX0 = 0, fadeY0 = 0, fadeX1 = 0, fadeY1 = 0;
+	std::vector<int> tiles;
+
+	*firstRow = mapHeight;
+	*lastRow = -1;
+
+	if (lightmapFogStatus != pie_GetFogStatus() || lightmapShowGateways != showGateways)
+	{
+		lightmapFogStatus = pie_GetFogStatus();
+		lightmapShowGateways = showGateways;
+		lightmapRefreshAll = true;
+	}
+	if (!lightmapFogStatus)
+	{
+		// everything outside this area is black
+		fadeX0 = clip((int)floorf(playerX - visibleTiles.x / 2), 0, mapWidth);
+		fadeX1 = clip((int)ceilf(playerX + visibleTiles.x / 2) + 1, 0, mapWidth);
+		fadeY0 = clip((int)floorf(playerY - visibleTiles.y / 2), 0, mapHeight);
+		fadeY1 = clip((int)ceilf(playerY + visibleTiles.y / 2) + 1, 0, mapHeight);
+	}
+
+	if (lightmapRefreshAll)
+	{
+		lightmapRefreshAll = false;
+		for (int tile : lightmapDirtyTiles)
+		{
+			lightmapDirtyFlags[tile] = 0;
+		}
+		lightmapDirtyTiles.clear();
+		for (int j = 0; j < mapHeight; ++j)
+		{
+			for (int i = 0; i < mapWidth; ++i)
 			{
-				// fade to black at the edges of the visible terrain area
-				const float playerX = map_coordf(player.p.x);
-				const float playerY = map_coordf(player.p.z);
-
-				const float distA = i - (playerX - visibleTiles.x / 2);
-				const float distB = (playerX + visibleTiles.x / 2) - i;
-				const float distC = j - (playerY - visibleTiles.y / 2);
-				const float distD = (playerY + visibleTiles.y / 2) - j;
-				float darken, distToEdge;
-
-				// calculate the distance to the closest edge of the visible map
-				// determine the smallest distance
-				distToEdge = distA;
-				if (distB < distToEdge)
+				updateLightMapTile(i, j, playerX, playerY);
+				if (mapTile(i, j)->tileInfoBits & BITS_MARKED)
 				{
-					distToEdge = distB;
-				}
-				if (distC < distToEdge)
-				{
-					distToEdge = distC;
-				}
-				if (distD < distToEdge)
-				{
-					distToEdge = distD;
+					markLightmapDirty(i, j);
 				}
+			}
+		}
+		*firstRow = 0;
+		*lastRow = mapHeight - 1;
+	}
+	else
+	{
+		tiles.swap(lightmapDirtyTiles);
+		for (int tile : tiles)
+		{
+			const int i = tile % mapWidth, j = tile / mapWidth;
 
-				darken = (distToEdge) / 2.0f;
-				if (darken <= 0)
-				{
-					lightmapPixmap[(i + j * lightmapWidth) * 3 + 0] = 0;
-					lightmapPixmap[(i + j * lightmapWidth) * 3 + 1] = 0;
-					lightmapPixmap[(i + j * lightmapWidth) * 3 + 2] = 0;
-				}
-				else if (darken < 1)
+			lightmapDirtyFlags[tile] = 0;
+			if (updateLightMapTile(i, j, playerX, playerY))
+			{
+				*firstRow = std::min(*firstRow, j);
+				*lastRow = std::max(*lastRow, j);
+			}
+			if (psMapTiles[tile].tileInfoBits & BITS_MARKED)
+			{
+				markLightmapDirty(i, j);  // keep pulsing
+			}
+		}
+		if (!lightmapFogStatus && lightmapFadeCentre != Vector2f(playerX, playerY))
+		{
+			// the fade depends on the exact camera position, so redo both the old and the new area
+			const int x0 = std::min(fadeX0, lightmapFadeX0), x1 = std::max(fadeX1, lightmapFadeX1);
+			const int y0 = std::min(fadeY0, lightmapFadeY0), y1 = std::max(fadeY1, lightmapFadeY1);
+
+			for (int j = y0; j < y1; ++j)
+			{
+				for (int i = x0; i < x1; ++i)
 				{
-					lightmapPixmap[(i + j * lightmapWidth) * 3 + 0] *= darken;
-					lightmapPixmap[(i + j * lightmapWidth) * 3 + 1] *= darken;
-					lightmapPixmap[(i + j * lightmapWidth) * 3 + 2] *= darken;
+					if (updateLightMapTile(i, j, playerX, playerY))
+					{
+						*firstRow = std::min(*firstRow, j);
+						*lastRow = std::max(*lastRow, j);
+					}
 				}
 			}
 		}
 	}
+
+	lightmapFadeX0 = fadeX0;
+	lightmapFadeX1 = fadeX1;
+	lightmapFadeY0 = fadeY0;
+	lightmapFadeY1 = fadeY1;
+	lightmapFadeCentre = Vector2f(playerX, playerY);
 }
 
 static void cullTerrain()
@@ -1291,11 +1426,16 @@ void drawTerrain(const glm::mat4 &mvp)
 	// we limit the framerate of the lightmap, because updating a texture is an expensive operation
 	if (realTime - lightmapLastUpdate >= LIGHTMAP_REFRESH)
 	{
+		int firstRow, lastRow;
+
 		lightmapLastUpdate = realTime;
-		updateLightMap();
+		updateLightMap(&firstRow, &lastRow);
 
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-		lightmap_tex_num->upload(0, 0, 0, lightmapWidth, lightmapHeight, gfx_api::pixel_format::rgb, lightmapPixmap);
+		if (firstRow <= lastRow)
+		{
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			lightmap_tex_num->upload(0, 0, firstRow, lightmapWidth, lastRow - firstRow + 1, gfx_api::pixel_format::rgb, &lightmapPixmap[firstRow * lightmapWidth * 3]);
+		}
 	}
 
 	///////////////////////////////////
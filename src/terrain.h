@@ -34,5 +34,6 @@ PIELIGHT getTileColour(int x, int y);
 void setTileColour(int x, int y, PIELIGHT colour);
 
 void markTileDirty(int i, int j);
+void markLightmapDirty(int x, int y);
 
 #endif
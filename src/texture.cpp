@@ -109,6 +109,31 @@ static int newPage(const char *name, int level, int width, int height, int count
 	return texPage;
 }
 
+/// Decode the tiles that texLoad() will upload, from any thread
+void texPreload(const char *fileName)
+{
+	char fullPath[PATH_MAX];
+
+	// Same levels as texLoad(), except for any reduction due to the maximum OpenGL texture size
+	int size = MIPMAP_MAX;
+	while (maxTextureSize < size)
+	{
+		size /= 2;
+	}
+	for (; size >= MIPMAP_MAX >> (MIPMAP_LEVELS - 1); size /= 2)
+	{
+		for (int k = 0; k < MAX_TILES; k++)
+		{
+			snprintf(fullPath, sizeof(fullPath), "%s-%d/tile-%02d.png", fileName, size, k);
+			if (!PHYSFS_exists(fullPath))
+			{
+				break;
+			}
+			iV_preloadImage_PNG(fullPath);
+		}
+	}
+}
+
 bool texLoad(const char *fileName)
 {
 	char fullPath[PATH_MAX], partialPath[PATH_MAX], *buffer;
@@ -24,6 +24,7 @@
 #include "display3ddef.h"
 
 bool texLoad(const char *fileName);
+void texPreload(const char *fileName);
 
 struct TILE_TEX_INFO
 {
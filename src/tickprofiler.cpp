@@ -0,0 +1,221 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file tickprofiler.cpp
+ *
+ * CPU time spent per subsystem in each game tick.
+ *
+ */
+
+#include <chrono>
+
+#include "lib/framework/frame.h"
+#include "lib/framework/physfs_ext.h"
+#include "lib/gamelib/gtime.h"
+
+#include "tickprofiler.h"
+
+struct TICK_PROFILE
+{
+	uint32_t gameTime;
+	int64_t  start;                  ///< Microseconds, since the profiler started.
+	uint32_t total;                  ///< Microseconds for the whole tick.
+	uint32_t first[TPP_COUNT];       ///< Microseconds from the start of the tick, until a point was first entered.
+	uint32_t duration[TPP_COUNT];    ///< Microseconds spent in each point, summed over all players.
+};
+
+static const char *tickProfileNames[TPP_COUNT] =
+{
+	"updateScripts",
+	"visUpdateLevel",
+	"gridReset",
+	"processVisibility",
+	"mapUpdate",
+	"fpathUpdate",
+	"aiPrepareTargetSearches",
+	"updatePlayerPower",
+	"droidUpdate",
+	"missionDroidUpdate",
+	"structureUpdate",
+	"proj_UpdateAll",
+	"featureUpdate",
+	"objmemUpdate",
+};
+
+static TICK_PROFILE tickHistory[TICK_PROFILE_HISTORY];
+static unsigned     tickHistoryCount = 0;    ///< Number of valid entries in tickHistory.
+static unsigned     tickHistoryNext = 0;     ///< Where the next tick goes.
+static TICK_PROFILE currentTick;
+static bool         tickRunning = false;
+
+static std::string  traceFileName;
+static PHYSFS_file  *traceFile = nullptr;
+static bool         traceFailed = false;
+static bool         traceEmpty = true;       ///< No events written yet, so the next one needs no separator.
+
+static int64_t tickProfileNow()
+{
+	static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+TickProfileScope::TickProfileScope(TICK_PROFILE_POINT pp)
+	: point(pp)
+	, start(tickProfileNow())
+{
+}
+
+TickProfileScope::~TickProfileScope()
+{
+	if (!tickRunning)
+	{
+		return;
+	}
+	int64_t end = tickProfileNow();
+	if (currentTick.duration[point] == 0)
+	{
+		currentTick.first[point] = start - currentTick.start;
+	}
+	currentTick.duration[point] += std::max<int64_t>(end - start, 1);  // Count at least 1 µs, so that first[] is only set once.
+}
+
+void tickProfileStartTick()
+{
+	memset(&currentTick, 0, sizeof(currentTick));
+	currentTick.gameTime = gameTime;
+	currentTick.start = tickProfileNow();
+	tickRunning = true;
+}
+
+static void tickProfileWriteTrace(TICK_PROFILE const &tick)
+{
+	if (traceFileName.empty() || traceFailed)
+	{
+		return;
+	}
+
+	std::string out;
+	if (traceFile == nullptr)
+	{
+		traceFile = PHYSFS_openWrite(traceFileName.c_str());
+		if (traceFile == nullptr)
+		{
+			debug(LOG_ERROR, "%s could not be opened: %s", traceFileName.c_str(), WZ_PHYSFS_getLastError());
+			traceFailed = true;
+			return;
+		}
+		debug(LOG_INFO, "Writing tick profile to %s", traceFileName.c_str());
+		out = "[";
+		traceEmpty = true;
+	}
+
+	// Trace event "complete" events, one for the tick and one for each point that was entered. Times in microseconds.
+	char buf[256];
+	ssprintf(buf, "%s\n{\"name\":\"gameStateUpdate\",\"cat\":\"tick\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%u,\"pid\":1,\"tid\":1,\"args\":{\"gameTime\":%u}}",
+	         traceEmpty ? "" : ",", (long long)tick.start, tick.total, tick.gameTime);
+	out += buf;
+	traceEmpty = false;
+	for (int i = 0; i < TPP_COUNT; ++i)
+	{
+		if (tick.duration[i] == 0)
+		{
+			continue;
+		}
+		ssprintf(buf, ",\n{\"name\":\"%s\",\"cat\":\"tick\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%u,\"pid\":1,\"tid\":1}",
+		         tickProfileNames[i], (long long)(tick.start + tick.first[i]), tick.duration[i]);
+		out += buf;
+	}
+
+	if (WZ_PHYSFS_writeBytes(traceFile, out.data(), out.size()) != (PHYSFS_sint64)out.size())
+	{
+		debug(LOG_ERROR, "Could not write to %s; PHYSFS error: %s", traceFileName.c_str(), WZ_PHYSFS_getLastError());
+		PHYSFS_close(traceFile);
+		traceFile = nullptr;
+		traceFailed = true;
+	}
+}
+
+void tickProfileEndTick()
+{
+	ASSERT_OR_RETURN(, tickRunning, "tickProfileEndTick() without tickProfileStartTick()");
+	tickRunning = false;
+	currentTick.total = tickProfileNow() - currentTick.start;
+
+	tickHistory[tickHistoryNext] = currentTick;
+	tickHistoryNext = (tickHistoryNext + 1) % TICK_PROFILE_HISTORY;
+	tickHistoryCount = std::min<unsigned>(tickHistoryCount + 1, TICK_PROFILE_HISTORY);
+
+	tickProfileWriteTrace(currentTick);
+}
+
+void tickProfileShutdown()
+{
+	if (traceFile != nullptr)
+	{
+		// The trace format allows leaving out the end of the array, but other JSON readers don't.
+		static const char end[] = "\n]\n";
+		WZ_PHYSFS_writeBytes(traceFile, end, sizeof(end) - 1);
+		PHYSFS_close(traceFile);
+		traceFile = nullptr;
+	}
+	traceFailed = false;
+}
+
+void tickProfileSetTraceFile(std::string const &filename)
+{
+	tickProfileShutdown();
+	traceFileName = filename;
+}
+
+const char *tickProfileName(TICK_PROFILE_POINT pp)
+{
+	ASSERT_OR_RETURN("", (unsigned)pp < TPP_COUNT, "Bad profile point %d", (int)pp);
+	return tickProfileNames[pp];
+}
+
+static uint32_t tickProfileValue(TICK_PROFILE const &tick, TICK_PROFILE_POINT pp)
+{
+	return pp == TPP_COUNT ? tick.total : tick.duration[pp];
+}
+
+unsigned tickProfileAverage(TICK_PROFILE_POINT pp, unsigned numTicks)
+{
+	numTicks = std::min(numTicks, tickHistoryCount);
+	if (numTicks == 0)
+	{
+		return 0;
+	}
+	uint64_t sum = 0;
+	for (unsigned n = 0; n < numTicks; ++n)
+	{
+		sum += tickProfileValue(tickHistory[(tickHistoryNext + TICK_PROFILE_HISTORY - 1 - n) % TICK_PROFILE_HISTORY], pp);
+	}
+	return sum / numTicks;
+}
+
+unsigned tickProfileMaximum(TICK_PROFILE_POINT pp, unsigned numTicks)
+{
+	numTicks = std::min(numTicks, tickHistoryCount);
+	uint32_t max = 0;
+	for (unsigned n = 0; n < numTicks; ++n)
+	{
+		max = std::max(max, tickProfileValue(tickHistory[(tickHistoryNext + TICK_PROFILE_HISTORY - 1 - n) % TICK_PROFILE_HISTORY], pp));
+	}
+	return max;
+}
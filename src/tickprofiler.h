@@ -0,0 +1,86 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Measures how much CPU time each subsystem takes during gameStateUpdate().
+ *
+ *  The last TICK_PROFILE_HISTORY ticks are kept in a ring buffer for the in-game overlay.
+ *  If a trace file is set, every tick is also written to it in the Chrome trace event
+ *  format, which can be opened with chrome://tracing or similar tools.
+ */
+
+#ifndef __INCLUDED_SRC_TICKPROFILER_H__
+#define __INCLUDED_SRC_TICKPROFILER_H__
+
+#include <string>
+
+#define TICK_PROFILE_HISTORY	256	///< Number of ticks remembered for the overlay.
+
+enum TICK_PROFILE_POINT
+{
+	TPP_SCRIPTS,
+	TPP_VISIBILITY_LEVEL,
+	TPP_GRID_RESET,
+	TPP_VISIBILITY,
+	TPP_MAP,
+	TPP_PATHFINDING,
+	TPP_AI_PREPARE,
+	TPP_POWER,
+	TPP_DROIDS,
+	TPP_MISSION_DROIDS,
+	TPP_STRUCTURES,
+	TPP_PROJECTILES,
+	TPP_FEATURES,
+	TPP_OBJMEM,
+	TPP_COUNT
+};
+
+/// Measures the time from construction to destruction, and adds it to the given point of the current tick.
+class TickProfileScope
+{
+public:
+	explicit TickProfileScope(TICK_PROFILE_POINT pp);
+	~TickProfileScope();
+
+private:
+	TICK_PROFILE_POINT point;
+	int64_t start;
+};
+
+/// Call at the start of each game state update.
+void tickProfileStartTick();
+
+/// Call at the end of each game state update, stores the tick in the history and the trace file.
+void tickProfileEndTick();
+
+/// Closes the trace file, if any.
+void tickProfileShutdown();
+
+/// Write all following ticks to the given file in the write directory. Empty to disable.
+void tickProfileSetTraceFile(std::string const &filename);
+
+/// Human readable name of a profile point.
+const char *tickProfileName(TICK_PROFILE_POINT pp);
+
+/// Average time in microseconds spent in the given point over the last numTicks ticks. Use TPP_COUNT for the whole tick.
+unsigned tickProfileAverage(TICK_PROFILE_POINT pp, unsigned numTicks);
+
+/// Maximum time in microseconds spent in the given point over the last numTicks ticks. Use TPP_COUNT for the whole tick.
+unsigned tickProfileMaximum(TICK_PROFILE_POINT pp, unsigned numTicks);
+
+#endif // __INCLUDED_SRC_TICKPROFILER_H__
@@ -22,6 +22,9 @@
  * Handles object visibility.
  * Pumpkin Studios, Eidos Interactive 1996.
  */
+#include <list>
+#include <unordered_map>
+
 #include "lib/framework/frame.h"
 #include "lib/framework/fixedpoint.h"
 
@@ -120,10 +123,11 @@ void visUpdateLevel()
 
 static inline void updateTileVis(MAPTILE *psTile)
 {
+	MAPTILE_VISION const *psVision = mapTileVision(psTile);
 	for (int i = 0; i < MAX_PLAYERS; i++)
 	{
 		/// The definition of whether a player can see something on a given tile or not
-		if (psTile->watchers[i] > 0 || (psTile->sensors[i] > 0 && !(psTile->jammerBits & ~alliancebits[i])))
+		if (psVision->watchers[i] > 0 || (psVision->sensors[i] > 0 && !(psTile->jammerBits & ~alliancebits[i])))
 		{
 			psTile->sensorBits |= (1 << i);         // mark it as being seen
 		}
@@ -150,7 +154,7 @@ uint32_t addSpotter(int x, int y, int player, int radius, bool radar, uint32_t e
 		}
 		MAPTILE *psTile = mapTile(mapX, mapY);
 		psTile->tileExploredBits |= alliancebits[player];
-		uint8_t *visionType = (!radar) ? psTile->watchers : psTile->sensors;
+		uint8_t *visionType = (!radar) ? mapTileVision(psTile)->watchers : mapTileVision(psTile)->sensors;
 		if (visionType[player] < UBYTE_MAX)
 		{
 			TILEPOS tilePos = {uint8_t(mapX), uint8_t(mapY), uint8_t(radar)};
@@ -218,7 +222,7 @@ SPOTTER::~SPOTTER()
 	{
 		const TILEPOS tilePos = watchedTiles[i];
 		MAPTILE *psTile = mapTile(tilePos.x, tilePos.y);
-		uint8_t *visionType = (tilePos.type == 0) ? psTile->watchers : psTile->sensors;
+		uint8_t *visionType = (tilePos.type == 0) ? mapTileVision(psTile)->watchers : mapTileVision(psTile)->sensors;
 		ASSERT(visionType[player] > 0, "Not watching watched tile (%d, %d)", (int)tilePos.x, (int)tilePos.y);
 		visionType[player]--;
 		updateTileVis(psTile);
@@ -237,7 +241,8 @@ static inline void visMarkTile(const BASE_OBJECT *psObj, int mapX, int mapY, MAP
 	const int ydiff = map_coord(psObj->pos.y) - mapY;
 	const int distSq = xdiff * xdiff + ydiff * ydiff;
 	const bool inRange = (distSq < 16);
-	uint8_t *visionType = inRange ? psTile->watchers : psTile->sensors;
+	MAPTILE_VISION *psVision = mapTileVision(psTile);
+	uint8_t *visionType = inRange ? psVision->watchers : psVision->sensors;
 
 	if (visionType[rayPlayer] < UBYTE_MAX && *lastRecordTilePos < MAX_SEEN_TILES)
 	{
@@ -246,7 +251,7 @@ static inline void visMarkTile(const BASE_OBJECT *psObj, int mapX, int mapY, MAP
 		visionType[rayPlayer]++;                        // we observe this tile
 		if (psObj->flags.test(OBJECT_FLAG_JAMMED_TILES))   // we are a jammer object
 		{
-			psTile->jammers[rayPlayer]++;
+			psVision->jammers[rayPlayer]++;
 			psTile->jammerBits |= (1 << rayPlayer); // mark it as being jammed
 		}
 		updateTileVis(psTile);
@@ -255,16 +260,83 @@ static inline void visMarkTile(const BASE_OBJECT *psObj, int mapX, int mapY, MAP
 	}
 }
 
-/* The terrain revealing ray callback */
-static void doWaveTerrain(const BASE_OBJECT *psObj, TILEPOS *recordTilePos, int *lastRecordTilePos)
+#define VIEWSHED_REGION_SHIFT 3  ///< Terrain changes are tracked in regions of 8×8 tiles.
+#define MAX_VIEWSHEDS 1024       ///< Least recently used viewsheds are dropped beyond this.
+
+/// What doWaveTerrain() found visible from a viewpoint. Only depends on the terrain within the wavecast radius.
+struct ViewshedKey
 {
-	const int sx = psObj->pos.x;
-	const int sy = psObj->pos.y;
-	const int sz = psObj->pos.z + MAX(MIN_VIS_HEIGHT, psObj->sDisplay.imd->max.y);
-	const unsigned radius = objSensorRange(psObj);
-	const int rayPlayer = psObj->player;
-	size_t size;
-	const WavecastTile *tiles = getWavecastTable(radius, &size);
+	bool operator ==(ViewshedKey const &b) const
+	{
+		return x == b.x && y == b.y && z == b.z && radius == b.radius;
+	}
+
+	int x, y;         ///< Tile of the viewer.
+	int z;            ///< Eye height.
+	unsigned radius;  ///< Sensor range.
+};
+
+struct ViewshedKeyHash
+{
+	size_t operator ()(ViewshedKey const &key) const
+	{
+		return ((size_t(key.x) * 257 + key.y) * 65537 + key.z) * 31 + key.radius;
+	}
+};
+
+struct Viewshed
+{
+	ViewshedKey key;
+	uint32_t computedAt;                ///< terrainChangeCount when computed. Stale if any region it covers changed since.
+	Vector2i regionMin, regionMax;      ///< Regions covered by the wavecast, inclusive.
+	std::vector<uint16_t> visibleTiles; ///< Indices into the wavecast table of the visible tiles, in wavecast order.
+};
+
+static std::list<Viewshed> viewsheds;  ///< Most recently used first.
+static std::unordered_map<ViewshedKey, std::list<Viewshed>::iterator, ViewshedKeyHash> viewshedIndex;
+static MAPTILE const *viewshedMap = nullptr;    ///< The map the viewsheds are for, since mission maps get swapped in and out.
+static std::vector<uint32_t> regionChangedAt;  ///< Value of terrainChangeCount when a tile height in the region last changed.
+static uint32_t terrainChangeCount = 0;
+
+void visMapChanged()
+{
+	viewsheds.clear();
+	viewshedIndex.clear();
+	viewshedMap = psMapTiles;
+	regionChangedAt.assign(((mapWidth >> VIEWSHED_REGION_SHIFT) + 1) * ((mapHeight >> VIEWSHED_REGION_SHIFT) + 1), 0);
+	terrainChangeCount = 0;
+}
+
+void visTerrainChanged(int x, int y)
+{
+	if (viewshedMap != psMapTiles || x < 0 || x >= mapWidth || y < 0 || y >= mapHeight)
+	{
+		return;
+	}
+	int regionsX = (mapWidth >> VIEWSHED_REGION_SHIFT) + 1;
+	regionChangedAt[(y >> VIEWSHED_REGION_SHIFT) * regionsX + (x >> VIEWSHED_REGION_SHIFT)] = ++terrainChangeCount;
+}
+
+static bool viewshedValid(Viewshed const &viewshed)
+{
+	int regionsX = (mapWidth >> VIEWSHED_REGION_SHIFT) + 1;
+	for (int y = viewshed.regionMin.y; y <= viewshed.regionMax.y; ++y)
+	{
+		for (int x = viewshed.regionMin.x; x <= viewshed.regionMax.x; ++x)
+		{
+			if (regionChangedAt[y * regionsX + x] > viewshed.computedAt)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/* The terrain revealing wavecast */
+static void computeViewshed(Viewshed &viewshed, const WavecastTile *tiles, size_t size)
+{
+	const int sz = viewshed.key.z;
 #define MAX_WAVECAST_LIST_SIZE 1360  // Trivial upper bound to what a fully upgraded WSS can use (its number of angles). Should probably be some factor times the maximum possible radius. Is probably a lot more than needed. Tested to need at least 180.
 	int heights[2][MAX_WAVECAST_LIST_SIZE];
 	size_t angles[2][MAX_WAVECAST_LIST_SIZE + 1];
@@ -272,20 +344,27 @@ static void doWaveTerrain(const BASE_OBJECT *psObj, TILEPOS *recordTilePos, int
 	int readList = 0;  // Reading from this list, writing to the other. Could also initialise to rand()%2.
 	int lastHeight = 0;  // lastHeight dummy initialisation.
 	size_t lastAngle = std::numeric_limits<size_t>::max();
+	Vector2i tileMin(mapWidth, mapHeight), tileMax(-1, -1);  // Empty until a tile on the map is looked at.
+	bool overflow = false;
+
+	ASSERT(size <= 0xFFFF, "Wavecast table too large for viewshed indices");
 
 	// Start with full vision of all angles. (If someday wanting to make droids that can only look in one direction, change here, after getting the original angle values saved in the wavecast table.)
 	heights[!readList][writeListPos] = -0x7FFFFFFF - 1; // Smallest integer.
 	angles[!readList][writeListPos] = 0;               // Smallest angle.
 	++writeListPos;
 
+	viewshed.visibleTiles.clear();
 	for (size_t i = 0; i < size; ++i)
 	{
-		const int mapX = map_coord(sx) + tiles[i].dx;
-		const int mapY = map_coord(sy) + tiles[i].dy;
+		const int mapX = viewshed.key.x + tiles[i].dx;
+		const int mapY = viewshed.key.y + tiles[i].dy;
 		if (mapX < 0 || mapX >= mapWidth || mapY < 0 || mapY >= mapHeight)
 		{
 			continue;
 		}
+		tileMin = Vector2i(std::min(tileMin.x, mapX), std::min(tileMin.y, mapY));
+		tileMax = Vector2i(std::max(tileMax.x, mapX), std::max(tileMax.y, mapY));
 
 		MAPTILE *psTile = mapTile(mapX, mapY);
 		int tileHeight = std::max(psTile->height, psTile->waterLevel);  // If we can see the water surface, then let us see water-covered tiles too.
@@ -323,18 +402,82 @@ static void doWaveTerrain(const BASE_OBJECT *psObj, TILEPOS *recordTilePos, int
 				angles[!readList][writeListPos] = MAX(angles[readList][readListPos], tiles[i].angBegin);
 				lastHeight = newHeight;
 				++writeListPos;
-				ASSERT_OR_RETURN(, writeListPos <= MAX_WAVECAST_LIST_SIZE, "Visibility too complicated! Need to increase MAX_WAVECAST_LIST_SIZE.");
+				if (writeListPos > MAX_WAVECAST_LIST_SIZE)
+				{
+					ASSERT(false, "Visibility too complicated! Need to increase MAX_WAVECAST_LIST_SIZE.");
+					overflow = true;
+					break;
+				}
 			}
 			++readListPos;
 		}
 		--readListPos;
 
+		if (overflow)
+		{
+			break;  // Keep the tiles seen so far.
+		}
 		if (seen)
 		{
-			// Can see this tile.
-			psTile->tileExploredBits |= alliancebits[rayPlayer];                        // Share exploration with allies too
-			visMarkTile(psObj, mapX, mapY, psTile, recordTilePos, lastRecordTilePos);   // Mark this tile as seen by our sensor
+			viewshed.visibleTiles.push_back(i);  // Can see this tile.
+		}
+	}
+
+	viewshed.regionMin = Vector2i(tileMin.x >> VIEWSHED_REGION_SHIFT, tileMin.y >> VIEWSHED_REGION_SHIFT);
+	viewshed.regionMax = Vector2i(tileMax.x >> VIEWSHED_REGION_SHIFT, tileMax.y >> VIEWSHED_REGION_SHIFT);
+}
+
+/// Returns the cached viewshed for the viewpoint, computing it if there is none or the terrain around it changed.
+static Viewshed const &getViewshed(ViewshedKey const &key, const WavecastTile *tiles, size_t size)
+{
+	if (viewshedMap != psMapTiles)
+	{
+		visMapChanged();
+	}
+
+	auto it = viewshedIndex.find(key);
+	if (it != viewshedIndex.end())
+	{
+		if (viewshedValid(*it->second))
+		{
+			viewsheds.splice(viewsheds.begin(), viewsheds, it->second);
+			return viewsheds.front();
 		}
+		viewsheds.erase(it->second);
+		viewshedIndex.erase(it);
+	}
+
+	viewsheds.emplace_front();
+	Viewshed &viewshed = viewsheds.front();
+	viewshed.key = key;
+	viewshed.computedAt = terrainChangeCount;
+	computeViewshed(viewshed, tiles, size);
+	viewshedIndex[key] = viewsheds.begin();
+	if (viewsheds.size() > MAX_VIEWSHEDS)
+	{
+		viewshedIndex.erase(viewsheds.back().key);
+		viewsheds.pop_back();
+	}
+	return viewshed;
+}
+
+/* The terrain revealing ray callback */
+static void doWaveTerrain(const BASE_OBJECT *psObj, TILEPOS *recordTilePos, int *lastRecordTilePos)
+{
+	const ViewshedKey key = {map_coord(psObj->pos.x), map_coord(psObj->pos.y), psObj->pos.z + MAX(MIN_VIS_HEIGHT, psObj->sDisplay.imd->max.y), (unsigned)objSensorRange(psObj)};
+	const int rayPlayer = psObj->player;
+	size_t size;
+	const WavecastTile *tiles = getWavecastTable(key.radius, &size);
+	Viewshed const &viewshed = getViewshed(key, tiles, size);
+
+	for (uint16_t i : viewshed.visibleTiles)
+	{
+		const int mapX = key.x + tiles[i].dx;
+		const int mapY = key.y + tiles[i].dy;
+		MAPTILE *psTile = mapTile(mapX, mapY);
+
+		psTile->tileExploredBits |= alliancebits[rayPlayer];                        // Share exploration with allies too
+		visMarkTile(psObj, mapX, mapY, psTile, recordTilePos, lastRecordTilePos);   // Mark this tile as seen by our sensor
 	}
 }
 
@@ -393,9 +536,10 @@ void visRemoveVisibility(BASE_OBJECT *psObj)
 			const TILEPOS pos = psObj->watchedTiles[i];
 			// FIXME: the mapTile might have been swapped out, see swapMissionPointers()
 			MAPTILE *psTile = mapTile(pos.x, pos.y);
+			MAPTILE_VISION *psVision = mapTileVision(psTile);
 
 			ASSERT(pos.type < 2, "Invalid visibility type %d", (int)pos.type);
-			uint8_t *visionType = (pos.type == 0) ? psTile->sensors : psTile->watchers;
+			uint8_t *visionType = (pos.type == 0) ? psVision->sensors : psVision->watchers;
 			if (visionType[psObj->player] == 0 && game.type == CAMPAIGN)	// hack
 			{
 				continue;
@@ -405,9 +549,9 @@ void visRemoveVisibility(BASE_OBJECT *psObj)
 			if (psObj->flags.test(OBJECT_FLAG_JAMMED_TILES))  // we are a jammer object — we cannot check objJammerPower(psObj) > 0 directly here, we may be in the BASE_OBJECT destructor).
 			{
 				// No jammers in campaign, no need for special hack
-				ASSERT(psTile->jammers[psObj->player] > 0, "Not jamming watched tile (%d, %d)", (int)pos.x, (int)pos.y);
-				psTile->jammers[psObj->player]--;
-				if (psTile->jammers[psObj->player] == 0)
+				ASSERT(psVision->jammers[psObj->player] > 0, "Not jamming watched tile (%d, %d)", (int)pos.x, (int)pos.y);
+				psVision->jammers[psObj->player]--;
+				if (psVision->jammers[psObj->player] == 0)
 				{
 					psTile->jammerBits &= ~(1 << psObj->player);
 				}
@@ -598,12 +742,13 @@ int visibleObject(const BASE_OBJECT *psViewer, const BASE_OBJECT *psTarget, bool
 	int targetGrad = top * GRAD_MUL / MAX(1, help.lastDist);
 
 	// Show objects hidden by ECM jamming with radar blips
-	if (psTile->watchers[psViewer->player] == 0 && psTile->sensors[psViewer->player] > 0 && jammed)
+	MAPTILE_VISION const *psVision = mapTileVision(psTile);
+	if (psVision->watchers[psViewer->player] == 0 && psVision->sensors[psViewer->player] > 0 && jammed)
 	{
 		return UBYTE_MAX / 2;
 	}
 	// Show objects that are seen directly or with unjammed sensors
-	else if ((psTile->watchers[psViewer->player] > 0 && targetGrad >= help.currGrad) || (psTile->sensors[psViewer->player] > 0 && !jammed))
+	else if ((psVision->watchers[psViewer->player] > 0 && targetGrad >= help.currGrad) || (psVision->sensors[psViewer->player] > 0 && !jammed))
 	{
 		return UBYTE_MAX;
 	}
@@ -33,6 +33,9 @@ bool visInitialise();
 /* Check which tiles can be seen by an object */
 void visTilesUpdate(BASE_OBJECT *psObj);
 
+void visMapChanged();                 ///< Forgets all cached viewsheds, call when loading a map.
+void visTerrainChanged(int x, int y); ///< Call when the height of a tile changes, so cached viewsheds around it get recomputed.
+
 void revealAll(UBYTE player);
 
 /* Check whether psViewer can see psTarget
@@ -135,7 +135,7 @@ TITLECODE titleLoop()
 		// then check --join and if neither, run the normal game menu.
 		if (hostlaunch)
 		{
-			if (hostlaunch == 2)
+			if (hostlaunch == 2 || hostlaunch == 3)  // skirmish test or replay
 			{
 				SPinit();
 			}
@@ -0,0 +1,321 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*
+ * Stress test for the job system in lib/framework/jobsystem.cpp.
+ *
+ * Runs nested jobs, dependency chains, waits from inside and outside the workers, parallel loops, and more
+ * jobs at once than the queues hold, several times over, and checks that every job ran exactly once and in
+ * the order its dependencies require.
+ */
+
+#include "lib/framework/wzglobal.h"
+#include "lib/framework/types.h"
+#include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+#include "lib/framework/jobsystem.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --- thread support, which the game gets from lib/sdl ---
+
+struct WZ_THREAD
+{
+	int (*threadFunc)(void *);
+	void *data;
+	int result;
+	std::thread thread;
+};
+
+struct WZ_SEMAPHORE
+{
+	std::mutex mutex;
+	std::condition_variable condition;
+	int value;
+};
+
+WZ_THREAD *wzThreadCreate(int (*threadFunc)(void *), void *data)
+{
+	WZ_THREAD *thread = new WZ_THREAD;
+	thread->threadFunc = threadFunc;
+	thread->data = data;
+	thread->result = 0;
+	return thread;
+}
+
+void wzThreadStart(WZ_THREAD *thread)
+{
+	thread->thread = std::thread([thread]() {
+		thread->result = thread->threadFunc(thread->data);
+	});
+}
+
+int wzThreadJoin(WZ_THREAD *thread)
+{
+	thread->thread.join();
+	int result = thread->result;
+	delete thread;
+	return result;
+}
+
+void wzYieldCurrentThread()
+{
+	std::this_thread::yield();
+}
+
+WZ_SEMAPHORE *wzSemaphoreCreate(int startValue)
+{
+	WZ_SEMAPHORE *semaphore = new WZ_SEMAPHORE;
+	semaphore->value = startValue;
+	return semaphore;
+}
+
+void wzSemaphoreDestroy(WZ_SEMAPHORE *semaphore)
+{
+	delete semaphore;
+}
+
+void wzSemaphoreWait(WZ_SEMAPHORE *semaphore)
+{
+	std::unique_lock<std::mutex> lock(semaphore->mutex);
+	semaphore->condition.wait(lock, [semaphore]() { return semaphore->value > 0; });
+	--semaphore->value;
+}
+
+void wzSemaphorePost(WZ_SEMAPHORE *semaphore)
+{
+	std::lock_guard<std::mutex> lock(semaphore->mutex);
+	++semaphore->value;
+	semaphore->condition.notify_one();
+}
+
+// --- linking hacks ---
+
+void wzFatalDialog(char const *)
+{
+}
+
+int wzGetTicks()
+{
+	return 1;
+}
+
+// --- end linking hacks ---
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok)
+	{
+		fprintf(stderr, "jobtest: %s\n", what);
+		++failures;
+	}
+}
+
+/// Jobs submitting jobs, which go to the workers' own deques, and waiting for them from inside the workers.
+static void testNested()
+{
+	const unsigned numParents = 64, numChildren = 200;
+	std::atomic<unsigned> count(0);
+	std::vector<JobHandle> parents;
+	for (unsigned i = 0; i < numParents; ++i)
+	{
+		parents.push_back(jobSubmit([&count]() {
+			std::vector<JobHandle> children;
+			for (unsigned j = 0; j < numChildren; ++j)
+			{
+				children.push_back(jobSubmit([&count]() {
+					++count;
+				}));
+			}
+			for (JobHandle const &child : children)
+			{
+				child.wait();
+				if (!child.finished())
+				{
+					++count;  // Makes the total wrong.
+				}
+			}
+		}));
+	}
+	for (JobHandle const &parent : parents)
+	{
+		parent.wait();
+	}
+	check(count == numParents * numChildren, "Nested jobs didn't all run exactly once");
+}
+
+/// A chain where each job depends on the previous one, plus a diamond of dependencies at the end of the chain.
+static void testChains()
+{
+	const unsigned length = 2000;
+	std::vector<unsigned> order;
+	JobHandle previous;
+	for (unsigned i = 0; i < length; ++i)
+	{
+		previous = jobSubmitAfter({previous}, [&order, i]() {
+			order.push_back(i);  // Only one job of the chain runs at a time, so no locking needed.
+		});
+	}
+
+	std::atomic<unsigned> left(0), right(0);
+	JobHandle leftJob = jobSubmitAfter({previous}, [&]() {
+		left = order.size();
+	});
+	JobHandle rightJob = jobSubmitAfter({previous, JobHandle()}, [&]() {
+		right = order.size();
+	});
+	bool bothDone = false;
+	JobHandle join = jobSubmitAfter({leftJob, rightJob}, [&]() {
+		bothDone = leftJob.finished() && rightJob.finished();
+	});
+	join.wait();
+
+	bool inOrder = order.size() == length;
+	for (unsigned i = 0; inOrder && i < length; ++i)
+	{
+		inOrder = order[i] == i;
+	}
+	check(inOrder, "Chained jobs didn't run in order");
+	check(left == length && right == length && bothDone, "Jobs ran before their dependencies finished");
+}
+
+/// Waits from threads which aren't workers, other than the main thread.
+static void testOutsideThreads()
+{
+	const unsigned numThreads = 4, numJobs = 500;
+	std::atomic<unsigned> count(0);
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t < numThreads; ++t)
+	{
+		threads.emplace_back([&count]() {
+			for (unsigned i = 0; i < numJobs; ++i)
+			{
+				JobFuture<unsigned> future = jobAsync([i]() {
+					return i * 2;
+				});
+				if (future.get() == i * 2)
+				{
+					++count;
+				}
+			}
+		});
+	}
+	for (std::thread &thread : threads)
+	{
+		thread.join();
+	}
+	check(count == numThreads * numJobs, "Waiting from other threads gave wrong results");
+}
+
+/// Parallel loops, including from inside jobs and with fewer calls than threads.
+static void testParallelFor()
+{
+	const unsigned counts[] = {0, 1, 2, 3, 1000, 100000};
+	for (unsigned count : counts)
+	{
+		std::unique_ptr<std::atomic<unsigned>[]> calls(new std::atomic<unsigned>[count + 1]);
+		for (unsigned i = 0; i < count; ++i)
+		{
+			calls[i] = 0;
+		}
+		jobParallelFor(count, [&calls](unsigned n) {
+			++calls[n];
+		});
+		bool once = true;
+		for (unsigned i = 0; i < count; ++i)
+		{
+			once = once && calls[i] == 1;
+		}
+		check(once, "jobParallelFor didn't call every index exactly once");
+	}
+
+	std::atomic<unsigned> total(0);
+	JobHandle outer = jobSubmit([&total]() {
+		jobParallelFor(5000, [&total](unsigned) {
+			++total;
+		});
+	});
+	outer.wait();
+	check(total == 5000, "jobParallelFor inside a job didn't call every index");
+}
+
+/// More jobs than the shared queue (JOB_QUEUE_SIZE) and a worker's deque (JOB_DEQUE_SIZE) hold, which then run inline.
+static void testOverflow()
+{
+	const unsigned numJobs = 20000;
+	std::atomic<unsigned> count(0);
+	std::vector<JobHandle> jobs;
+	for (unsigned i = 0; i < numJobs; ++i)
+	{
+		jobs.push_back(jobSubmit([&count]() {
+			++count;
+		}));
+	}
+	for (JobHandle const &job : jobs)
+	{
+		job.wait();
+	}
+	check(count == numJobs, "Overflowing the shared queue lost jobs");
+
+	count = 0;
+	JobHandle parent = jobSubmit([&count]() {
+		std::vector<JobHandle> children;
+		for (unsigned i = 0; i < numJobs; ++i)
+		{
+			children.push_back(jobSubmit([&count]() {
+				++count;
+			}));
+		}
+		for (JobHandle const &child : children)
+		{
+			child.wait();
+		}
+	});
+	parent.wait();
+	check(count == numJobs, "Overflowing a worker's deque lost jobs");
+}
+
+int main(void)
+{
+	// Before the workers start, jobs run immediately.
+	bool ran = false;
+	JobHandle early = jobSubmit([&ran]() {
+		ran = true;
+	});
+	check(ran && early.finished(), "Job submitted before jobSystemInitialise() didn't run immediately");
+
+	jobSystemInitialise();
+	for (unsigned round = 0; round < 20; ++round)
+	{
+		testNested();
+		testChains();
+		testOutsideThreads();
+		testParallelFor();
+		testOverflow();
+	}
+	jobSystemShutdown();
+
+	return failures == 0 ? 0 : 1;
+}
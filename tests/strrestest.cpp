@@ -0,0 +1,231 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*
+ * Checks the string resource tables against the shipped string files, and times them.
+ *
+ * Each directory of string files is loaded with strresLoad(), as the game does, and compared with a simple
+ * reading of the same files: every ID must give its text, every text must give the first ID stored for it,
+ * and identical texts must share one copy.
+ */
+
+#include "lib/framework/wzglobal.h"
+#include "lib/framework/types.h"
+#include "lib/framework/frame.h"
+#include "lib/framework/physfs_ext.h"
+#include "lib/framework/strres.h"
+#include "lib/framework/strresly.h"
+
+#include <ctype.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// --- linking hacks ---
+
+void wzFatalDialog(char const *)
+{
+}
+
+int wzGetTicks()
+{
+	return 1;
+}
+
+// --- end linking hacks ---
+
+typedef std::vector<std::pair<std::string, std::string>> StringList;
+
+/// Reads the IDs and texts of a string file in order, following the grammar of strres_lexer.lpp and strres_parser.ypp.
+static bool readStrings(const char *fileName, StringList &strings)
+{
+	PHYSFS_file *file = PHYSFS_openRead(fileName);
+	if (file == nullptr)
+	{
+		return false;
+	}
+	std::string data(PHYSFS_fileLength(file), '\0');
+	bool ok = data.empty() || WZ_PHYSFS_readBytes(file, &data[0], data.size()) == (PHYSFS_sint64)data.size();
+	PHYSFS_close(file);
+
+	std::string id;
+	size_t pos = 0;
+	while (ok && pos < data.size())
+	{
+		char c = data[pos];
+		if (data.compare(pos, 2, "/*") == 0)
+		{
+			size_t end = data.find("*/", pos + 2);
+			pos = end == std::string::npos ? data.size() : end + 2;
+		}
+		else if (data.compare(pos, 2, "//") == 0)
+		{
+			size_t end = data.find('\n', pos);
+			pos = end == std::string::npos ? data.size() : end + 1;
+		}
+		else if (c == '"')
+		{
+			size_t end = data.find('"', pos + 1);
+			ok = end != std::string::npos && !id.empty();
+			if (ok)
+			{
+				strings.push_back(std::make_pair(id, data.substr(pos + 1, end - pos - 1)));
+				id.clear();
+				pos = end + 1;
+			}
+		}
+		else if (id.empty() && isalpha((unsigned char)c))
+		{
+			size_t end = pos;
+			while (end < data.size() && (isalnum((unsigned char)data[end]) || data[end] == '-' || data[end] == '_'))
+			{
+				++end;
+			}
+			id = data.substr(pos, end - pos);
+			pos = end;
+		}
+		else
+		{
+			++pos;  // White space, or the _( ) around translated texts.
+		}
+	}
+	return ok && id.empty();
+}
+
+/// Loads the files of a directory, checks the lookups against strings, and returns the number of failed checks.
+static int testDirectory(const char *dir, std::vector<std::string> const &files, StringList const &strings)
+{
+	int failures = 0;
+	STR_RES *psRes = strresCreate();
+	for (std::string const &file : files)
+	{
+		if (!strresLoad(psRes, file.c_str()))
+		{
+			fprintf(stderr, "strrestest: Failed to load \"%s\"\n", file.c_str());
+			++failures;
+		}
+	}
+
+	std::map<std::string, std::string> firstIDs;
+	std::map<std::string, const char *> copies;
+	for (auto const &it : strings)
+	{
+		firstIDs.insert(std::make_pair(it.second, it.first));
+
+		const char *text = strresGetString(psRes, it.first.c_str());
+		if (text == nullptr || it.second != text)
+		{
+			fprintf(stderr, "strrestest: %s gives \"%s\" instead of \"%s\"\n", it.first.c_str(), text != nullptr ? text : "(null)", it.second.c_str());
+			++failures;
+			continue;
+		}
+		auto copy = copies.insert(std::make_pair(it.second, text)).first;
+		if (copy->second != text)
+		{
+			fprintf(stderr, "strrestest: \"%s\" is stored more than once\n", text);
+			++failures;
+		}
+	}
+	for (auto const &it : firstIDs)
+	{
+		const char *id = strresGetIDfromString(psRes, it.first.c_str());
+		if (id == nullptr || it.second != id)
+		{
+			fprintf(stderr, "strrestest: \"%s\" gives ID %s instead of %s\n", it.first.c_str(), id != nullptr ? id : "(null)", it.second.c_str());
+			++failures;
+		}
+	}
+	if (strresGetString(psRes, "strrestest-no-such-id") != nullptr || strresGetIDfromString(psRes, "strrestest: no such text") != nullptr)
+	{
+		fprintf(stderr, "strrestest: Found a string that was never stored\n");
+		++failures;
+	}
+	strresDestroy(psRes);
+
+	// Time storing and looking up everything, without the file parsing.
+	const int passes = 100;
+	auto start = std::chrono::steady_clock::now();
+	for (int pass = 0; pass < passes; ++pass)
+	{
+		psRes = strresCreate();
+		for (auto const &it : strings)
+		{
+			strresStoreString(psRes, it.first.c_str(), it.second.c_str());
+		}
+		for (auto const &it : strings)
+		{
+			strresGetString(psRes, it.first.c_str());
+			strresGetIDfromString(psRes, it.second.c_str());
+		}
+		strresDestroy(psRes);
+	}
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	printf("%s: %u strings, %u distinct texts, %.3f ms per store and lookup pass\n", dir, (unsigned)strings.size(), (unsigned)firstIDs.size(), time.count() / passes);
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	char datapath[PATH_MAX];
+	const char *srcdir = getenv("srcdir");
+
+	PHYSFS_init(argv[0]);
+	ssprintf(datapath, "%s/../data", srcdir != nullptr ? srcdir : ".");
+	if (!PHYSFS_mount(datapath, NULL, 1))
+	{
+		fprintf(stderr, "%s: Failed to mount \"%s\"\n", argv[0], datapath);
+		return -1;
+	}
+
+	int failures = 0;
+	const char *dirs[] = {"base/messages/strings", "mp/messages/strings"};
+	for (const char *dir : dirs)
+	{
+		std::vector<std::string> files;
+		StringList strings;
+		char **fileList = PHYSFS_enumerateFiles(dir);
+		for (char **i = fileList; *i != nullptr; ++i)
+		{
+			std::string file = std::string(dir) + "/" + *i;
+			if (file.size() < 4 || file.compare(file.size() - 4, 4, ".txt") != 0)
+			{
+				continue;
+			}
+			if (!readStrings(file.c_str(), strings))
+			{
+				fprintf(stderr, "%s: Failed to read \"%s\"\n", argv[0], file.c_str());
+				++failures;
+			}
+			files.push_back(file);
+		}
+		PHYSFS_freeList(fileList);
+		if (strings.empty())
+		{
+			fprintf(stderr, "%s: No strings found in \"%s\"\n", argv[0], dir);
+			++failures;
+			continue;
+		}
+		failures += testDirectory(dir, files, strings);
+	}
+
+	PHYSFS_deinit();
+	return failures == 0 ? 0 : 1;
+}
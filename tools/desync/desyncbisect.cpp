@@ -0,0 +1,269 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/*
+ * Finds where two clients' games went out of synch.
+ *
+ * Takes the state hash files written with --state-hashes by two clients (or by a client and a replay of the same
+ * game), and reports the first tick at which any subsystem differs, and which subsystems and players differ. Given
+ * the replay of the game (see lib/netplay/netreplay.cpp), it also lists the game messages read during that tick,
+ * since one of them, or something they triggered, is usually the culprit.
+ *
+ * The hash stream format is described in src/statehash.h.
+ *
+ * Build with: g++ -std=c++11 -O2 -o desyncbisect desyncbisect.cpp -lz
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+struct HashTick
+{
+	uint32_t gameTime;
+	std::vector<uint32_t> hashes;
+};
+
+struct HashFile
+{
+	std::string name;
+	uint32_t numSubsystems = 0;
+	uint32_t numPlayers = 0;
+	std::vector<std::string> subsystems;
+	std::vector<HashTick> ticks;
+};
+
+static uint32_t getUint32(uint8_t const *b)
+{
+	return uint32_t(b[0]) << 24 | uint32_t(b[1]) << 16 | uint32_t(b[2]) << 8 | uint32_t(b[3]);
+}
+
+static bool readFile(char const *filename, std::vector<uint8_t> &data)
+{
+	FILE *fp = fopen(filename, "rb");
+	if (fp == nullptr)
+	{
+		fprintf(stderr, "Could not open %s\n", filename);
+		return false;
+	}
+	uint8_t buf[65536];
+	size_t got;
+	while ((got = fread(buf, 1, sizeof(buf), fp)) > 0)
+	{
+		data.insert(data.end(), buf, buf + got);
+	}
+	fclose(fp);
+	return true;
+}
+
+static bool loadHashes(char const *filename, HashFile &file)
+{
+	std::vector<uint8_t> data;
+	if (!readFile(filename, data))
+	{
+		return false;
+	}
+	file.name = filename;
+	if (data.size() < 16 || memcmp(&data[0], "WZSH", 4) != 0 || getUint32(&data[4]) != 1)
+	{
+		fprintf(stderr, "%s is not a version 1 state hash file\n", filename);
+		return false;
+	}
+	file.numSubsystems = getUint32(&data[8]);
+	file.numPlayers = getUint32(&data[12]);
+	size_t pos = 16;
+	for (uint32_t i = 0; i < file.numSubsystems; ++i)
+	{
+		size_t end = pos;
+		while (end < data.size() && data[end] != '\0')
+		{
+			++end;
+		}
+		if (end >= data.size())
+		{
+			fprintf(stderr, "%s has a truncated header\n", filename);
+			return false;
+		}
+		file.subsystems.push_back(std::string(data.begin() + pos, data.begin() + end));
+		pos = end + 1;
+	}
+	size_t numHashes = file.numSubsystems * file.numPlayers;
+	size_t tickSize = 4 + numHashes * 4;
+	for (; pos + tickSize <= data.size(); pos += tickSize)
+	{
+		HashTick tick;
+		tick.gameTime = getUint32(&data[pos]);
+		for (size_t n = 0; n < numHashes; ++n)
+		{
+			tick.hashes.push_back(getUint32(&data[pos + 4 + n * 4]));
+		}
+		file.ticks.push_back(tick);
+	}
+	return true;
+}
+
+/// Prints the messages read from the game queues in the gameTime range (from, to].
+static bool printReplayMessages(char const *filename, uint32_t from, uint32_t to)
+{
+	std::vector<uint8_t> compressed;
+	if (!readFile(filename, compressed))
+	{
+		return false;
+	}
+	if (compressed.size() < 8 || memcmp(&compressed[0], "WZRP", 4) != 0 || getUint32(&compressed[4]) != 1)
+	{
+		fprintf(stderr, "%s is not a version 1 replay\n", filename);
+		return false;
+	}
+
+	z_stream zInflate;
+	memset(&zInflate, 0, sizeof(zInflate));
+	inflateInit(&zInflate);
+	zInflate.next_in = &compressed[8];
+	zInflate.avail_in = compressed.size() - 8;
+	std::vector<uint8_t> data;
+	int ret;
+	do
+	{
+		uint8_t out[65536];
+		zInflate.next_out = out;
+		zInflate.avail_out = sizeof(out);
+		ret = inflate(&zInflate, Z_NO_FLUSH);
+		data.insert(data.end(), out, out + (sizeof(out) - zInflate.avail_out));
+	}
+	while (ret == Z_OK);
+	inflateEnd(&zInflate);
+	if (ret != Z_STREAM_END)
+	{
+		fprintf(stderr, "Warning: %s is truncated or corrupt, using what could be read\n", filename);
+	}
+
+	size_t pos = 0;
+	if (data.size() < 4)
+	{
+		return false;
+	}
+	pos = 4 + getUint32(&data[0]);  // Skip the settings.
+	printf("Game messages read at gameTime %u-%u, from %s:\n", from + 1, to, filename);
+	unsigned count = 0;
+	while (pos + 5 <= data.size())
+	{
+		uint32_t time = getUint32(&data[pos]);
+		uint8_t player = data[pos + 4];
+		if (player == 0xFF || pos + 10 > data.size())
+		{
+			break;
+		}
+		uint8_t type = data[pos + 5];
+		uint32_t length = getUint32(&data[pos + 6]);
+		if (time > from && time <= to)
+		{
+			printf("  gameTime %u, player %u, message type %u, %u bytes\n", time, player, type, length);
+			++count;
+		}
+		if (time > to)
+		{
+			break;
+		}
+		pos += 10 + length;
+	}
+	printf("  %u messages\n", count);
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 3 && argc != 4)
+	{
+		printf("Usage: %s <state hashes A> <state hashes B> [replay]\n", argv[0]);
+		return -1;
+	}
+
+	HashFile a, b;
+	if (!loadHashes(argv[1], a) || !loadHashes(argv[2], b))
+	{
+		return -1;
+	}
+	if (a.numSubsystems != b.numSubsystems || a.numPlayers != b.numPlayers || a.subsystems != b.subsystems)
+	{
+		fprintf(stderr, "The files were written by different versions, and can't be compared\n");
+		return -1;
+	}
+
+	// The files may start and end at different ticks, so step through both by gameTime.
+	size_t ia = 0, ib = 0;
+	uint32_t lastGood = 0;
+	bool haveLastGood = false;
+	unsigned compared = 0;
+	while (ia < a.ticks.size() && ib < b.ticks.size())
+	{
+		HashTick const &ta = a.ticks[ia];
+		HashTick const &tb = b.ticks[ib];
+		if (ta.gameTime < tb.gameTime)
+		{
+			++ia;
+			continue;
+		}
+		if (tb.gameTime < ta.gameTime)
+		{
+			++ib;
+			continue;
+		}
+		++compared;
+		if (ta.hashes != tb.hashes)
+		{
+			printf("First difference at gameTime %u", ta.gameTime);
+			if (haveLastGood)
+			{
+				printf(", last matching gameTime %u", lastGood);
+			}
+			printf(".\n");
+			for (uint32_t s = 0; s < a.numSubsystems; ++s)
+			{
+				for (uint32_t p = 0; p < a.numPlayers; ++p)
+				{
+					size_t n = s * a.numPlayers + p;
+					if (ta.hashes[n] != tb.hashes[n])
+					{
+						printf("  %-12s player %2u: 0x%08X != 0x%08X\n", a.subsystems[s].c_str(), p, ta.hashes[n], tb.hashes[n]);
+					}
+				}
+			}
+			if (argc == 4)
+			{
+				printReplayMessages(argv[3], haveLastGood ? lastGood : ta.gameTime - 1, ta.gameTime);
+			}
+			return 1;
+		}
+		lastGood = ta.gameTime;
+		haveLastGood = true;
+		++ia;
+		++ib;
+	}
+
+	if (compared == 0)
+	{
+		printf("The files have no gameTime in common.\n");
+		return -1;
+	}
+	printf("No differences in %u common ticks, up to gameTime %u.\n", compared, lastGood);
+	return 0;
+}